@@ -0,0 +1,74 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <chrono>
+
+// Minimal host benchmark harness for the `native` environment.
+// Each BENCH_CASE runs against a freshly reset simulator; BenchStat
+// collects wall-clock cost per call (virtual time spent in delay() is
+// free, so only real work is measured).
+
+class BenchStat {
+public:
+    explicit BenchStat(const char *name);
+
+    void add(uint64_t ns);
+    // Record a batch of `calls` iterations timed together (min/max are per-call averages)
+    void addBatch(uint64_t ns, uint32_t calls);
+    void report() const;
+
+    const char *name() const { return statName; }
+    uint32_t count() const { return samples; }
+    double meanNs() const { return samples ? totalNs / samples : 0.0; }
+
+private:
+    const char *statName;
+    uint32_t samples;
+    double totalNs;
+    double minNs;
+    double maxNs;
+};
+
+// Time a single expression and add it to a stat
+#define BENCH_TIME(stat, expr)                                                   \
+    do {                                                                         \
+        auto benchStart_ = std::chrono::steady_clock::now();                     \
+        expr;                                                                    \
+        auto benchEnd_ = std::chrono::steady_clock::now();                       \
+        (stat).add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( \
+            benchEnd_ - benchStart_).count());                                   \
+    } while (0)
+
+typedef void (*BenchFunction)();
+
+struct BenchCase {
+    const char *name;
+    BenchFunction run;
+    BenchCase *next;
+
+    BenchCase(const char *caseName, BenchFunction fn);
+};
+
+#define BENCH_CASE(id, title)                        \
+    static void bench_##id();                        \
+    static BenchCase benchCase_##id(title, bench_##id); \
+    static void bench_##id()
+
+// Time a block of `calls` iterations as one batch
+#define BENCH_TIME_BATCH(stat, calls, expr)                                      \
+    do {                                                                         \
+        auto benchStart_ = std::chrono::steady_clock::now();                     \
+        expr;                                                                    \
+        auto benchEnd_ = std::chrono::steady_clock::now();                       \
+        (stat).addBatch((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( \
+            benchEnd_ - benchStart_).count(), (calls));                          \
+    } while (0)
+
+// Keeps the optimizer from discarding benchmarked results
+template <typename T>
+inline void benchKeep(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+#endif // BENCH_H
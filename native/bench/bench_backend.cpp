@@ -0,0 +1,74 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include "config.h"
+#include "led_backend.h"
+#include "bench.h"
+
+#ifdef LED_TYPE_FASTLED
+#include "fastled_facade.h"
+typedef FastLEDFacade BackendType;
+#elif defined(F5_BAM)
+#include "bam_facade.h"
+typedef BAMFacade BackendType;
+#elif defined(F5_DIRECT_PWM)
+#include "timer_pwm_facade.h"
+typedef TimerPWMFacade BackendType;
+#else
+#include "f5led_facade.h"
+typedef F5LEDFacade BackendType;
+#endif
+
+// One steady-state animation frame rendered through the static backend
+// interface and through ILEDFacade. Brightness alternates so every frame
+// commits output.
+
+static const uint32_t NUM_FRAMES = 20000;
+
+template <typename Backend>
+static void renderFrame(Backend &leds, uint8_t brightness) {
+    leds.setBrightness(brightness);
+    for (uint8_t i = 0; i < leds.getNumLEDs(); i++) {
+        leds.setLED(i, 255, i % 2 ? 180 : 0, 255);
+    }
+    leds.show();
+}
+
+// Same frame, but only the virtual interface is visible to the compiler
+static void __attribute__((noinline)) renderFrameVirtual(ILEDFacade &leds, uint8_t brightness) {
+    leds.setBrightness(brightness);
+    for (uint8_t i = 0; i < leds.getNumLEDs(); i++) {
+        leds.setLED(i, 255, i % 2 ? 180 : 0, 255);
+    }
+    leds.show();
+}
+
+BENCH_CASE(backend_dispatch, "LED backend: static vs virtual dispatch") {
+    BenchStat staticStat("frame: LEDBackend (static)");
+    BenchStat virtualStat("frame: ILEDFacade (virtual)");
+
+    BackendType backend;
+    backend.begin();
+    LEDFacadeAdapter<BackendType> adapter(backend);
+    ILEDFacade *facade = &adapter;
+    // Hide the dynamic type so the virtual calls are not devirtualized
+    asm volatile("" : "+r"(facade));
+
+    for (int round = 0; round < 5; round++) {
+        BENCH_TIME_BATCH(staticStat, NUM_FRAMES, {
+            for (uint32_t f = 0; f < NUM_FRAMES; f++) {
+                renderFrame(backend, 150 + (f & 1));
+            }
+        });
+        BENCH_TIME_BATCH(virtualStat, NUM_FRAMES, {
+            for (uint32_t f = 0; f < NUM_FRAMES; f++) {
+                renderFrameVirtual(*facade, 150 + (f & 1));
+            }
+        });
+    }
+
+    staticStat.report();
+    virtualStat.report();
+    printf("  frames committed: %lu, RAM: backend %u bytes, adapter +%u bytes\n",
+           (unsigned long)backend.getCommittedFrames(),
+           (unsigned)sizeof(BackendType), (unsigned)sizeof(LEDFacadeAdapter<BackendType>));
+}
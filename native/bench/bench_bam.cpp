@@ -0,0 +1,117 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "bench.h"
+#include "sim.h"
+
+#ifdef LED_TYPE_F5
+#include "bam_facade.h"
+
+// Bit-angle modulation on GPIO pins and on 74HC595 chains of growing
+// length. Each LED gets a different duty cycle; over 100 BAM cycles on
+// the virtual clock, every output's on-time must match duty / 255 to
+// within half a unit, or the case fails. Prints the estimated AVR ISR
+// cycles against the shortest bit, and the host cost per interrupt.
+
+static const uint32_t RUN_CYCLES = 100;
+
+static BenchStat *isrStat;
+
+template <typename Strip>
+static void timedService() {
+    BENCH_TIME(*isrStat, Strip::service());
+}
+
+static uint8_t dutyFor(uint8_t led) {
+    // 1, 38, 75, ... with 0 and 255 in the mix
+    if (led == 0) return 255;
+    if (led == 1) return 0;
+    return (uint8_t)(led * 37 + 1);
+}
+
+template <typename Strip>
+static bool runStrip(const char *label, bool shifted, BenchStat &stat) {
+    static const uint8_t pins[] = { BAM_PINS };
+    const uint8_t numLeds = Strip::getNumLEDs();
+
+    sim::reset();
+    Strip strip;
+    strip.begin();
+    isrStat = &stat;
+    sim::setTimer2Handler(timedService<Strip>);
+
+    strip.setBrightness(255);
+    for (uint8_t i = 0; i < numLeds; i++) {
+        uint8_t duty = dutyFor(i);
+        strip.setLED(i, duty, duty, duty);
+    }
+    strip.showNow();
+
+    // Let the frame swap in, then measure whole cycles
+    uint64_t cycleMicros = Strip::CYCLE_CYCLES / (F_CPU / 1000000UL);
+    sim::advanceMicros(2 * cycleMicros);
+
+    uint64_t before[128];
+    for (uint8_t i = 0; i < numLeds; i++) {
+        before[i] = shifted ? sim::shiftOutputHighMicros(i) : sim::pinHighMicros(pins[i]);
+    }
+    uint32_t matchesBefore = sim::timer2MatchCount();
+    sim::advanceMicros(RUN_CYCLES * cycleMicros);
+    uint32_t interrupts = sim::timer2MatchCount() - matchesBefore;
+
+    double worst = 0.0;
+    for (uint8_t i = 0; i < numLeds; i++) {
+        uint64_t high = (shifted ? sim::shiftOutputHighMicros(i) : sim::pinHighMicros(pins[i]))
+                        - before[i];
+        double units = 255.0 * high / (RUN_CYCLES * cycleMicros);
+        double error = fabs(units - dutyFor(i));
+        if (error > worst) worst = error;
+    }
+    sim::setTimer2Handler(nullptr);
+
+    double budget = 100.0 * Strip::ISR_CYCLES / Strip::SHORTEST_BIT_CYCLES;
+    uint32_t perCycle = interrupts / RUN_CYCLES;
+    double load = 100.0 * (Strip::PLANES * Strip::ISR_CYCLES +
+                           (perCycle - Strip::PLANES) * Strip::HOLD_ISR_CYCLES) /
+                  Strip::CYCLE_CYCLES;
+    printf("  %-14s %3u LEDs  %3lu Hz  %2u irq/cycle  ISR ~%3u cycles (%2.0f%% of %4u)"
+           "  load %.1f%%  duty error %.2f\n",
+           label, numLeds, (unsigned long)(1000000UL / cycleMicros), perCycle,
+           Strip::ISR_CYCLES, budget, Strip::SHORTEST_BIT_CYCLES, load, worst);
+    return worst <= 0.5;
+}
+
+BENCH_CASE(bam, "BAM backend: duty accuracy and ISR budget") {
+    BenchStat gpio4("irq: GPIO, 4 LEDs (host)");
+    BenchStat gpio15("irq: GPIO, 15 LEDs (host)");
+    BenchStat sr8("irq: 1 x 74HC595 (host)");
+    BenchStat sr32("irq: 4 x 74HC595 (host)");
+    BenchStat sr56("irq: 7 x 74HC595 (host)");
+    BenchStat sr64("irq: 8 x 74HC595 (host)");
+    BenchStat sr128("irq: 16 x 74HC595 (host)");
+
+    bool ok = true;
+    ok &= runStrip<BAMStrip<4, 0, BAM_UNIT_TICKS, PixelMono8> >("GPIO", false, gpio4);
+    ok &= runStrip<BAMStrip<15, 0, BAM_UNIT_TICKS, PixelMono8> >("GPIO", false, gpio15);
+    ok &= runStrip<BAMStrip<8, 1, BAM_UNIT_TICKS, PixelMono8> >("1 x 74HC595", true, sr8);
+    ok &= runStrip<BAMStrip<32, 4, BAM_UNIT_TICKS, PixelMono8> >("4 x 74HC595", true, sr32);
+    ok &= runStrip<BAMStrip<56, 7, BAM_UNIT_TICKS, PixelMono8> >("7 x 74HC595", true, sr56);
+    ok &= runStrip<BAMStrip<64, 8, 16, PixelMono8> >("8 x 74HC595", true, sr64);
+    ok &= runStrip<BAMStrip<128, 16, 16, PixelMono8> >("16 x 74HC595", true, sr128);
+
+    gpio4.report();
+    gpio15.report();
+    sr8.report();
+    sr32.report();
+    sr56.report();
+    sr64.report();
+    sr128.report();
+
+    if (!ok) {
+        fflush(stdout);
+        exit(1);
+    }
+}
+
+#endif
@@ -0,0 +1,95 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "color_math.h"
+#include "bench.h"
+
+// 8-bit color math against the expressions it replaced: the per-LED
+// divide by 255 in the F5 backends, and the map() / two-multiply
+// brightness lerps. Every input pair is swept. The case fails if scale
+// 255 or lerp t = 255 stops being exact, or if the saturating ops are
+// ever wrong. The host has a hardware divider, so the timings here
+// understate the gap on AVR, where each division is a library call.
+
+static uint8_t divideScale(uint8_t value, uint8_t scale) {
+    return (uint16_t)value * scale / 255;
+}
+
+static uint8_t mapLerp(uint8_t from, uint8_t to, uint8_t t) {
+    return map(t, 0, 255, from, to);
+}
+
+static uint8_t weightedLerp(uint8_t from, uint8_t to, uint8_t t) {
+    return ((uint16_t)from * (256 - t) + (uint16_t)to * t) >> 8;
+}
+
+BENCH_CASE(color_math, "Color math: divide / map() vs scale8 / lerp8") {
+    BenchStat divideStat("scale: value * s / 255");
+    BenchStat scaleStat("scale: colorScale8()");
+    BenchStat mapStat("lerp: map()");
+    BenchStat weightedStat("lerp: (a(256-t) + bt) >> 8");
+    BenchStat lerpStat("lerp: colorLerp8()");
+
+    int scaleError = 0, mapError = 0, weightedError = 0;
+    uint32_t scaleExact = 0;
+    bool ok = true;
+    for (uint16_t a = 0; a < 256; a++) {
+        for (uint16_t b = 0; b < 256; b++) {
+            int e = abs((int)divideScale(a, b) - (int)colorScale8(a, b));
+            if (e > scaleError) scaleError = e;
+            scaleExact += e == 0;
+
+            // Same endpoints at t = 0 and t = 255 as map()
+            ok = ok && colorLerp8(a, b, 0) == a && colorLerp8(a, b, 255) == b;
+            ok = ok && colorQadd8(a, b) == (a + b > 255 ? 255 : a + b);
+            ok = ok && colorQsub8(a, b) == (a > b ? a - b : 0);
+        }
+        ok = ok && colorScale8(a, 255) == a && colorScale8(a, 0) == 0;
+    }
+
+    // A fade between two brightness levels, every t
+    for (uint16_t t = 0; t < 256; t++) {
+        for (uint16_t from = 0; from < 256; from += 15) {
+            for (uint16_t to = 0; to < 256; to += 15) {
+                int lerp = colorLerp8(from, to, t);
+                int e = abs(mapLerp(from, to, t) - lerp);
+                if (e > mapError) mapError = e;
+                e = abs(weightedLerp(from, to, t) - lerp);
+                if (e > weightedError) weightedError = e;
+            }
+        }
+    }
+
+    // volatile input keeps the compiler from folding the sweep
+    volatile uint8_t offset = 0;
+    for (uint8_t pass = 0; pass < 20; pass++) {
+        uint32_t sum = 0;
+        BENCH_TIME_BATCH(divideStat, 65536,
+            for (uint32_t i = 0; i < 65536; i++) sum += divideScale(i + offset, i >> 8));
+        BENCH_TIME_BATCH(scaleStat, 65536,
+            for (uint32_t i = 0; i < 65536; i++) sum += colorScale8(i + offset, i >> 8));
+        BENCH_TIME_BATCH(mapStat, 65536,
+            for (uint32_t i = 0; i < 65536; i++) sum += mapLerp(BRIGHTNESS, offset, i >> 8));
+        BENCH_TIME_BATCH(weightedStat, 65536,
+            for (uint32_t i = 0; i < 65536; i++) sum += weightedLerp(BRIGHTNESS, offset, i >> 8));
+        BENCH_TIME_BATCH(lerpStat, 65536,
+            for (uint32_t i = 0; i < 65536; i++) sum += colorLerp8(BRIGHTNESS, offset, i >> 8));
+        benchKeep(sum);
+    }
+
+    divideStat.report();
+    scaleStat.report();
+    mapStat.report();
+    weightedStat.report();
+    lerpStat.report();
+    printf("  scale: %.1f%% of pairs identical to / 255, max deviation %d step\n",
+           scaleExact * 100.0 / 65536, scaleError);
+    printf("  lerp: max deviation %d from map(), %d from the weighted form;"
+           " endpoints %s\n", mapError, weightedError, ok ? "exact" : "WRONG");
+
+    if (!ok) {
+        fflush(stdout);
+        exit(1);
+    }
+}
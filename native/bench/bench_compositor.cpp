@@ -0,0 +1,206 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "animation.h"
+#include "compositor.h"
+#include "fastled_facade.h"
+#include "bench.h"
+#include "sim.h"
+
+// Layered compositing on a WS2812B strip. The case fails if any of these
+// does not hold:
+//   - The activation sequence alone on one layer gives, frame for frame,
+//     what AnimationEngine gives.
+//   - Re-triggering it mid-breathe crossfades. The first frame after the
+//     trigger may differ from the last one before by no more than one
+//     frame's share of CROSSFADE_MS (AnimationEngine cuts to black).
+//   - A lit fault overlay covers the layers below. In its off keyframe,
+//     the activation shows through unchanged.
+// Also times a frame of idle glow + activation + overlay on 60 LEDs,
+// without and with a crossfade running.
+
+enum { GLOW, ACTIVATION, STATUS };
+
+static const uint8_t CAPTURE_LEDS = 8;
+static const uint16_t MAX_FRAMES = 400;
+static const unsigned long FRAME_MS = 1000 / ANIMATION_FPS;
+static const unsigned long RETRIGGER_MS = 1500;
+
+typedef FastLEDStrip<CAPTURE_LEDS, 6, PixelRGB888> CaptureStrip;
+
+struct Capture {
+    uint8_t rgb[MAX_FRAMES][CAPTURE_LEDS * 3];
+    uint16_t frames;
+    uint16_t retriggerFrame;    // First frame after the re-trigger
+};
+
+// What the LEDs show after a render (unchanged frames are not resent).
+// Frames are rendered on a fixed time grid, since each refresh moves the
+// virtual clock on and the two runs send different numbers of refreshes.
+static void record(Capture &capture) {
+    memcpy(capture.rgb[capture.frames++], sim::lastFrame().rgb, sizeof(capture.rgb[0]));
+}
+
+// Activation through AnimationEngine; play() again at RETRIGGER_MS if asked
+static void captureEngine(Capture &capture, bool retrigger) {
+    sim::reset();
+    CaptureStrip leds;
+    AnimationEngine<CaptureStrip> engine(leds);
+    leds.begin();
+    unsigned long start = millis();
+    engine.play(ANIM_ACTIVATION, start);
+
+    capture.frames = 0;
+    capture.retriggerFrame = 0;
+    while (engine.isPlaying() && capture.frames < MAX_FRAMES) {
+        unsigned long now = start + capture.frames * FRAME_MS;
+        if (retrigger && !capture.retriggerFrame && now - start >= RETRIGGER_MS) {
+            engine.play(ANIM_ACTIVATION, now);
+            capture.retriggerFrame = capture.frames;
+        }
+        engine.render(now);
+        record(capture);
+    }
+}
+
+// The same through a one-layer Compositor
+static void captureCompositor(Capture &capture, bool retrigger) {
+    sim::reset();
+    CaptureStrip leds;
+    Compositor<CaptureStrip, 1, PixelRGB888> compositor(leds);
+    leds.begin();
+    unsigned long start = millis();
+    compositor.play(0, ANIM_ACTIVATION, start);
+
+    capture.frames = 0;
+    capture.retriggerFrame = 0;
+    while (compositor.isShowing() && capture.frames < MAX_FRAMES) {
+        unsigned long now = start + capture.frames * FRAME_MS;
+        if (retrigger && !capture.retriggerFrame && now - start >= RETRIGGER_MS) {
+            compositor.play(0, ANIM_ACTIVATION, now);
+            capture.retriggerFrame = capture.frames;
+        }
+        compositor.render(now);
+        record(capture);
+    }
+}
+
+static int frameDifference(const uint8_t *a, const uint8_t *b) {
+    int worst = 0;
+    for (uint8_t c = 0; c < CAPTURE_LEDS * 3; c++) {
+        int difference = abs((int)a[c] - (int)b[c]);
+        if (difference > worst) worst = difference;
+    }
+    return worst;
+}
+
+// Largest channel jump from the last frame before the re-trigger to the
+// first one after
+static int retriggerJump(const Capture &capture) {
+    uint16_t f = capture.retriggerFrame;
+    return frameDifference(capture.rgb[f - 1], capture.rgb[f]);
+}
+
+static Capture engineRun, compositorRun;
+
+// Overlay preemption: fault overlay over the activation on 8 LEDs
+static bool checkOverlay() {
+    sim::reset();
+    CaptureStrip leds;
+    Compositor<CaptureStrip, 3, PixelRGB888> compositor(leds);
+    leds.begin();
+    unsigned long start = millis();
+    compositor.play(ACTIVATION, ANIM_ACTIVATION, start);
+    sim::advanceMillis(1000);
+
+    // Past the crossfade into the overlay, inside its lit keyframe
+    // (keyframes are 200 ms: lit at 0-199, off at 200-399)
+    compositor.play(STATUS, ANIM_STATUS_FAULT, millis());
+    sim::advanceMillis(CROSSFADE_MS + 10);
+    compositor.render(millis());
+    sim::LedFrame lit = sim::lastFrame();
+    uint8_t faultColor[3] = { COLOR_FAULT };
+    bool covered = true;
+    for (uint8_t i = 0; i < CAPTURE_LEDS; i++) {
+        for (uint8_t c = 0; c < 3; c++) {
+            covered &= lit.rgb[i * 3 + c] == faultColor[c];
+        }
+    }
+
+    // Off keyframe: the activation below, as it would be alone
+    sim::advanceMillis(200);
+    unsigned long now = millis();
+    compositor.render(now);
+    sim::LedFrame off = sim::lastFrame();
+    AnimationTimeline alone;
+    alone.play(ANIM_ACTIVATION, start);
+    alone.advance(now, CAPTURE_LEDS);
+    uint8_t colors[2][3] = { { COLOR_PRIMARY }, { COLOR_SECONDARY } };
+    bool showsThrough = true;
+    for (uint8_t i = 0; i < CAPTURE_LEDS; i++) {
+        for (uint8_t c = 0; c < 3; c++) {
+            uint8_t expected =
+                alone.isLit(i) ? colorScale8(colors[i & 1][c], alone.brightness()) : 0;
+            showsThrough &= off.rgb[i * 3 + c] == expected;
+        }
+    }
+    printf("  fault overlay: lit keyframe covers all LEDs: %s, off keyframe shows the"
+           " activation: %s\n", covered ? "yes" : "NO", showsThrough ? "yes" : "NO");
+    return covered && showsThrough;
+}
+
+// One frame of three layers on 60 LEDs
+static void timeLayers() {
+    typedef FastLEDStrip<60, 6, PixelRGB888> Strip;
+    BenchStat steady("frame: 3 layers, 60 LEDs");
+    BenchStat fading("frame: 3 layers + crossfade");
+
+    sim::reset();
+    Strip leds;
+    Compositor<Strip, 3, PixelRGB888> compositor(leds);
+    leds.begin();
+    compositor.setLayer(STATUS, STATUS, BLEND_ADD, 128);
+    compositor.play(GLOW, ANIM_IDLE_GLOW, millis(), true);
+    compositor.play(STATUS, ANIM_STATUS_LOW_BATTERY, millis(), true);
+    compositor.play(ACTIVATION, ANIM_LED_TEST, millis(), true);
+
+    for (uint32_t frame = 0; frame < 3000; frame++) {
+        // Re-trigger every second; the crossfade covers the next frames
+        if (frame % ANIMATION_FPS == 0) {
+            compositor.play(ACTIVATION, ANIM_LED_TEST, millis(), true);
+        }
+        bool crossfading = frame % ANIMATION_FPS < CROSSFADE_MS / FRAME_MS;
+        BENCH_TIME(crossfading ? fading : steady, compositor.render(millis()));
+        sim::advanceMillis(FRAME_MS);
+    }
+    steady.report();
+    fading.report();
+}
+
+BENCH_CASE(compositor, "Layered compositor: equivalence, crossfade, overlay") {
+    captureEngine(engineRun, false);
+    captureCompositor(compositorRun, false);
+    bool same = engineRun.frames == compositorRun.frames;
+    for (uint16_t f = 0; same && f < engineRun.frames; f++) {
+        same = frameDifference(engineRun.rgb[f], compositorRun.rgb[f]) == 0;
+    }
+    printf("  activation alone, %u frames: compositor %s AnimationEngine\n",
+           compositorRun.frames, same ? "matches" : "DIFFERS FROM");
+
+    captureEngine(engineRun, true);
+    captureCompositor(compositorRun, true);
+    int cut = retriggerJump(engineRun);
+    int fade = retriggerJump(compositorRun);
+    int allowed = (int)(255 * FRAME_MS / CROSSFADE_MS) + 1;
+    printf("  re-trigger at %lu ms, worst channel jump: AnimationEngine %d,"
+           " compositor %d (allowed %d)\n", RETRIGGER_MS, cut, fade, allowed);
+
+    bool overlay = checkOverlay();
+    timeLayers();
+
+    if (!same || fade > allowed || !overlay) {
+        fflush(stdout);
+        exit(1);
+    }
+}
@@ -0,0 +1,155 @@
+#include <Arduino.h>
+#include <avr/io.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "event_queue.h"
+#include "task_scheduler.h"
+#include "bench.h"
+#include "sim.h"
+
+#if EVENT_LOOP
+#include "frame_clock.h"
+#include "motion_detector.h"
+#endif
+
+// ISR-to-main event queue. A Timer2 interrupt pushes a sequence number
+// every 100 us while the main loop pops in bursts with gaps of up to
+// 2.5 ms, long enough to overflow the 16-slot queue now and then. The
+// case fails if events come out of order or duplicated, or if pops plus
+// counted overflows don't add up to the pushes.
+//
+// With EVENT_LOOP, main_unified then runs for a minute with a hand raise
+// every 6 s: frames come from the Timer0 frame clock and, in FIFO mode,
+// the sensor task from the INT interrupt. Fails if a raise does not
+// activate or a frame is skipped.
+
+static const uint8_t QUEUE_SIZE = 16;
+static const uint32_t PUSHES = 50000;
+
+static EventQueue<uint32_t, QUEUE_SIZE> queue;
+static uint32_t pushed;
+static BenchStat *pushStat;
+
+static void producer() {
+    if (pushed < PUSHES) {
+        BENCH_TIME(*pushStat, queue.push(pushed));
+        pushed++;
+    }
+}
+
+static bool checkQueue() {
+    BenchStat pushTime("push() in the ISR");
+    BenchStat popTime("pop()");
+    pushStat = &pushTime;
+    pushed = 0;
+
+    sim::reset();
+    sim::setTimer2Handler(producer);
+    // CTC, prescaler 64 (4 us per tick), 25 ticks: every 100 us
+    OCR2A = 24;
+    TCCR2A = _BV(WGM21);
+    TCCR2B = _BV(CS22);
+    TIMSK2 = _BV(OCIE2A);
+
+    uint32_t popped = 0, dropped = 0, outOfOrder = 0;
+    uint32_t next = 0;
+    uint32_t gap = 0;
+    while (pushed < PUSHES || !queue.isEmpty()) {
+        uint32_t value;
+        bool got;
+        BENCH_TIME(popTime, got = queue.pop(value));
+        if (!got) {
+            // Burst over (overflow counts wrap at 256, so collect them
+            // often); the main loop goes off for a while (LCG gaps)
+            dropped += queue.takeOverflows();
+            gap = gap * 1103515245UL + 12345;
+            sim::advanceMicros(50 + (gap >> 16) % 2450);
+            continue;
+        }
+        // Drops leave gaps; anything at or below the last pop is reordered
+        // or duplicated
+        if (value < next) {
+            outOfOrder++;
+        }
+        next = value + 1;
+        popped++;
+    }
+    dropped += queue.takeOverflows();
+    TIMSK2 = 0;
+    sim::setTimer2Handler(nullptr);
+
+    pushTime.report();
+    popTime.report();
+    bool balanced = popped + dropped == PUSHES;
+    printf("  %lu pushed, %lu popped, %lu dropped on overflow (%s), %lu out of order\n",
+           (unsigned long)PUSHES, (unsigned long)popped, (unsigned long)dropped,
+           balanced ? "balanced" : "UNBALANCED", (unsigned long)outOfOrder);
+    return balanced && outOfOrder == 0;
+}
+
+#if EVENT_LOOP
+// Entry points and state from main_unified.cpp
+void setup();
+void loop();
+extern bool isActive;
+extern TaskScheduler scheduler;
+
+// Hand lies flat, raises to 70 degrees for a second every 6 seconds
+static sim::ImuState raiseCycle(uint64_t us, void *) {
+    uint32_t t = (uint32_t)((us / 1000) % 6000);
+    float pitch = 0.0f;
+    if (t >= 2000 && t < 2300) pitch = 70.0f * (t - 2000) / 300.0f;
+    else if (t >= 2300 && t < 3300) pitch = 70.0f;
+    else if (t >= 3300 && t < 3600) pitch = 70.0f * (3600 - t) / 300.0f;
+    return sim::handAtPitch(pitch);
+}
+
+static bool checkEventLoop() {
+    BenchStat loopStat("loop(), event loop");
+    sim::reset();
+    sim::setImuFeed(raiseCycle);
+    setup();
+
+    const uint64_t duration = 60ULL * 1000 * 1000;
+    uint32_t activations = 0;
+    bool wasActive = false;
+    uint32_t samplesBefore = sim::imuSamplesGenerated();
+    unsigned long runs[TaskScheduler::MAX_TASKS] = { 0 };
+    unsigned long lastRuns[TaskScheduler::MAX_TASKS] = { 0 };
+    while (sim::nowMicros() < duration) {
+        BENCH_TIME(loopStat, loop());
+        activations += isActive && !wasActive;
+        wasActive = isActive;
+        // Housekeeping resets the stats every second; sum them up first
+        for (uint8_t i = 0; i < scheduler.getNumTasks(); i++) {
+            unsigned long now = scheduler.getStats(i).runs;
+            runs[i] += now >= lastRuns[i] ? now - lastRuns[i] : now;
+            lastRuns[i] = now;
+        }
+    }
+    frameClock.end();
+    loopStat.report();
+
+    uint32_t samples = sim::imuSamplesGenerated() - samplesBefore;
+    uint32_t raises = (uint32_t)(duration / 6000000);
+    printf("  %lu frames posted, %lu skipped; %lu sensor runs for %lu samples;"
+           " %lu posts dropped; %lu/%lu raises activated\n",
+           frameClock.getFrames(), frameClock.getSkipped(), runs[0], (unsigned long)samples,
+           scheduler.getDroppedPosts(), (unsigned long)activations, (unsigned long)raises);
+    return activations == raises && frameClock.getSkipped() == 0;
+}
+#endif
+
+BENCH_CASE(events, "Event queue: ISR producer, main-loop consumer") {
+    bool ok = checkQueue();
+    #if EVENT_LOOP
+    ok &= checkEventLoop();
+    #else
+    printf("  (build with EVENT_LOOP=1 for the firmware run)\n");
+    #endif
+    if (!ok) {
+        fflush(stdout);
+        exit(1);
+    }
+}
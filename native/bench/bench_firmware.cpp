@@ -0,0 +1,119 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include "config.h"
+#include "motion_detector.h"
+#include "task_scheduler.h"
+#include "bench.h"
+#include "sim.h"
+
+#ifdef LED_TYPE_FASTLED
+#include "fastled_facade.h"
+typedef FastLEDFacade LEDFacadeType;
+#elif defined(F5_BAM)
+#include "bam_facade.h"
+typedef BAMFacade LEDFacadeType;
+#elif defined(F5_DIRECT_PWM)
+#include "timer_pwm_facade.h"
+typedef TimerPWMFacade LEDFacadeType;
+#else
+#include "f5led_facade.h"
+typedef F5LEDFacade LEDFacadeType;
+#endif
+
+// Entry points and state from main_unified.cpp
+void setup();
+void loop();
+void startAnimation();
+void updateAnimation();
+extern bool isActive;
+extern MotionDetector motionDetector;
+extern TaskScheduler scheduler;
+extern LEDFacadeType ledFacade;
+
+// Hand lies flat, raises to 70 degrees for a second every 6 seconds
+static sim::ImuState gestureCycle(uint64_t us, void *) {
+    uint32_t t = (uint32_t)((us / 1000) % 6000);
+    float pitch;
+    if (t < 2000) {
+        pitch = 0.0f;
+    } else if (t < 2300) {
+        pitch = 70.0f * (t - 2000) / 300.0f;
+    } else if (t < 3300) {
+        pitch = 70.0f;
+    } else if (t < 3600) {
+        pitch = 70.0f * (3600 - t) / 300.0f;
+    } else {
+        pitch = 0.0f;
+    }
+    return sim::handAtPitch(pitch);
+}
+
+BENCH_CASE(loop, "main_unified loop()") {
+    BenchStat loopStat("loop()");
+
+    sim::setImuFeed(gestureCycle);
+    setup();
+
+    // One minute of virtual time
+    scheduler.resetStats();
+    while (sim::nowMicros() < 60ULL * 1000 * 1000) {
+        BENCH_TIME(loopStat, loop());
+    }
+    loopStat.report();
+
+    // Virtual-time view of the schedule since the last housekeeping reset
+    for (uint8_t i = 0; i < scheduler.getNumTasks(); i++) {
+        const TaskStats &stats = scheduler.getStats(i);
+        printf("  task %u: runs=%lu overruns=%lu max lateness=%lu us\n", i, stats.runs,
+               stats.overruns, stats.maxLateness);
+    }
+}
+
+BENCH_CASE(hand_raised, "MotionDetector::isHandRaised()") {
+    BenchStat raisedStat("isHandRaised()");
+    uint32_t activations = 0;
+
+    sim::setImuFeed(gestureCycle);
+    motionDetector.begin();
+    uint32_t busBytesBefore = sim::i2cBytesTransferred();
+    uint32_t busTransactionsBefore = sim::i2cTransactions();
+
+    for (uint32_t i = 0; i < 3000; i++) {
+        bool raised;
+        BENCH_TIME(raisedStat, raised = motionDetector.isHandRaised());
+        if (raised) activations++;
+        sim::advanceMillis(20);
+    }
+    raisedStat.report();
+    printf("  activations: %u, I2C per call: %.1f bytes in %.2f transactions\n", activations,
+           (sim::i2cBytesTransferred() - busBytesBefore) / 3000.0,
+           (sim::i2cTransactions() - busTransactionsBefore) / 3000.0);
+}
+
+BENCH_CASE(animation, "updateAnimation() frames") {
+    BenchStat powerUp("frame: power-up");
+    BenchStat steady("frame: steady");
+    BenchStat fadeOut("frame: fade-out");
+
+    setup();
+    // The scheduler does not run here, so no protected task would ever
+    // open a refresh slot; every frame goes out as rendered
+    ledFacade.setRefreshScheduler(nullptr);
+
+    for (uint8_t run = 0; run < 20; run++) {
+        startAnimation();
+        uint32_t start = millis();
+
+        while (isActive) {
+            uint32_t t = millis() - start;
+            BenchStat &stat = t <= 500 ? powerUp : (t <= ACTIVE_DURATION ? steady : fadeOut);
+            BENCH_TIME(stat, updateAnimation());
+            sim::advanceMillis(1000 / ANIMATION_FPS);
+        }
+    }
+    powerUp.report();
+    steady.report();
+    fadeOut.report();
+    printf("  frames committed: %u, skipped as unchanged: %u\n",
+           ledFacade.getCommittedFrames(), ledFacade.getSkippedFrames());
+}
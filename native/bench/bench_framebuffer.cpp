@@ -0,0 +1,128 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "animation.h"
+#include "fastled_facade.h"
+#include "framebuffer.h"
+#include "bench.h"
+#include "sim.h"
+
+// Pixel formats for 60 LEDs: bytes held, cost of one frame of setLED()
+// and of widening it back to RGB at show(). Then the activation
+// animation plays on a WS2812B strip in each format; every frame that
+// goes out must match RGB888 exactly for the palette format (the
+// animation colors are palette entries) and to within the 5/6-bit step
+// for RGB565, or the case fails.
+
+static const uint8_t BENCH_LEDS = 60;
+static const uint32_t FRAMES = 2000;
+
+// Animation colors, with a ramp of dimmer reds that misses the palette
+static void colorAt(uint8_t i, uint32_t frame, uint8_t &r, uint8_t &g, uint8_t &b) {
+    switch ((i + frame) % 4) {
+        case 0: r = 0; g = 0; b = 0; break;
+        case 1: r = 255; g = 0; b = 0; break;
+        case 2: r = 255; g = 180; b = 0; break;
+        default: r = (uint8_t)(i * 4); g = 0; b = 0; break;
+    }
+}
+
+template <typename Format>
+static void timeFormat(const char *setName, const char *getName) {
+    BenchStat setStat(setName);
+    BenchStat getStat(getName);
+    FrameBuffer<Format, BENCH_LEDS> frame;
+    uint8_t r, g, b;
+
+    for (uint32_t f = 0; f < FRAMES; f++) {
+        BENCH_TIME_BATCH(setStat, BENCH_LEDS, {
+            for (uint8_t i = 0; i < BENCH_LEDS; i++) {
+                colorAt(i, f, r, g, b);
+                benchKeep(frame.set(i, r, g, b));
+            }
+        });
+        BENCH_TIME_BATCH(getStat, BENCH_LEDS, {
+            for (uint8_t i = 0; i < BENCH_LEDS; i++) {
+                frame.get(i, r, g, b);
+                benchKeep(r);
+                benchKeep(g);
+                benchKeep(b);
+            }
+        });
+    }
+    setStat.report();
+    getStat.report();
+}
+
+// Captured frames of the activation animation on an 8-LED strip
+struct AnimationCapture {
+    static const uint16_t MAX_FRAMES = 400;
+    uint8_t rgb[MAX_FRAMES][8 * 3];
+    uint16_t frames;
+};
+
+template <typename Format>
+static void captureAnimation(AnimationCapture &capture) {
+    sim::reset();
+    FastLEDStrip<8, 6, Format> leds;
+    AnimationEngine<FastLEDStrip<8, 6, Format> > engine(leds);
+    leds.begin();
+    engine.play(ANIM_ACTIVATION, millis());
+
+    capture.frames = 0;
+    uint32_t lastShow = sim::lastFrame().showCount;
+    while (engine.isPlaying() && capture.frames < AnimationCapture::MAX_FRAMES) {
+        engine.render(millis());
+        sim::LedFrame frame = sim::lastFrame();
+        if (frame.showCount != lastShow) {
+            lastShow = frame.showCount;
+            memcpy(capture.rgb[capture.frames++], frame.rgb, sizeof(capture.rgb[0]));
+        }
+        sim::advanceMillis(1000 / ANIMATION_FPS);
+    }
+}
+
+static int maxDifference(const AnimationCapture &a, const AnimationCapture &b) {
+    if (a.frames != b.frames) return 256;
+    int worst = 0;
+    for (uint16_t f = 0; f < a.frames; f++) {
+        for (uint8_t c = 0; c < sizeof(a.rgb[0]); c++) {
+            int difference = abs((int)a.rgb[f][c] - (int)b.rgb[f][c]);
+            if (difference > worst) worst = difference;
+        }
+    }
+    return worst;
+}
+
+static AnimationCapture rgb888Capture, rgb565Capture, paletteCapture;
+
+BENCH_CASE(framebuffer, "Framebuffer pixel formats") {
+    timeFormat<PixelMono8>("setLED: mono8", "to RGB: mono8");
+    timeFormat<PixelRGB565>("setLED: RGB565", "to RGB: RGB565");
+    timeFormat<PixelRGB888>("setLED: RGB888", "to RGB: RGB888");
+    timeFormat<PixelPalette4>("setLED: palette4", "to RGB: palette4");
+
+    printf("  pixel bytes     4 LEDs  15 LEDs  60 LEDs  120 LEDs\n");
+    printf("  mono8         %6u  %7u  %7u  %8u\n", PixelMono8::bytes(4), PixelMono8::bytes(15),
+           PixelMono8::bytes(60), PixelMono8::bytes(120));
+    printf("  RGB565        %6u  %7u  %7u  %8u\n", PixelRGB565::bytes(4), PixelRGB565::bytes(15),
+           PixelRGB565::bytes(60), PixelRGB565::bytes(120));
+    printf("  RGB888        %6u  %7u  %7u  %8u\n", PixelRGB888::bytes(4), PixelRGB888::bytes(15),
+           PixelRGB888::bytes(60), PixelRGB888::bytes(120));
+    printf("  palette4      %6u  %7u  %7u  %8u\n", PixelPalette4::bytes(4),
+           PixelPalette4::bytes(15), PixelPalette4::bytes(60), PixelPalette4::bytes(120));
+
+    captureAnimation<PixelRGB888>(rgb888Capture);
+    captureAnimation<PixelRGB565>(rgb565Capture);
+    captureAnimation<PixelPalette4>(paletteCapture);
+    int rgb565Error = maxDifference(rgb888Capture, rgb565Capture);
+    int paletteError = maxDifference(rgb888Capture, paletteCapture);
+    printf("  activation animation, %u frames: worst channel error vs RGB888: RGB565 %d,"
+           " palette4 %d\n", rgb888Capture.frames, rgb565Error, paletteError);
+
+    if (rgb565Error > 7 || paletteError != 0) {
+        fflush(stdout);
+        exit(1);
+    }
+}
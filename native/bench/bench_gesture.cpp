@@ -0,0 +1,244 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "gesture_recognizer.h"
+#include "bench.h"
+#include "sim.h"
+
+// Gesture engine accuracy and per-sample cost. Each gesture is replayed
+// from a float motion model at SAMPLE_RATE with varied speed, amplitude,
+// sensor noise and sample phase, framed by a second of stillness. Idle
+// poses, slow wandering and the hand-raise cycle check for false fires.
+
+static const float GESTURE_MS = 1000.0f * GESTURE_LENGTH * GESTURE_DECIMATION / SAMPLE_RATE;
+
+// Deterministic noise, roughly uniform in [-1, 1]
+static uint32_t noiseState = 1;
+static float noise() {
+    noiseState = noiseState * 1664525UL + 1013904223UL;
+    return (float)(int32_t)noiseState / 2147483648.0f;
+}
+
+static int16_t toCounts(float value, float perUnit) {
+    float counts = value * perUnit;
+    if (counts > 32767.0f) return 32767;
+    if (counts < -32768.0f) return -32768;
+    return (int16_t)lroundf(counts);
+}
+
+// Physical state -> raw counts at +/-2 g, +/-250 deg/s, with sensor noise
+static MotionSample toSample(const sim::ImuState &s, float noiseLevel) {
+    MotionSample m;
+    m.ax = toCounts(s.ax + 0.03f * noiseLevel * noise(), 16384.0f);
+    m.ay = toCounts(s.ay + 0.03f * noiseLevel * noise(), 16384.0f);
+    m.az = toCounts(s.az + 0.03f * noiseLevel * noise(), 16384.0f);
+    m.gx = toCounts(s.gx + 3.0f * noiseLevel * noise(), 131.0f);
+    m.gy = toCounts(s.gy + 3.0f * noiseLevel * noise(), 131.0f);
+    m.gz = toCounts(s.gz + 3.0f * noiseLevel * noise(), 131.0f);
+    return m;
+}
+
+// Same models as the templates in gesture_recognizer.cpp, in float.
+// u runs 0 -> 1 over `seconds`; `amplitude` scales the motion.
+static sim::ImuState gestureState(uint8_t gesture, float u, float seconds, float amplitude) {
+    sim::ImuState s = {};
+    if (u < 0.0f) u = 0.0f;
+    if (u > 1.0f) u = 1.0f;
+
+    switch (gesture) {
+        case GESTURE_PALM_UP: {
+            float angle = (float)PI * amplitude;
+            float roll = angle * (0.5f - 0.5f * cosf((float)PI * u));
+            s.ay = sinf(roll);
+            s.az = cosf(roll);
+            s.gx = angle * (float)RAD_TO_DEG * 0.5f * (float)PI * sinf((float)PI * u) / seconds;
+            break;
+        }
+        case GESTURE_REPULSOR_THRUST: {
+            // Same push made faster needs proportionally more acceleration
+            float pace = GESTURE_MS / 1000.0f / seconds;
+            s.ax = -1.0f;
+            s.az = 1.5f * amplitude * pace * pace * sinf(2.0f * (float)PI * u);
+            break;
+        }
+        case GESTURE_WRIST_FLICK: {
+            float peak = 40.0f * amplitude;
+            float pitch = (peak / 2.0f) * (1.0f - cosf(2.0f * (float)PI * u)) * (float)DEG_TO_RAD;
+            s.ax = -sinf(pitch);
+            s.az = cosf(pitch);
+            s.gy = peak * (float)PI * sinf(2.0f * (float)PI * u) / seconds;
+            break;
+        }
+    }
+    return s;
+}
+
+struct Trial {
+    float speed;
+    float amplitude;
+};
+
+static const Trial TRIALS[] = {
+    { 1.00f, 1.0f }, { 0.80f, 1.0f }, { 0.90f, 1.0f }, { 1.10f, 1.0f }, { 1.25f, 1.0f },
+    { 1.00f, 0.8f }, { 1.00f, 1.2f }, { 0.85f, 0.9f }, { 1.15f, 1.1f },
+};
+static const uint8_t NUM_TRIALS = sizeof(TRIALS) / sizeof(TRIALS[0]);
+
+static BenchStat *sampleStat = nullptr;
+
+// Feed `ms` of samples from `state(t)`; returns the gestures fired
+static uint8_t feed(GestureRecognizer &recognizer, float ms, float phaseMs,
+                    sim::ImuState (*state)(float t, void *context), void *context,
+                    uint8_t *fired, uint8_t maxFired, uint8_t *confidence = nullptr) {
+    const float periodMs = 1000.0f / SAMPLE_RATE;
+    uint8_t count = 0;
+    for (float t = phaseMs; t < ms; t += periodMs) {
+        MotionSample sample = toSample(state(t, context), 1.0f);
+        GestureResult result;
+        bool hit;
+        BENCH_TIME(*sampleStat, hit = recognizer.addSample(sample, result));
+        if (hit && count < maxFired) {
+            if (confidence) confidence[count] = result.confidence;
+            fired[count++] = result.gesture;
+        }
+    }
+    return count;
+}
+
+struct GestureRun {
+    uint8_t gesture;
+    float seconds;
+    float amplitude;
+};
+
+// One second still, the gesture, one second still
+static sim::ImuState gestureRunState(float t, void *context) {
+    const GestureRun &run = *(const GestureRun *)context;
+    return gestureState(run.gesture, (t - 1000.0f) / (1000.0f * run.seconds), run.seconds, run.amplitude);
+}
+
+// Still hand at the pose and drift given by context[0..1] (pitch, roll deg)
+static sim::ImuState idleState(float t, void *context) {
+    const float *pose = (const float *)context;
+    float pitch = (pose[0] + 5.0f * sinf(t / 900.0f)) * (float)DEG_TO_RAD;
+    float roll = (pose[1] + 5.0f * sinf(t / 1300.0f)) * (float)DEG_TO_RAD;
+    sim::ImuState s = {};
+    s.ax = -sinf(pitch);
+    s.ay = cosf(pitch) * sinf(roll);
+    s.az = cosf(pitch) * cosf(roll);
+    s.gy = 5.0f * (float)RAD_TO_DEG / 900.0f * cosf(t / 900.0f);
+    s.gx = 5.0f * (float)RAD_TO_DEG / 1300.0f * cosf(t / 1300.0f);
+    return s;
+}
+
+// Hand raised to 70 degrees over 300 ms, held, lowered - the tilt trigger
+static sim::ImuState handRaiseState(float t, void *) {
+    uint32_t ms = (uint32_t)t % 4000;
+    float pitch;
+    float rate;
+    if (ms < 1000) {
+        pitch = 0.0f; rate = 0.0f;
+    } else if (ms < 1300) {
+        pitch = 70.0f * (ms - 1000) / 300.0f; rate = 70.0f / 0.3f;
+    } else if (ms < 2300) {
+        pitch = 70.0f; rate = 0.0f;
+    } else if (ms < 2600) {
+        pitch = 70.0f * (2600 - ms) / 300.0f; rate = -70.0f / 0.3f;
+    } else {
+        pitch = 0.0f; rate = 0.0f;
+    }
+    sim::ImuState s = sim::handAtPitch(pitch);
+    s.gy = rate;
+    return s;
+}
+
+BENCH_CASE(gesture, "Gesture recognition: banded DTW over the frame window") {
+    BenchStat stat("addSample()");
+    sampleStat = &stat;
+    noiseState = 1;
+
+    uint16_t hits[NUM_GESTURES] = {};
+    uint16_t confused[NUM_GESTURES] = {};
+    uint16_t missed[NUM_GESTURES] = {};
+    uint32_t confidenceSum[NUM_GESTURES] = {};
+    uint16_t runs = 0;
+
+    for (uint8_t g = GESTURE_NONE + 1; g < NUM_GESTURES; g++) {
+        for (uint8_t t = 0; t < NUM_TRIALS; t++) {
+            for (uint8_t phase = 0; phase < 4; phase++) {
+                GestureRecognizer recognizer;
+                GestureRun run = { g, GESTURE_MS / 1000.0f / TRIALS[t].speed, TRIALS[t].amplitude };
+                uint8_t fired[4];
+                uint8_t confidence[4];
+                uint8_t n = feed(recognizer, 2000.0f + 1000.0f * run.seconds, phase * 5.0f,
+                                 gestureRunState, &run, fired, 4, confidence);
+                runs++;
+
+                bool found = false;
+                for (uint8_t i = 0; i < n; i++) {
+                    if (fired[i] == g) {
+                        found = true;
+                        confidenceSum[g] += confidence[i];
+                    } else {
+                        confused[g]++;
+                    }
+                }
+                if (found) {
+                    hits[g]++;
+                } else {
+                    missed[g]++;
+                }
+            }
+        }
+    }
+
+    // Negatives: ten seconds in each still pose, plus the hand-raise cycle
+    static const float POSES[][2] = {
+        { 0.0f, 0.0f }, { 45.0f, 0.0f }, { 90.0f, 0.0f }, { 0.0f, 180.0f }, { -30.0f, 60.0f },
+    };
+    uint16_t falseFires = 0;
+    float negativeSeconds = 0.0f;
+    uint8_t fired[32];
+    for (uint8_t p = 0; p < sizeof(POSES) / sizeof(POSES[0]); p++) {
+        GestureRecognizer recognizer;
+        falseFires += feed(recognizer, 10000.0f, 0.0f, idleState, (void *)POSES[p], fired, 32);
+        negativeSeconds += 10.0f;
+    }
+    {
+        GestureRecognizer recognizer;
+        falseFires += feed(recognizer, 40000.0f, 0.0f, handRaiseState, nullptr, fired, 32);
+        negativeSeconds += 40.0f;
+    }
+
+    // Matching cost per template with the window just short of a flick
+    BenchStat matchStat("matchCost() per template");
+    {
+        GestureRecognizer recognizer;
+        GestureRun run = { GESTURE_WRIST_FLICK, GESTURE_MS / 1000.0f, 1.0f };
+        uint8_t unused[1];
+        feed(recognizer, 1000.0f + GESTURE_MS * 0.95f, 0.0f, gestureRunState, &run, unused, 1);
+        uint32_t sink = 0;
+        BENCH_TIME_BATCH(matchStat, 30000, {
+            for (uint16_t i = 0; i < 10000; i++) {
+                for (uint8_t g = GESTURE_NONE + 1; g < NUM_GESTURES; g++) {
+                    sink += recognizer.matchCost(g);
+                }
+            }
+        });
+        benchKeep(sink);
+    }
+
+    stat.report();
+    matchStat.report();
+    for (uint8_t g = GESTURE_NONE + 1; g < NUM_GESTURES; g++) {
+        printf("  %-16s detected %2u/%u  missed %u  misfired %u  mean confidence %u\n",
+               GestureRecognizer::name(g), hits[g], runs / (NUM_GESTURES - 1), missed[g],
+               confused[g], hits[g] ? (unsigned)(confidenceSum[g] / hits[g]) : 0);
+    }
+    printf("  false fires: %u in %.0f s of idle poses and hand raises\n", falseFires,
+           negativeSeconds);
+    printf("  SRAM: %u bytes of state + %u bytes of DTW rows on the stack\n",
+           (unsigned)sizeof(GestureRecognizer), (unsigned)(2 * GESTURE_LENGTH * sizeof(uint16_t)));
+    sampleStat = nullptr;
+}
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#include "bench.h"
+#include "sim.h"
+
+// Registered cases, in link order
+static BenchCase *firstCase = nullptr;
+static BenchCase *lastCase = nullptr;
+
+BenchCase::BenchCase(const char *caseName, BenchFunction fn)
+    : name(caseName), run(fn), next(nullptr) {
+    if (lastCase) {
+        lastCase->next = this;
+    } else {
+        firstCase = this;
+    }
+    lastCase = this;
+}
+
+BenchStat::BenchStat(const char *name)
+    : statName(name), samples(0), totalNs(0), minNs(0), maxNs(0) {
+}
+
+void BenchStat::add(uint64_t ns) {
+    addBatch(ns, 1);
+}
+
+void BenchStat::addBatch(uint64_t ns, uint32_t calls) {
+    if (calls == 0) return;
+    double perCall = (double)ns / calls;
+    if (samples == 0 || perCall < minNs) minNs = perCall;
+    if (samples == 0 || perCall > maxNs) maxNs = perCall;
+    samples += calls;
+    totalNs += (double)ns;
+}
+
+void BenchStat::report() const {
+    if (samples == 0) {
+        printf("  %-32s %10s\n", statName, "no samples");
+        return;
+    }
+    printf("  %-32s %10u %12.1f %10.1f %10.1f\n", statName, samples, meanNs(), minNs, maxNs);
+}
+
+// Usage: program [case-name-substring]
+int main(int argc, char **argv) {
+    const char *filter = argc > 1 ? argv[1] : nullptr;
+    int failures = 0;
+
+    for (BenchCase *c = firstCase; c; c = c->next) {
+        if (filter && !strstr(c->name, filter)) continue;
+
+        printf("\n== %s ==\n", c->name);
+        printf("  %-32s %10s %12s %10s %10s\n", "section", "calls", "mean ns", "min ns", "max ns");
+        fflush(stdout);
+
+#ifndef _WIN32
+        // Firmware globals (scheduler tables, animation state) can't be
+        // re-initialised in-process, so each case runs in its own child
+        pid_t pid = fork();
+        if (pid == 0) {
+            sim::reset();
+            c->run();
+            fflush(stdout);
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            printf("  case failed\n");
+            failures++;
+        }
+#else
+        sim::reset();
+        c->run();
+#endif
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,206 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "motion_detector.h"
+#include "orientation_filter.h"
+#include "bench.h"
+
+// Fused orientation accuracy against known motion. Each trace is
+// sampled at SAMPLE_RATE with sensor noise and a gyro bias; pitch from
+// the complementary filter and from raw accelerometer tilt are both
+// compared with the true pitch. Thrust phases add linear acceleration,
+// which the accelerometer alone reads as tilt.
+//
+// Doubles as the accuracy test: the case fails (and the bench exits
+// non-zero) if the fused pitch leaves the error budget below or crosses
+// ACTIVATION_ANGLE a different number of times than the true pitch.
+
+static const float MAX_FUSED_RMS_DEG = 3.0f;
+static const float MAX_FUSED_ERROR_DEG = 6.0f;
+
+static const float BIAS_DPS = 1.0f;
+
+// Deterministic noise, roughly uniform in [-1, 1]
+static uint32_t noiseState = 1;
+static float noise() {
+    noiseState = noiseState * 1664525UL + 1013904223UL;
+    return (float)(int32_t)noiseState / 2147483648.0f;
+}
+
+static int16_t toCounts(float value, float perUnit) {
+    float counts = value * perUnit;
+    if (counts > 32767.0f) return 32767;
+    if (counts < -32768.0f) return -32768;
+    return (int16_t)lroundf(counts);
+}
+
+// True pose and rates (degrees, deg/s) plus body-frame linear accel (g)
+struct Pose {
+    float pitch, roll;
+    float pitchRate, rollRate;
+    float linX, linY, linZ;
+};
+
+// ZYX Euler angles, no yaw: gravity and body rates for a pose
+static MotionSample toSample(const Pose &p) {
+    float th = p.pitch * (float)DEG_TO_RAD;
+    float ph = p.roll * (float)DEG_TO_RAD;
+    MotionSample m;
+    m.ax = toCounts(-sinf(th) + p.linX + 0.02f * noise(), 16384.0f);
+    m.ay = toCounts(cosf(th) * sinf(ph) + p.linY + 0.02f * noise(), 16384.0f);
+    m.az = toCounts(cosf(th) * cosf(ph) + p.linZ + 0.02f * noise(), 16384.0f);
+    m.gx = toCounts(p.rollRate + BIAS_DPS + 2.0f * noise(), 131.0f);
+    m.gy = toCounts(p.pitchRate * cosf(ph) + BIAS_DPS + 2.0f * noise(), 131.0f);
+    m.gz = toCounts(-p.pitchRate * sinf(ph) - BIAS_DPS + 2.0f * noise(), 131.0f);
+    return m;
+}
+
+// Smooth move from a to b over [t0, t0 + d] seconds
+static void ramp(float t, float t0, float d, float a, float b, float &angle, float &rate) {
+    if (t <= t0) { angle = a; rate = 0.0f; return; }
+    if (t >= t0 + d) { angle = b; rate = 0.0f; return; }
+    float u = (t - t0) / d;
+    angle = a + (b - a) * (0.5f - 0.5f * cosf((float)PI * u));
+    rate = (b - a) * 0.5f * (float)PI * sinf((float)PI * u) / d;
+}
+
+// Raise to 70 degrees in 500 ms while swinging the arm, hold with a
+// repulsor thrust, lower again (peak rates stay inside +/-250 deg/s)
+static Pose raiseWithThrust(float t) {
+    Pose p = {};
+    float lower, lowerRate;
+    ramp(t, 1.0f, 0.5f, 0.0f, 70.0f, p.pitch, p.pitchRate);
+    ramp(t, 3.0f, 0.5f, 0.0f, -70.0f, lower, lowerRate);
+    p.pitch += lower;
+    p.pitchRate += lowerRate;
+    // Arm swing while raising, thrust along the palm while held
+    if (t > 1.0f && t < 1.5f) p.linX = -0.6f * sinf((float)PI * (t - 1.0f) / 0.5f);
+    if (t > 2.0f && t < 2.4f) p.linZ = 1.2f * sinf(2.0f * (float)PI * (t - 2.0f) / 0.4f);
+    return p;
+}
+
+// Slow nods with the hand rolled 30 degrees
+static Pose rolledNods(float t) {
+    Pose p = {};
+    p.roll = 30.0f;
+    p.pitch = 35.0f * sinf(2.0f * (float)PI * t / 2.5f);
+    p.pitchRate = 35.0f * 2.0f * (float)PI / 2.5f * cosf(2.0f * (float)PI * t / 2.5f);
+    return p;
+}
+
+// Walking: still pitch, 0.3 g vertical bounce at 2 Hz
+static Pose walking(float t) {
+    Pose p = {};
+    p.pitch = 20.0f;
+    float bounce = 0.3f * sinf(2.0f * (float)PI * 2.0f * t);
+    p.linX = -bounce * sinf(20.0f * (float)DEG_TO_RAD);
+    p.linZ = bounce * cosf(20.0f * (float)DEG_TO_RAD);
+    return p;
+}
+
+struct Trace {
+    const char *name;
+    Pose (*pose)(float t);
+    float seconds;
+};
+
+static const Trace TRACES[] = {
+    { "raise + thrust", raiseWithThrust, 4.5f },
+    { "rolled nods", rolledNods, 10.0f },
+    { "walking", walking, 10.0f },
+};
+
+static float wrapDegrees(float d) {
+    while (d > 180.0f) d -= 360.0f;
+    while (d < -180.0f) d += 360.0f;
+    return d;
+}
+
+BENCH_CASE(orientation, "Orientation: complementary filter vs accel tilt") {
+    BenchStat updateStat("OrientationFilter::update()");
+    BenchStat floatStat("float calculatePitch()");
+    noiseState = 1;
+
+    // atan2Fixed over a full turn
+    float worstAtan = 0.0f;
+    for (int i = 0; i < 3600; i++) {
+        float a = i * 0.1f * (float)DEG_TO_RAD;
+        int32_t y = lroundf(2000.0f * sinf(a));
+        int32_t x = lroundf(2000.0f * cosf(a));
+        float fixedDeg = OrientationFilter::atan2Fixed(y, x) / (float)ORIENTATION_UNITS_PER_DEG;
+        float err = fabsf(wrapDegrees(fixedDeg - atan2f((float)y, (float)x) * (float)RAD_TO_DEG));
+        if (err > worstAtan) worstAtan = err;
+    }
+
+    const float periodS = 1.0f / SAMPLE_RATE;
+    const uint8_t numTraces = sizeof(TRACES) / sizeof(TRACES[0]);
+    char lines[numTraces][160];
+    const float threshold = ACTIVATION_ANGLE;
+    bool passed = true;
+
+    for (uint8_t n = 0; n < numTraces; n++) {
+        const Trace &trace = TRACES[n];
+        OrientationFilter filter;
+        double accelSq = 0.0, fusedSq = 0.0;
+        float accelMax = 0.0f, fusedMax = 0.0f;
+        uint32_t samples = 0;
+        uint16_t truthEdges = 0, accelEdges = 0, fusedEdges = 0;
+        bool truthAbove = false, accelAbove = false, fusedAbove = false;
+
+        for (float t = 0.0f; t < trace.seconds; t += periodS) {
+            Pose pose = trace.pose(t);
+            MotionSample s = toSample(pose);
+
+            BENCH_TIME(updateStat, filter.update(s, (unsigned long)(t * 1e6f)));
+            float accelPitch;
+            BENCH_TIME(floatStat, accelPitch = MotionDetector::calculatePitch(s.ax, s.ay, s.az));
+            float fusedPitch = filter.pitch() / (float)ORIENTATION_UNITS_PER_DEG;
+
+            // Skip the first second while the filter settles on the bias
+            if (t >= 1.0f - periodS / 2) {
+                float accelErr = fabsf(accelPitch - pose.pitch);
+                float fusedErr = fabsf(wrapDegrees(fusedPitch - pose.pitch));
+                accelSq += accelErr * accelErr;
+                fusedSq += fusedErr * fusedErr;
+                if (accelErr > accelMax) accelMax = accelErr;
+                if (fusedErr > fusedMax) fusedMax = fusedErr;
+                samples++;
+            }
+
+            // Rising crossings of the activation angle
+            truthEdges += !truthAbove && pose.pitch > threshold;
+            accelEdges += !accelAbove && accelPitch > threshold;
+            fusedEdges += !fusedAbove && fusedPitch > threshold;
+            truthAbove = pose.pitch > threshold;
+            accelAbove = accelPitch > threshold;
+            fusedAbove = fusedPitch > threshold;
+        }
+
+        float accelRms = sqrt(accelSq / samples);
+        float fusedRms = sqrt(fusedSq / samples);
+        bool ok = fusedRms <= MAX_FUSED_RMS_DEG && fusedMax <= MAX_FUSED_ERROR_DEG &&
+                  fusedEdges == truthEdges;
+        passed = passed && ok;
+
+        snprintf(lines[n], sizeof(lines[n]),
+                 "  %-15s accel rms %5.2f max %5.2f | fused rms %5.2f max %5.2f deg"
+                 " | crossings %u/%u/%u%s\n",
+                 trace.name, accelRms, accelMax, fusedRms, fusedMax, truthEdges, accelEdges,
+                 fusedEdges, ok ? "" : "  FAIL");
+    }
+
+    updateStat.report();
+    floatStat.report();
+    for (uint8_t n = 0; n < numTraces; n++) {
+        printf("%s", lines[n]);
+    }
+    printf("  (crossings of ACTIVATION_ANGLE: truth/accel/fused)\n");
+    printf("  atan2Fixed() worst error %.3f deg, filter state %u bytes\n", worstAtan,
+           (unsigned)sizeof(OrientationFilter));
+
+    if (!passed) {
+        fflush(stdout);
+        exit(1);
+    }
+}
@@ -0,0 +1,150 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "motion_detector.h"
+#include "mpu6050_driver.h"
+#include "power.h"
+#include "bench.h"
+#include "sim.h"
+
+// Wake-on-motion power-down. First, the driver alone at every wake-up
+// rate: motion onset to CPU wake, and wake to the first full-rate sample.
+// Then, with LOW_POWER_MODE, main_unified runs through long idle
+// stretches with an occasional hand raise. Every raise must still
+// activate, or the case fails.
+//
+// Supply estimates use datasheet typicals for the MCU and MPU6050 only
+// (no LEDs, regulator or USB bridge). Awake: ATmega328P at 16 MHz mostly
+// in idle sleep, ~3 mA, plus the MPU6050 with gyros running, 3.9 mA.
+// Power-down: ~0.1 uA for the ATmega328P, plus the MPU6050 in
+// accel-only cycle mode.
+
+static const float AWAKE_MA = 3.0f + 3.9f;
+static const float CYCLE_MA[4] = { 0.010f, 0.020f, 0.070f, 0.140f };
+static const float CYCLE_HZ[4] = { 1.25f, 5.0f, 20.0f, 40.0f };
+
+// Hand flat with ~5 mg of sensor noise; raised to 70 degrees over
+// 300 ms starting at each multiple of `raiseEvery` (plus an offset),
+// held for a second, lowered
+static uint64_t raiseEvery = 0;
+static uint64_t raiseOffset = 0;
+
+static float noise(uint64_t us) {
+    uint32_t h = (uint32_t)(us / 1000) * 2654435761UL;
+    return ((h >> 16) & 0xFF) / 255.0f * 2.0f - 1.0f;
+}
+
+static sim::ImuState raiseFeed(uint64_t us, void *) {
+    float pitch = 0.0f;
+    if (us >= raiseOffset) {
+        uint64_t t = (us - raiseOffset) % raiseEvery / 1000;
+        if (t < 300) pitch = 70.0f * t / 300.0f;
+        else if (t < 1300) pitch = 70.0f;
+        else if (t < 1600) pitch = 70.0f * (1600 - t) / 300.0f;
+    }
+    sim::ImuState s = sim::handAtPitch(pitch);
+    s.ax += 0.005f * noise(us);
+    s.ay += 0.005f * noise(us + 7);
+    s.az += 0.005f * noise(us + 13);
+    return s;
+}
+
+#if LOW_POWER_MODE
+// Entry points and state from main_unified.cpp
+void setup();
+void loop();
+extern bool isActive;
+extern MotionDetector motionDetector;
+#endif
+
+BENCH_CASE(power, "Low power: MPU6050 wake-on-motion + power-down") {
+    BenchStat beginStat("beginMotionWake()");
+    BenchStat endStat("endMotionWake()");
+    char lines[4][120];
+
+    // Raises at several phases of the wake-up cycle
+    const uint8_t TRIALS = 8;
+    for (uint8_t rate = 0; rate < 4; rate++) {
+        double wakeSum = 0.0, wakeWorst = 0.0, sampleSum = 0.0;
+        for (uint8_t trial = 0; trial < TRIALS; trial++) {
+            sim::reset();
+            raiseEvery = 1000000000ULL;
+            raiseOffset = 2000000 + trial * 101000ULL;
+            sim::setImuFeed(raiseFeed);
+
+            MPU6050Driver mpu;
+            MPU6050Driver::beginBus(I2C_CLOCK_HZ);
+            mpu.begin();
+            mpu.setBandwidth(MPU6050_DLPF_21HZ);
+            mpu.setSampleRate(SAMPLE_RATE);
+            pinMode(MPU_INT_PIN, INPUT);
+            sim::advanceMillis(500);
+
+            BENCH_TIME(beginStat, mpu.beginMotionWake(LOW_POWER_WAKE_MG, (MPU6050WakeRate)rate));
+            powerDownUntilLow(MPU_INT_PIN);
+            uint64_t wokeAt = sim::nowMicros();
+
+            BENCH_TIME(endStat, mpu.endMotionWake());
+            while (!(mpu.readIntStatus() & MPU6050_INT_DATA_RDY)) {
+                sim::advanceMicros(100);
+            }
+            uint64_t sampleAt = sim::nowMicros();
+
+            double wakeMs = (wokeAt - raiseOffset) / 1000.0;
+            wakeSum += wakeMs;
+            if (wakeMs > wakeWorst) wakeWorst = wakeMs;
+            sampleSum += (sampleAt - wokeAt) / 1000.0;
+        }
+
+        snprintf(lines[rate], sizeof(lines[rate]),
+                 "  wake checks %5.2f Hz: motion -> wake %5.1f ms (worst %5.1f),"
+                 " wake -> sample %4.1f ms, MPU6050 %3.0f uA\n",
+                 CYCLE_HZ[rate], wakeSum / TRIALS, wakeWorst, sampleSum / TRIALS,
+                 CYCLE_MA[rate] * 1000.0f);
+    }
+
+    beginStat.report();
+    endStat.report();
+    for (uint8_t rate = 0; rate < 4; rate++) {
+        printf("%s", lines[rate]);
+    }
+
+    #if LOW_POWER_MODE
+    // Ten minutes, one raise every two minutes
+    sim::reset();
+    raiseEvery = 120000000ULL;
+    raiseOffset = 60000000ULL;
+    sim::setImuFeed(raiseFeed);
+    setup();
+
+    const uint64_t duration = 600ULL * 1000 * 1000;
+    uint32_t raises = (uint32_t)((duration - raiseOffset - 1300000) / raiseEvery + 1);
+    uint32_t activations = 0;
+    bool wasActive = false;
+    while (sim::nowMicros() < duration) {
+        loop();
+        activations += isActive && !wasActive;
+        wasActive = isActive;
+    }
+
+    const WakeStats &wakes = motionDetector.getWakeStats();
+    double asleep = (double)sim::powerDownMicros() / sim::nowMicros();
+    float sleepMa = CYCLE_MA[LOW_POWER_WAKE_RATE] + 0.0001f;
+    printf("  firmware, %u s with a raise every %u s: asleep %.1f%%, %u sleeps,"
+           " %u/%u raises activated\n",
+           (unsigned)(duration / 1000000), (unsigned)(raiseEvery / 1000000), asleep * 100.0,
+           sim::powerDownCount(), activations, raises);
+    printf("  wake -> first sample: last %lu us, worst %lu us over %lu wakes\n",
+           wakes.lastLatency, wakes.maxLatency, wakes.wakes);
+    printf("  estimated supply: %.2f mA average vs %.2f mA always awake\n",
+           AWAKE_MA * (1.0 - asleep) + sleepMa * asleep, AWAKE_MA);
+
+    if (activations != raises || wakes.wakes == 0) {
+        fflush(stdout);
+        exit(1);
+    }
+    #else
+    printf("  (build with LOW_POWER_MODE=1 for the firmware run)\n");
+    #endif
+}
@@ -0,0 +1,126 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "profiler.h"
+#include "bench.h"
+#include "sim.h"
+
+#if PROFILER
+// Section profiler, host backend (PROFILER builds only; profiler.cpp is
+// empty without it). First, known waits on the virtual clock must come
+// back as their length (the host work around them adds a few
+// microseconds at most). Then main_unified runs the hand-raise cycle,
+// the dump command goes in over Serial and the dump is printed. The
+// simulated I2C bus and LEDs take no virtual time, so those sections
+// show host work only. The case fails if a wait is off or a firmware
+// section never ran.
+
+static const uint32_t SLACK_US = 200;
+
+// Entry points from main_unified.cpp
+void setup();
+void loop();
+
+// Hand lies flat, raises to 70 degrees for a second every 6 seconds
+static sim::ImuState raiseCycle(uint64_t us, void *) {
+    uint32_t t = (uint32_t)((us / 1000) % 6000);
+    float pitch = t < 2000 ? 0.0f : (t < 2300 ? 70.0f * (t - 2000) / 300.0f
+                            : (t < 3300 ? 70.0f : (t < 3600 ? 70.0f * (3600 - t) / 300.0f : 0.0f)));
+    return sim::handAtPitch(pitch);
+}
+
+BENCH_CASE(profiler, "Profiler: section timing (host backend)") {
+    BenchStat recordStat("now() + record()");
+    bool ok = true;
+
+    Profiler local;
+    local.begin();
+
+    // Waits of known length
+    static const uint32_t WAITS_US[] = { 0, 50, 500, 20000 };
+    for (uint8_t i = 0; i < 4; i++) {
+        local.reset();
+        for (uint8_t n = 0; n < 20; n++) {
+            uint32_t start = Profiler::now();
+            if (WAITS_US[i] >= 1000) {
+                delay(WAITS_US[i] / 1000);
+            } else if (WAITS_US[i] > 0) {
+                delayMicroseconds(WAITS_US[i]);
+            }
+            local.record(PROF_SERIAL, start);
+        }
+        const ProfileStats &s = local.getStats(PROF_SERIAL);
+        // The overhead estimate can take a little off the wait itself
+        uint32_t waitTicks = WAITS_US[i] * Profiler::TICKS_PER_US;
+        bool within = s.calls == 20 && s.minTicks + local.getOverheadTicks() >= waitTicks &&
+                      s.maxTicks <= waitTicks + SLACK_US * Profiler::TICKS_PER_US;
+        printf("  %5u us wait: min %9u  mean %9u  max %9u ns%s\n", WAITS_US[i], s.minTicks,
+               local.getMeanTicks(PROF_SERIAL), s.maxTicks, within ? "" : "  OUT OF RANGE");
+        ok = ok && within;
+    }
+
+    for (uint32_t i = 0; i < 10000; i++) {
+        BENCH_TIME(recordStat, local.record(PROF_PITCH, Profiler::now()));
+    }
+    recordStat.report();
+    printf("  counter read overhead (subtracted): %u ns\n", local.getOverheadTicks());
+
+    // Half a minute of firmware, then the dump command
+    sim::reset();
+    sim::setImuFeed(raiseCycle);
+    setup();
+    while (sim::nowMicros() < 30ULL * 1000 * 1000) {
+        loop();
+    }
+
+    static uint8_t output[2048];
+    sim::setSerialCapture(output, sizeof(output) - 1);
+    sim::setSerialInput("p");
+    uint64_t end = sim::nowMicros() + HOUSEKEEPING_PERIOD_MS * 1000ULL;
+    while (sim::nowMicros() < end) {
+        loop();
+    }
+    uint16_t captured = sim::serialCapturedBytes();
+    output[captured] = 0;
+    sim::setSerialCapture(nullptr, 0);
+
+    // With TELEMETRY the dump sits between binary records, which hold
+    // zero bytes; the text runs from "profile:" to the next one
+    const char *dump = "";
+    for (uint16_t i = 0; i < captured; i++) {
+        if (strncmp((const char *)output + i, "profile:", 8) == 0) {
+            dump = (const char *)output + i;
+            break;
+        }
+    }
+
+    printf("  firmware dump after 'p':\n");
+    const char *line = dump;
+    while (*line) {
+        const char *eol = strchr(line, '\n');
+        int length = eol ? (int)(eol - line) : (int)strlen(line);
+        if (length > 0 && line[length - 1] == '\r') length--;
+        printf("    %.*s\n", length, line);
+        line += eol ? eol - line + 1 : length;
+    }
+
+    // The dump resets the stats, so check the text
+    static const char *const REQUIRED[] = { "sensor read: calls=", "pitch: calls=",
+                                            "animation: calls=", "show: calls=" };
+    for (uint8_t i = 0; i < 4; i++) {
+        const char *found = strstr(dump, REQUIRED[i]);
+        if (!found || atoi(found + strlen(REQUIRED[i])) == 0) {
+            printf("  section missing: %s\n", REQUIRED[i]);
+            ok = false;
+        }
+    }
+
+    if (!ok) {
+        fflush(stdout);
+        exit(1);
+    }
+}
+
+#endif
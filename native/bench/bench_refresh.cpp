@@ -0,0 +1,180 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "animation.h"
+#include "fastled_facade.h"
+#include "motion_detector.h"
+#include "refresh_scheduler.h"
+#include "task_scheduler.h"
+#include "telemetry.h"
+#include "bench.h"
+#include "sim.h"
+
+// WS2812 refreshes against the motion path. The simulated show() keeps
+// interrupts off for 30 us per LED plus the latch, on the virtual clock.
+// 50 Hz sensor reads, a 5 ms telemetry drain and a 60 FPS animation that
+// changes every frame run for a minute, free-running and with a
+// RefreshScheduler, on 4 and 60 LEDs. With the scheduler, no sensor read
+// may start late, and on 60 LEDs no drain may start later than the
+// longest sensor read (the drain shares every fourth release with the
+// sensor task and queues behind its I2C transfer), or the case fails.
+
+static const uint32_t RUN_SECONDS = 60;
+
+// Hand lies flat, raises to 70 degrees for a second every 6 seconds
+static sim::ImuState raiseCycle(uint64_t us, void *) {
+    uint32_t t = (uint32_t)((us / 1000) % 6000);
+    float pitch = t < 2000 ? 0.0f : (t < 2300 ? 70.0f * (t - 2000) / 300.0f
+                            : (t < 3300 ? 70.0f : (t < 3600 ? 70.0f * (3600 - t) / 300.0f : 0.0f)));
+    return sim::handAtPitch(pitch);
+}
+
+// Start delay of each release past its grid time
+struct Lateness {
+    unsigned long next;
+    unsigned long period;
+    uint32_t late;
+    unsigned long worst;
+
+    void start(unsigned long periodUs) {
+        next = micros();
+        period = periodUs;
+        late = 0;
+        worst = 0;
+    }
+
+    void release() {
+        unsigned long delay = micros() - next;
+        if (delay > 0) late++;
+        if (delay > worst) worst = delay;
+        next += period;
+    }
+};
+
+struct RunResult {
+    Lateness sensor;
+    Lateness drain;
+    unsigned long readWorst;
+    uint32_t frames;
+    RefreshStats refresh;
+};
+
+static MotionDetector *detector;
+static Telemetry channel;
+static Lateness sensorLate, drainLate;
+static unsigned long readWorst;
+static void (*commitHeld)();
+static void (*renderFrame)();
+
+static void sensorTask() {
+    sensorLate.release();
+    unsigned long start = micros();
+    bool raised = detector->isHandRaised();
+    unsigned long read = micros() - start;
+    if (read > readWorst) readWorst = read;
+    channel.logSample(millis(), 0, 0, 0, TELEM_NO_PITCH, raised);
+    commitHeld();
+}
+
+static void drainTask() {
+    drainLate.release();
+    channel.drain();
+    commitHeld();
+}
+
+static void animationTask() {
+    renderFrame();
+}
+
+template <uint8_t N>
+struct StripRun {
+    static FastLEDStrip<N, 6> *strip;
+    static AnimationEngine<FastLEDStrip<N, 6>> *animation;
+
+    static void commit() { strip->showDeferred(); }
+    static void render() { animation->render(millis()); }
+
+    static RunResult run(bool scheduled) {
+        sim::reset();
+        sim::setImuFeed(raiseCycle);
+        Serial.begin(TELEMETRY_BAUD);
+        channel.reset();
+
+        FastLEDStrip<N, 6> leds;
+        AnimationEngine<FastLEDStrip<N, 6>> engine(leds);
+        MotionDetector motion;
+        TaskScheduler scheduler;
+        RefreshScheduler refresh(scheduler);
+        strip = &leds;
+        animation = &engine;
+        detector = &motion;
+        commitHeld = commit;
+        renderFrame = render;
+
+        leds.begin();
+        motion.begin();
+        engine.play(ANIM_LED_TEST, millis(), true);
+
+        int8_t sensorId = scheduler.addTask("sensor", sensorTask, 1000000UL / SAMPLE_RATE);
+        scheduler.addTask("animation", animationTask, 1000000UL / ANIMATION_FPS);
+        int8_t drainId = scheduler.addTask("telemetry", drainTask,
+                                           TELEMETRY_DRAIN_PERIOD_MS * 1000UL);
+        if (scheduled) {
+            refresh.protect(sensorId);
+            refresh.protect(drainId);
+            leds.setRefreshScheduler(&refresh);
+        }
+        sensorLate.start(1000000UL / SAMPLE_RATE);
+        drainLate.start(TELEMETRY_DRAIN_PERIOD_MS * 1000UL);
+        readWorst = 0;
+
+        uint32_t framesBefore = sim::lastFrame().showCount;
+        uint64_t end = sim::nowMicros() + RUN_SECONDS * 1000000ULL;
+        while (sim::nowMicros() < end) {
+            scheduler.run();
+        }
+
+        RunResult result;
+        result.sensor = sensorLate;
+        result.drain = drainLate;
+        result.readWorst = readWorst;
+        result.frames = sim::lastFrame().showCount - framesBefore;
+        result.refresh = refresh.getStats();
+        return result;
+    }
+};
+
+template <uint8_t N> FastLEDStrip<N, 6> *StripRun<N>::strip;
+template <uint8_t N> AnimationEngine<FastLEDStrip<N, 6>> *StripRun<N>::animation;
+
+static void report(uint8_t leds, bool scheduled, const RunResult &r) {
+    printf("  %2u LEDs, %-10s sensor late %4u/%u (worst %4lu us), drain late %4u (worst %4lu us),"
+           " %u frames",
+           leds, scheduled ? "scheduled:" : "free-run:", r.sensor.late,
+           RUN_SECONDS * SAMPLE_RATE, r.sensor.worst, r.drain.late, r.drain.worst, r.frames);
+    if (scheduled) {
+        printf(", %lu deferred, %lu missed, hold <= %lu us, read <= %lu us",
+               r.refresh.deferred, r.refresh.missed, r.refresh.maxDelay, r.readWorst);
+    }
+    printf("\n");
+}
+
+BENCH_CASE(refresh, "WS2812 refresh scheduling vs sensor reads") {
+    RunResult free4 = StripRun<4>::run(false);
+    RunResult sched4 = StripRun<4>::run(true);
+    RunResult free60 = StripRun<60>::run(false);
+    RunResult sched60 = StripRun<60>::run(true);
+
+    printf("  refresh window: %lu us at 4 LEDs, %lu us at 60 LEDs\n",
+           FastLEDStrip<4, 6>::REFRESH_MICROS, FastLEDStrip<60, 6>::REFRESH_MICROS);
+    report(4, false, free4);
+    report(4, true, sched4);
+    report(60, false, free60);
+    report(60, true, sched60);
+
+    if (sched4.sensor.late || sched60.sensor.late || sched60.drain.worst > sched60.readWorst) {
+        fflush(stdout);
+        exit(1);
+    }
+}
@@ -0,0 +1,201 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "motion_detector.h"
+#include "mpu6050_driver.h"
+#include "bench.h"
+#include "sim.h"
+
+// Motion-adaptive sampling against the fixed SAMPLE_RATE poll over one
+// minute. The hand rests flat with ~5 mg of noise and is raised to 70
+// degrees every 20 s (300 ms up, held 1 s, 300 ms down). Both
+// runs poll the sensor the way sensorTask does. The adaptive one
+// follows each rate switch with the new period. Reports samples per
+// second, I2C traffic, rate switches and raise-to-trigger latency on
+// the virtual clock.
+//
+// With ADAPTIVE_SAMPLING the case fails if any raise goes undetected,
+// if the average rate is not below SAMPLE_RATE, if no raise reaches
+// ADAPTIVE_MOTION_RATE, or if the mean latency is worse than the fixed
+// poll's (not checked with ORIENTATION_FUSION, which triggers on the
+// filtered pitch). The simulated MPU6050 does not model the DLPF, so the
+// ~14 ms delay of the 10 Hz filter before the first switch is not in
+// these figures.
+
+static const uint64_t RUN_MICROS = 60ULL * 1000 * 1000;
+static const uint64_t RAISE_OFFSET = 3000000ULL;
+static const uint64_t RAISE_EVERY = 20000000ULL;
+static const uint8_t RAISES = (RUN_MICROS - RAISE_OFFSET) / RAISE_EVERY + 1;
+
+static float noise(uint64_t us) {
+    uint32_t h = (uint32_t)(us / 1000) * 2654435761UL;
+    return ((h >> 16) & 0xFF) / 255.0f * 2.0f - 1.0f;
+}
+
+static sim::ImuState raiseFeed(uint64_t us, void *) {
+    float pitch = 0.0f;
+    if (us >= RAISE_OFFSET) {
+        uint64_t t = (us - RAISE_OFFSET) % RAISE_EVERY / 1000;
+        if (t < 300) pitch = 70.0f * t / 300.0f;
+        else if (t < 1300) pitch = 70.0f;
+        else if (t < 1600) pitch = 70.0f * (1600 - t) / 300.0f;
+    }
+    sim::ImuState s = sim::handAtPitch(pitch);
+    s.ax += 0.005f * noise(us);
+    s.ay += 0.005f * noise(us + 7);
+    s.az += 0.005f * noise(us + 13);
+    return s;
+}
+
+struct SamplingRun {
+    uint32_t reads;
+    uint32_t busBytes;
+    uint32_t busTransactions;
+    uint8_t detected;
+    double latencySum;      // ms, raise onset to trigger
+    double latencyWorst;
+};
+
+static void startRun(SamplingRun &run) {
+    sim::reset();
+    sim::setImuFeed(raiseFeed);
+    run.reads = 0;
+    run.busBytes = sim::i2cBytesTransferred();
+    run.busTransactions = sim::i2cTransactions();
+    run.detected = 0;
+    run.latencySum = 0.0;
+    run.latencyWorst = 0.0;
+}
+
+static void recordTrigger(SamplingRun &run) {
+    uint64_t now = sim::nowMicros();
+    if (now < RAISE_OFFSET) {
+        return;
+    }
+    double ms = (now - RAISE_OFFSET) % RAISE_EVERY / 1000.0;
+    run.detected++;
+    run.latencySum += ms;
+    if (ms > run.latencyWorst) run.latencyWorst = ms;
+}
+
+static void finishRun(SamplingRun &run) {
+    run.busBytes = sim::i2cBytesTransferred() - run.busBytes;
+    run.busTransactions = sim::i2cTransactions() - run.busTransactions;
+}
+
+static void report(const char *label, const SamplingRun &run) {
+    double seconds = RUN_MICROS / 1e6;
+    // 9 bit times per byte (8 + ACK) at the bus clock
+    double busMs = run.busBytes * 9.0 * 1000.0 / sim::i2cClockHz();
+    printf("  %-9s %6.1f samples/s  I2C %6.0f B/s in %5.1f transactions/s"
+           " (~%4.1f ms/s at %lu kHz)  %u/%u raises, latency %5.1f ms (worst %5.1f)\n",
+           label, run.reads / seconds, run.busBytes / seconds, run.busTransactions / seconds,
+           busMs / seconds, (unsigned long)(sim::i2cClockHz() / 1000), run.detected, RAISES,
+           run.detected ? run.latencySum / run.detected : 0.0, run.latencyWorst);
+}
+
+// The fixed poll: SAMPLE_RATE through the driver, as without ADAPTIVE_SAMPLING
+static void runFixed(SamplingRun &run, BenchStat &stat) {
+    startRun(run);
+    MPU6050Driver mpu;
+    MPU6050Driver::beginBus(I2C_CLOCK_HZ);
+    mpu.begin();
+    mpu.setAccelRange(MPU6050_ACCEL_2G);
+    mpu.setBandwidth(MPU6050_DLPF_21HZ);
+    mpu.setSampleRate(SAMPLE_RATE);
+
+    const uint32_t period = 1000000UL / SAMPLE_RATE;
+    bool wasRaised = false;
+    while (sim::nowMicros() < RUN_MICROS) {
+        sim::advanceMicros(period);
+        int16_t x, y, z;
+        bool raised;
+        BENCH_TIME(stat, mpu.readAccel(x, y, z);
+                         raised = MotionDetector::isPitchAboveThreshold(x, y, z));
+        run.reads++;
+        if (raised && !wasRaised) {
+            recordTrigger(run);
+        }
+        wasRaised = raised;
+    }
+    finishRun(run);
+}
+
+#if ADAPTIVE_SAMPLING
+static uint32_t reachedMotionRate;    // Switches up to ADAPTIVE_MOTION_RATE
+
+// MotionDetector with the sensor period following each SamplingEvent
+static void runAdaptive(SamplingRun &run, BenchStat &stat, uint16_t &averageRate,
+                        uint16_t &switches) {
+    startRun(run);
+    MotionDetector detector;
+    detector.begin();
+    detector.resetSamplingStats();
+
+    // begin() reports the motion rate it starts at
+    SamplingEvent change;
+    detector.pollSamplingChange(change);
+    uint32_t period = 1000000UL / change.rate;
+    reachedMotionRate = 0;
+    while (sim::nowMicros() < RUN_MICROS) {
+        sim::advanceMicros(period);
+        bool triggered;
+        BENCH_TIME(stat, triggered = detector.isHandRaised());
+        run.reads++;
+        if (triggered) {
+            recordTrigger(run);
+        }
+        if (detector.pollSamplingChange(change)) {
+            period = 1000000UL / change.rate;
+            reachedMotionRate += change.profile == SAMPLING_MOTION &&
+                                 change.rate == ADAPTIVE_MOTION_RATE;
+        }
+    }
+    finishRun(run);
+    averageRate = detector.getAverageRate(millis());
+    switches = detector.getSamplingStats().switches;
+}
+#endif
+
+BENCH_CASE(sampling, "Adaptive sampling: rate, I2C traffic, raise latency") {
+    BenchStat fixedStat("fixed: read + tilt test");
+    SamplingRun fixed;
+    runFixed(fixed, fixedStat);
+
+    #if ADAPTIVE_SAMPLING
+    BenchStat adaptiveStat("adaptive: isHandRaised()");
+    SamplingRun adaptive;
+    uint16_t averageRate, switches;
+    runAdaptive(adaptive, adaptiveStat, averageRate, switches);
+
+    fixedStat.report();
+    adaptiveStat.report();
+    char label[16];
+    snprintf(label, sizeof(label), "%u Hz", SAMPLE_RATE);
+    report(label, fixed);
+    report("adaptive", adaptive);
+    printf("  adaptive: %u/%u Hz, %u switches (%lu up to %u Hz),"
+           " detector average %u Hz\n",
+           ADAPTIVE_STILL_RATE, ADAPTIVE_MOTION_RATE, switches,
+           (unsigned long)reachedMotionRate, ADAPTIVE_MOTION_RATE, averageRate);
+
+    bool slower = adaptive.latencySum / adaptive.detected > fixed.latencySum / fixed.detected;
+    #if ORIENTATION_FUSION
+    // The fused trigger lags the raw tilt test by design
+    printf("  (latency not compared: ORIENTATION_FUSION triggers on the filtered pitch)\n");
+    slower = false;
+    #endif
+    if (adaptive.detected != RAISES || averageRate >= SAMPLE_RATE || reachedMotionRate == 0 ||
+        slower) {
+        fflush(stdout);
+        exit(1);
+    }
+    #else
+    fixedStat.report();
+    char label[16];
+    snprintf(label, sizeof(label), "%u Hz", SAMPLE_RATE);
+    report(label, fixed);
+    printf("  (build with ADAPTIVE_SAMPLING=1 for the adaptive run)\n");
+    #endif
+}
@@ -0,0 +1,184 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "motion_detector.h"
+#include "telemetry.h"
+#include "bench.h"
+#include "sim.h"
+
+// Telemetry against the DEBUG pitch print it replaces. CPU cost per
+// sample, then virtual time the sample path spends blocked on a
+// 115200 baud UART while housekeeping text keeps the TX buffer busy.
+// Finally, overload the link and check the decoded stream record by
+// record; any mismatch fails the case. The drop count must equal the
+// seq gaps the host sees.
+
+static const uint32_t RUN_SECONDS = 10;
+static const uint32_t BURST_BYTES = 300;     // printStats() with four tasks
+
+static uint32_t noiseState = 1;
+static int16_t noiseCounts(int16_t amplitude) {
+    noiseState = noiseState * 1664525UL + 1013904223UL;
+    return (int16_t)((int32_t)(noiseState >> 16) % (2 * amplitude + 1) - amplitude);
+}
+
+static void debugPitchPrint(int16_t x, int16_t y, int16_t z) {
+    Serial.print("Pitch: ");
+    Serial.println(MotionDetector::calculatePitch(x, y, z));
+}
+
+// Virtual time the sample path spends blocked on the UART, over
+// RUN_SECONDS of 50 Hz samples plus a 1 Hz text burst
+struct BlockResult {
+    uint64_t totalUs;
+    uint64_t worstUs;
+};
+
+static BlockResult runTimeline(bool useTelemetry, Telemetry &channel) {
+    sim::reset();
+    Serial.begin(115200);
+    channel.reset();
+
+    static char burst[BURST_BYTES + 1];
+    memset(burst, '.', BURST_BYTES);
+    burst[BURST_BYTES] = 0;
+
+    BlockResult result = { 0, 0 };
+    const uint32_t samplePeriodUs = 1000000UL / SAMPLE_RATE;
+    const uint32_t drainPeriodUs = TELEMETRY_DRAIN_PERIOD_MS * 1000UL;
+    uint64_t nextSample = 0, nextDrain = 0, nextBurst = 10000;
+    uint64_t end = (uint64_t)RUN_SECONDS * 1000000;
+
+    while (sim::nowMicros() < end) {
+        uint64_t now = sim::nowMicros();
+        if (now >= nextBurst) {
+            Serial.print(burst);
+            nextBurst += 1000000;
+        }
+        if (now >= nextSample) {
+            sim::ImuState s = sim::handAtPitch(30.0f);
+            int16_t x = (int16_t)(s.ax * 16384.0f) + noiseCounts(150);
+            int16_t y = (int16_t)(s.ay * 16384.0f) + noiseCounts(150);
+            int16_t z = (int16_t)(s.az * 16384.0f) + noiseCounts(150);
+
+            uint64_t before = sim::serialBlockedMicros();
+            if (useTelemetry) {
+                channel.logSample(millis(), x, y, z, TELEM_NO_PITCH, 0);
+            } else {
+                debugPitchPrint(x, y, z);
+            }
+            uint64_t blocked = sim::serialBlockedMicros() - before;
+            result.totalUs += blocked;
+            if (blocked > result.worstUs) result.worstUs = blocked;
+            nextSample += samplePeriodUs;
+        }
+        if (useTelemetry && now >= nextDrain) {
+            uint64_t before = sim::serialBlockedMicros();
+            channel.drain();
+            if (sim::serialBlockedMicros() != before) {
+                printf("  drain() blocked\n");
+                fflush(stdout);
+                exit(1);
+            }
+            nextDrain += drainPeriodUs;
+        }
+
+        uint64_t next = nextSample;
+        if (nextBurst < next) next = nextBurst;
+        if (useTelemetry && nextDrain < next) next = nextDrain;
+        if (next > sim::nowMicros()) {
+            sim::advanceMicros(next - sim::nowMicros());
+        }
+    }
+    return result;
+}
+
+BENCH_CASE(telemetry, "Telemetry: binary ring buffer vs DEBUG_PRINT") {
+    BenchStat printStat("DEBUG pitch print");
+    BenchStat logStat("Telemetry::logSample()");
+    BenchStat drainStat("Telemetry::drain()");
+    static Telemetry channel;
+
+    // CPU cost, UART unthrottled
+    for (uint32_t i = 0; i < 2000; i++) {
+        int16_t x = -8000 + noiseCounts(2000), y = noiseCounts(2000), z = 14000;
+        BENCH_TIME(printStat, debugPitchPrint(x, y, z));
+        BENCH_TIME(logStat, channel.logSample(i * 20, x, y, z, TELEM_NO_PITCH, 0));
+        BENCH_TIME(drainStat, channel.drain());
+    }
+
+    BlockResult debugBlocked = runTimeline(false, channel);
+    BlockResult telemBlocked = runTimeline(true, channel);
+    uint32_t timelineDropped = channel.getDropped();
+
+    // Overload: 1 kHz samples against ~600 frames/s of link capacity
+    sim::reset();
+    Serial.begin(115200);
+    channel.reset();
+    static uint8_t captured[64 * 1024];
+    sim::setSerialCapture(captured, sizeof(captured));
+
+    const uint32_t OFFERED = 2000;
+    static int16_t sent[OFFERED][3];
+    for (uint32_t i = 0; i < OFFERED; i++) {
+        sent[i][0] = (int16_t)(noiseCounts(16000) * 2);
+        sent[i][1] = noiseCounts(16000);
+        sent[i][2] = (int16_t)(i & 1 ? 0 : 256);   // Zero bytes exercise COBS
+        channel.logSample(i, sent[i][0], sent[i][1], sent[i][2], (int16_t)i,
+                          (uint8_t)(i & 3));
+        channel.drain();
+        sim::advanceMicros(1000);
+    }
+    // Let the ring empty
+    for (uint32_t i = 0; i < 100; i++) {
+        channel.drain();
+        sim::advanceMicros(TELEMETRY_DRAIN_PERIOD_MS * 1000UL);
+    }
+
+    TelemetryDecoder decoder;
+    TelemetryRecord record;
+    uint32_t samples = 0, mismatches = 0, reportedDrops = 0;
+    for (uint32_t i = 0; i < sim::serialCapturedBytes(); i++) {
+        if (!decoder.push(captured[i], record)) continue;
+        if (record.type == TELEM_DROPPED) {
+            reportedDrops += (uint16_t)record.int16At(0);
+            continue;
+        }
+        // Pitch carries the index of the logged sample
+        uint32_t n = (uint16_t)record.int16At(6);
+        samples++;
+        if (record.type != TELEM_SAMPLE || n >= OFFERED || record.millis != n ||
+            record.int16At(0) != sent[n][0] || record.int16At(2) != sent[n][1] ||
+            record.int16At(4) != sent[n][2] || record.payload[8] != (n & 3)) {
+            mismatches++;
+        }
+    }
+    sim::setSerialCapture(nullptr, 0);
+
+    // Every seq gap is covered by a TELEM_DROPPED report. Drops after the
+    // last decoded record leave no gap and have no report yet.
+    bool consistent = decoder.getLost() == reportedDrops &&
+                      reportedDrops <= channel.getDropped() &&
+                      samples + channel.getDropped() == OFFERED && decoder.getBadFrames() == 0;
+
+    printStat.report();
+    logStat.report();
+    drainStat.report();
+    printf("  sample path blocked on the UART over %u s at 115200 baud with a %u-byte\n"
+           "  text burst per second: DEBUG print %.1f ms (worst sample %.2f ms),"
+           " telemetry %.1f ms\n",
+           RUN_SECONDS, BURST_BYTES, debugBlocked.totalUs / 1000.0, debugBlocked.worstUs / 1000.0,
+           telemBlocked.totalUs / 1000.0);
+    printf("  telemetry at %u Hz: %u records dropped, %u-byte ring, %u bytes/frame max\n",
+           SAMPLE_RATE, timelineDropped, TELEMETRY_BUFFER_SIZE, TELEMETRY_MAX_FRAME);
+    printf("  overload (1 kHz): %u offered, %u decoded, %u dropped, %u lost by seq,"
+           " %u reported, %u mismatches\n",
+           OFFERED, samples, channel.getDropped(), decoder.getLost(), reportedDrops, mismatches);
+
+    if (mismatches || !consistent || telemBlocked.totalUs != 0) {
+        fflush(stdout);
+        exit(1);
+    }
+}
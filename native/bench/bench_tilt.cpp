@@ -0,0 +1,76 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include "config.h"
+#include "motion_detector.h"
+#include "bench.h"
+
+// Float reference vs integer tilt test over a sweep of hand poses.
+// Host ns understate the gap: on the ATmega328 the float path is
+// soft-float atan2 + sqrt + divide, the integer path three 16x16
+// multiplies and one 32x16 multiply.
+
+struct RawSample {
+    int16_t x, y, z;
+    float pitch;
+};
+
+static const uint16_t NUM_SAMPLES = 3601;
+static RawSample samples[NUM_SAMPLES];
+
+// Pitch -90..+90 in 0.05 degree steps, rolled around X so y and z both vary
+static void buildSweep() {
+    for (uint16_t i = 0; i < NUM_SAMPLES; i++) {
+        float pitch = -90.0f + i * 0.05f;
+        float roll = (i % 37) * 10.0f;
+        float p = pitch * (float)DEG_TO_RAD;
+        float r = roll * (float)DEG_TO_RAD;
+        samples[i].x = (int16_t)lroundf(-sinf(p) * 16384.0f);
+        samples[i].y = (int16_t)lroundf(cosf(p) * sinf(r) * 16384.0f);
+        samples[i].z = (int16_t)lroundf(cosf(p) * cosf(r) * 16384.0f);
+        samples[i].pitch = pitch;
+    }
+}
+
+BENCH_CASE(tilt, "Tilt test: float reference vs integer") {
+    BenchStat floatStat("float calculatePitch() > angle");
+    BenchStat fixedStat("isPitchAboveThreshold()");
+
+    buildSweep();
+
+    uint16_t mismatches = 0;
+    float worstMismatchDeg = 0.0f;
+
+    for (uint16_t i = 0; i < NUM_SAMPLES; i++) {
+        const RawSample &s = samples[i];
+        bool floatRaised = MotionDetector::calculatePitch(s.x, s.y, s.z) > ACTIVATION_ANGLE;
+        bool fixedRaised = MotionDetector::isPitchAboveThreshold(s.x, s.y, s.z);
+        if (floatRaised != fixedRaised) {
+            mismatches++;
+            float off = fabsf(s.pitch - ACTIVATION_ANGLE);
+            if (off > worstMismatchDeg) worstMismatchDeg = off;
+        }
+    }
+
+    for (uint8_t pass = 0; pass < 50; pass++) {
+        uint16_t raised = 0;
+        BENCH_TIME_BATCH(floatStat, NUM_SAMPLES,
+            for (uint16_t i = 0; i < NUM_SAMPLES; i++) {
+                const RawSample &s = samples[i];
+                raised += MotionDetector::calculatePitch(s.x, s.y, s.z) > ACTIVATION_ANGLE;
+            });
+        benchKeep(raised);
+
+        raised = 0;
+        BENCH_TIME_BATCH(fixedStat, NUM_SAMPLES,
+            for (uint16_t i = 0; i < NUM_SAMPLES; i++) {
+                const RawSample &s = samples[i];
+                raised += MotionDetector::isPitchAboveThreshold(s.x, s.y, s.z);
+            });
+        benchKeep(raised);
+    }
+
+    floatStat.report();
+    fixedStat.report();
+    printf("  disagreements: %u of %u poses (worst %.3f deg from threshold)\n",
+           mismatches, NUM_SAMPLES, worstMismatchDeg);
+}
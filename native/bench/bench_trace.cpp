@@ -0,0 +1,90 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "imu_trace.h"
+#include "bench.h"
+#include "sim.h"
+
+// IMU trace format: encode cost per sample on the capture path, decode
+// cost on the host, size against raw counts, and an exact round trip
+// (the case fails on any mismatch). Motion is the hand-raise cycle
+// with sensor noise, polling jitter and one long gap.
+
+static const uint32_t NUM_SAMPLES = 3000;
+
+static uint32_t noiseState = 1;
+static int16_t noiseCounts(int16_t amplitude) {
+    noiseState = noiseState * 1664525UL + 1013904223UL;
+    return (int16_t)((int32_t)(noiseState >> 16) % (2 * amplitude + 1) - amplitude);
+}
+
+BENCH_CASE(trace, "IMU trace: delta + varint encoding") {
+    BenchStat encodeStat("ImuTraceEncoder::encode()");
+    BenchStat decodeStat("ImuTraceDecoder::decode()");
+
+    static MotionSample input[NUM_SAMPLES];
+    static unsigned long stamps[NUM_SAMPLES];
+    static uint8_t stream[IMU_TRACE_HEADER_SIZE + NUM_SAMPLES * IMU_TRACE_MAX_RECORD];
+
+    // Start near the micros() wrap so the timestamps roll over mid-trace
+    unsigned long stamp = 0xFFFFFFFFUL - 20UL * 1000 * 1000;
+    for (uint32_t i = 0; i < NUM_SAMPLES; i++) {
+        uint32_t ms = (i * 20) % 6000;
+        float pitch = ms < 2000 ? 0.0f : (ms < 2300 ? 70.0f * (ms - 2000) / 300.0f
+                                       : (ms < 3300 ? 70.0f : 0.0f));
+        sim::ImuState s = sim::handAtPitch(pitch);
+        input[i].ax = (int16_t)(s.ax * 16384.0f) + noiseCounts(150);
+        input[i].ay = (int16_t)(s.ay * 16384.0f) + noiseCounts(150);
+        input[i].az = (int16_t)(s.az * 16384.0f) + noiseCounts(150);
+        input[i].gx = noiseCounts(60);
+        input[i].gy = (ms >= 2000 && ms < 2300 ? 30568 : 0) + noiseCounts(60);
+        input[i].gz = noiseCounts(60);
+
+        stamp += 20000 + noiseCounts(300);
+        if (i == NUM_SAMPLES / 2) {
+            stamp += 0x40000000UL;     // Long gap: forces an absolute record
+        }
+        stamps[i] = stamp;
+    }
+
+    ImuTraceEncoder encoder(20000);
+    size_t length = encoder.writeHeader(stream, MPU6050_ACCEL_2G, MPU6050_GYRO_250DPS);
+    for (uint32_t i = 0; i < NUM_SAMPLES; i++) {
+        uint8_t n;
+        BENCH_TIME(encodeStat, n = encoder.encode(input[i], stamps[i], stream + length));
+        length += n;
+    }
+
+    ImuTraceDecoder decoder;
+    size_t offset = decoder.readHeader(stream, length);
+    uint32_t mismatches = offset == IMU_TRACE_HEADER_SIZE ? 0 : 1;
+    for (uint32_t i = 0; i < NUM_SAMPLES && offset; i++) {
+        ImuTraceRecord record;
+        size_t used;
+        BENCH_TIME(decodeStat, used = decoder.decode(stream + offset, length - offset, record));
+        if (used == 0) {
+            mismatches += NUM_SAMPLES - i;
+            break;
+        }
+        offset += used;
+        if (record.micros != (uint32_t)stamps[i] ||
+            memcmp(&record.sample, &input[i], sizeof(MotionSample)) != 0) {
+            mismatches++;
+        }
+    }
+
+    encodeStat.report();
+    decodeStat.report();
+    printf("  %.2f bytes/sample (raw counts + timestamp: 16), round-trip mismatches: %u\n",
+           (double)(length - IMU_TRACE_HEADER_SIZE) / NUM_SAMPLES, mismatches);
+    printf("  at %u Hz: %.0f bytes/s of %u available at %u baud\n", SAMPLE_RATE,
+           (double)(length - IMU_TRACE_HEADER_SIZE) / NUM_SAMPLES * SAMPLE_RATE,
+           TRACE_CAPTURE_BAUD / 10, TRACE_CAPTURE_BAUD);
+
+    if (mismatches) {
+        fflush(stdout);
+        exit(1);
+    }
+}
@@ -0,0 +1,170 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "async_twi.h"
+#include "mpu6050_driver.h"
+#include "task_scheduler.h"
+#include "bench.h"
+#include "sim.h"
+
+// Sensor reads over I2C, blocking against interrupt-driven. A 6-byte
+// accelerometer read through Wire holds the CPU for its whole bus time,
+// measured on the virtual clock at 100 kHz and 400 kHz. The same read
+// through AsyncTwi starts at once and completes under the TWI interrupt
+// while the bench loop polls in 10 us steps. Fails if the async bytes
+// differ from the blocking read, if a disconnected sensor is not
+// reported as a NACK, or if a transfer on a stuck bus is not aborted
+// with a timeout and followed by a good read once the bus is released.
+//
+// With ASYNC_TWI, main_unified then runs for a minute with a hand raise
+// every 6 s and the sensor read on the bus in the background. Fails if
+// a raise does not activate or a transfer times out.
+
+static const uint8_t READ_LENGTH = 6;
+
+static AsyncTwi twi;
+
+static void serviceTwi() {
+    twi.service();
+}
+
+static sim::ImuState raisedHand(uint64_t, void *) {
+    return sim::handAtPitch(45.0f);
+}
+
+// Blocking read through Wire; returns the virtual time it held the CPU
+static uint64_t wireRead(uint32_t clockHz, uint8_t *bytes) {
+    Wire.setClock(clockHz);
+    uint64_t start = sim::nowMicros();
+    Wire.beginTransmission(MPU6050_DEFAULT_ADDRESS);
+    Wire.write(MPU6050_REG_ACCEL_XOUT_H);
+    Wire.endTransmission(false);
+    Wire.requestFrom((uint8_t)MPU6050_DEFAULT_ADDRESS, READ_LENGTH);
+    for (uint8_t i = 0; i < READ_LENGTH; i++) {
+        bytes[i] = Wire.read();
+    }
+    return sim::nowMicros() - start;
+}
+
+static bool checkTransport() {
+    sim::reset();
+    sim::setImuFeed(raisedHand);
+    sim::setTwiHandler(serviceTwi);
+    Wire.begin();
+    twi.begin(I2C_CLOCK_HZ);
+    bool ok = true;
+
+    // Wake the sensor so the data registers fill
+    uint8_t wake = 0x01;
+    ok &= twi.write(MPU6050_DEFAULT_ADDRESS, MPU6050_REG_PWR_MGMT_1, &wake, 1) == TWI_OK;
+    delay(10);
+
+    uint8_t blocking[READ_LENGTH];
+    uint64_t stall100 = wireRead(100000, blocking);
+    uint64_t stall400 = wireRead(400000, blocking);
+
+    uint8_t async[READ_LENGTH];
+    memset(async, 0, sizeof(async));
+    uint64_t start = sim::nowMicros();
+    ok &= twi.startRead(MPU6050_DEFAULT_ADDRESS, MPU6050_REG_ACCEL_XOUT_H, async, READ_LENGTH);
+    uint64_t startStall = sim::nowMicros() - start;
+    uint32_t polls = 0;
+    while (twi.isBusy() && polls < 1000) {
+        sim::advanceMicros(10);
+        polls++;
+    }
+    uint64_t complete = sim::nowMicros() - start;
+    bool same = twi.status() == TWI_OK && memcmp(async, blocking, READ_LENGTH) == 0;
+
+    printf("  Wire, blocking: %llu us at 100 kHz, %llu us at 400 kHz\n",
+           (unsigned long long)stall100, (unsigned long long)stall400);
+    printf("  AsyncTwi at %lu kHz: %llu us to start, done after %llu us"
+           " (%lu loop polls meanwhile), data %s\n",
+           (unsigned long)(I2C_CLOCK_HZ / 1000), (unsigned long long)startStall,
+           (unsigned long long)complete, (unsigned long)polls, same ? "matches" : "DIFFERS");
+    ok &= same && startStall == 0;
+
+    // Nobody answers the address
+    sim::setImuConnected(false);
+    uint8_t nack = twi.read(MPU6050_DEFAULT_ADDRESS, MPU6050_REG_WHO_AM_I, async, 1);
+    sim::setImuConnected(true);
+
+    // A slave holding the bus: the transfer never finishes on its own
+    sim::setTwiStuck(true);
+    start = sim::nowMicros();
+    uint8_t stuck = twi.read(MPU6050_DEFAULT_ADDRESS, MPU6050_REG_ACCEL_XOUT_H, async, READ_LENGTH);
+    uint64_t abortAfter = sim::nowMicros() - start;
+    sim::setTwiStuck(false);
+    uint8_t recovered = twi.read(MPU6050_DEFAULT_ADDRESS, MPU6050_REG_ACCEL_XOUT_H, async,
+                                 READ_LENGTH);
+
+    printf("  Disconnected: %s; stuck bus: %s after %llu us, %lu timeout(s);"
+           " next read %s\n",
+           nack == TWI_NACK ? "NACK" : "NOT NACKED",
+           stuck == TWI_TIMEOUT ? "aborted" : "NOT ABORTED", (unsigned long long)abortAfter,
+           twi.getTimeouts(), recovered == TWI_OK ? "ok" : "FAILED");
+    ok &= nack == TWI_NACK && stuck == TWI_TIMEOUT && twi.getTimeouts() == 1 &&
+          recovered == TWI_OK;
+
+    twi.end();
+    sim::setTwiHandler(nullptr);
+    return ok;
+}
+
+#if ASYNC_TWI
+// Entry points and state from main_unified.cpp
+void setup();
+void loop();
+extern bool isActive;
+extern TaskScheduler scheduler;
+
+// Hand lies flat, raises to 70 degrees for a second every 6 seconds
+static sim::ImuState raiseCycle(uint64_t us, void *) {
+    uint32_t t = (uint32_t)((us / 1000) % 6000);
+    float pitch = 0.0f;
+    if (t >= 2000 && t < 2300) pitch = 70.0f * (t - 2000) / 300.0f;
+    else if (t >= 2300 && t < 3300) pitch = 70.0f;
+    else if (t >= 3300 && t < 3600) pitch = 70.0f * (3600 - t) / 300.0f;
+    return sim::handAtPitch(pitch);
+}
+
+static bool checkFirmware() {
+    BenchStat loopStat("loop(), async sensor reads");
+    sim::reset();
+    sim::setImuFeed(raiseCycle);
+    setup();
+
+    const uint64_t duration = 60ULL * 1000 * 1000;
+    uint32_t activations = 0;
+    bool wasActive = false;
+    uint32_t transactionsBefore = sim::i2cTransactions();
+    while (sim::nowMicros() < duration) {
+        BENCH_TIME(loopStat, loop());
+        activations += isActive && !wasActive;
+        wasActive = isActive;
+    }
+    loopStat.report();
+
+    uint32_t raises = (uint32_t)(duration / 6000000);
+    printf("  %lu I2C transactions, %lu errors, %lu timeouts; %lu/%lu raises activated\n",
+           (unsigned long)(sim::i2cTransactions() - transactionsBefore), asyncTwi.getErrors(),
+           asyncTwi.getTimeouts(), (unsigned long)activations, (unsigned long)raises);
+    return activations == raises && asyncTwi.getTimeouts() == 0;
+}
+#endif
+
+BENCH_CASE(twi, "I2C transport: blocking Wire vs interrupt-driven TWI") {
+    bool ok = checkTransport();
+    #if ASYNC_TWI
+    ok &= checkFirmware();
+    #else
+    printf("  (build with ASYNC_TWI=1 for the firmware run)\n");
+    #endif
+    if (!ok) {
+        fflush(stdout);
+        exit(1);
+    }
+}
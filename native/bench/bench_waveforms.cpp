@@ -0,0 +1,91 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "waveforms.h"
+#include "color_math.h"
+#include "bench.h"
+
+// Per-frame animation curves: soft-float / map() expressions against the
+// table math AnimationTimeline evaluates (ANIM_BREATHE, ANIM_LINEAR and
+// ANIM_GAMMA on the activation's 1 s fade-out). Frame times sweep 0-4 s
+// in 1 ms steps.
+
+static const uint16_t NUM_FRAMES = 4000;
+
+static uint8_t floatBreathe(unsigned long elapsed) {
+    float breathe = (sin(elapsed / 500.0) + 1.0) / 2.0;
+    return 150 + (breathe * 105);
+}
+
+static uint8_t tableBreathe(unsigned long elapsed) {
+    uint8_t breathe = waveSine8(wavePhase8(elapsed, waveCycleStep(BREATHE_PERIOD_MS)));
+    return waveScale8(breathe, 150, 255);
+}
+
+static uint8_t mapFade(unsigned long elapsed) {
+    return map(elapsed, 0, 1000, BRIGHTNESS, 0);
+}
+
+static uint8_t rampFade(unsigned long elapsed) {
+    return colorLerp8(BRIGHTNESS, 0, waveRamp8<1000>(elapsed));
+}
+
+static uint8_t powFade(unsigned long elapsed) {
+    return (uint8_t)(BRIGHTNESS * pow(1.0 - elapsed / 1000.0, 2.2) + 0.5);
+}
+
+static uint8_t gammaFade(unsigned long elapsed) {
+    return colorLerp8(BRIGHTNESS, 0, waveGammaRamp8(waveRamp8<1000>(elapsed), false));
+}
+
+BENCH_CASE(waveforms, "Animation curves: float/map vs tables") {
+    BenchStat floatStat("breathe: sin() float");
+    BenchStat tableStat("breathe: sine table");
+    BenchStat mapStat("linear fade: map()");
+    BenchStat rampStat("linear fade: ramp lerp");
+    BenchStat powStat("gamma fade: pow() float");
+    BenchStat gammaStat("gamma fade: gamma table");
+
+    int breatheError = 0;
+    int fadeError = 0;
+    int gammaError = 0;
+    for (unsigned long t = 0; t < NUM_FRAMES; t++) {
+        int e = abs((int)floatBreathe(t) - (int)tableBreathe(t));
+        if (e > breatheError) breatheError = e;
+        if (t <= 1000) {
+            e = abs((int)mapFade(t) - (int)rampFade(t));
+            if (e > fadeError) fadeError = e;
+            e = abs((int)powFade(t) - (int)gammaFade(t));
+            if (e > gammaError) gammaError = e;
+        }
+    }
+
+    // volatile input keeps the compiler from folding the sweep
+    volatile unsigned long offset = 0;
+    for (uint8_t pass = 0; pass < 50; pass++) {
+        uint32_t sum = 0;
+        BENCH_TIME_BATCH(floatStat, NUM_FRAMES,
+            for (unsigned long t = 0; t < NUM_FRAMES; t++) sum += floatBreathe(t + offset));
+        BENCH_TIME_BATCH(tableStat, NUM_FRAMES,
+            for (unsigned long t = 0; t < NUM_FRAMES; t++) sum += tableBreathe(t + offset));
+        BENCH_TIME_BATCH(mapStat, 1000,
+            for (unsigned long t = 0; t < 1000; t++) sum += mapFade(t + offset));
+        BENCH_TIME_BATCH(rampStat, 1000,
+            for (unsigned long t = 0; t < 1000; t++) sum += rampFade(t + offset));
+        BENCH_TIME_BATCH(powStat, 1000,
+            for (unsigned long t = 0; t < 1000; t++) sum += powFade(t + offset));
+        BENCH_TIME_BATCH(gammaStat, 1000,
+            for (unsigned long t = 0; t < 1000; t++) sum += gammaFade(t + offset));
+        benchKeep(sum);
+    }
+
+    floatStat.report();
+    tableStat.report();
+    mapStat.report();
+    rampStat.report();
+    powStat.report();
+    gammaStat.report();
+    printf("  max deviation: breathe %d, linear fade %d, gamma fade %d brightness steps\n",
+           breatheError, fadeError, gammaError);
+}
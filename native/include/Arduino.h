@@ -0,0 +1,95 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// Host stand-in for the Arduino core, backed by the virtual clock in sim.h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <avr/pgmspace.h>
+#include <avr/io.h>
+
+// Arduino Nano clock, for code that converts cycles to time
+#define F_CPU 16000000UL
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+// I2C pins on the Nano (A4/A5)
+#define SDA 18
+#define SCL 19
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define F(s) (s)
+
+// ===== Time =====
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// ===== Pins =====
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+
+// ===== Interrupts =====
+// External interrupts INT0/INT1 live on pins 2/3 as on the ATmega328
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+void noInterrupts();
+void interrupts();
+
+// ===== Math =====
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+// ===== Serial =====
+class HardwareSerial {
+public:
+    void begin(unsigned long baud);
+    operator bool() { return true; }
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    int availableForWrite();
+    int available();
+    int read();
+    void flush();
+
+    size_t print(const char *s);
+    size_t print(char c);
+    size_t print(int n) { return print((long)n); }
+    size_t print(unsigned int n) { return print((unsigned long)n); }
+    size_t print(long n);
+    size_t print(unsigned long n);
+    size_t print(double n, int digits = 2);
+
+    size_t println() { return print("\r\n"); }
+    template <typename T>
+    size_t println(T value) { size_t n = print(value); return n + println(); }
+};
+
+extern HardwareSerial Serial;
+
+#endif // SIM_ARDUINO_H
@@ -0,0 +1,87 @@
+#ifndef SIM_FASTLED_H
+#define SIM_FASTLED_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Host stand-in for the subset of FastLED used by the firmware.
+// show() captures the brightness-scaled frame for sim::lastFrame().
+
+struct CRGB {
+    union {
+        struct {
+            uint8_t r;
+            uint8_t g;
+            uint8_t b;
+        };
+        uint8_t raw[3];
+    };
+
+    enum HTMLColorCode {
+        Black = 0x000000,
+        Blue = 0x0000FF,
+        Gold = 0xFFD700,
+        Green = 0x008000,
+        Red = 0xFF0000,
+        White = 0xFFFFFF,
+    };
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+    CRGB(uint32_t colorcode)
+        : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b(colorcode & 0xFF) {}
+    CRGB(HTMLColorCode colorcode) : CRGB((uint32_t)colorcode) {}
+
+    bool operator==(const CRGB &rhs) const { return r == rhs.r && g == rhs.g && b == rhs.b; }
+    bool operator!=(const CRGB &rhs) const { return !(*this == rhs); }
+};
+
+enum EOrder { RGB = 0012, GRB = 0102 };
+
+template <uint8_t DATA_PIN, EOrder RGB_ORDER = GRB>
+class WS2812B {};
+
+// One strip: the pixel array show() sends, which can be swapped
+class CLEDController {
+public:
+    CLEDController() : data(nullptr), count(0) {}
+
+    CLEDController &setLeds(CRGB *leds, int numLeds) {
+        data = leds;
+        count = numLeds;
+        return *this;
+    }
+
+    CRGB *leds() { return data; }
+    int size() const { return count; }
+
+private:
+    CRGB *data;
+    int count;
+};
+
+class CFastLED {
+public:
+    CFastLED();
+
+    template <template <uint8_t, EOrder> class CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+    CLEDController &addLeds(CRGB *data, int numLeds) {
+        return attach(data, numLeds, DATA_PIN);
+    }
+
+    void setBrightness(uint8_t scale) { brightness = scale; }
+    uint8_t getBrightness() const { return brightness; }
+
+    void clear(bool writeData = false);
+    void show();
+
+private:
+    CLEDController controller;
+    uint8_t brightness;
+
+    CLEDController &attach(CRGB *data, int count, uint8_t pin);
+};
+
+extern CFastLED FastLED;
+
+#endif // SIM_FASTLED_H
@@ -0,0 +1,48 @@
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Host stand-in for the AVR TwoWire library. Transactions addressed to
+// the simulated MPU6050 (0x68) are routed to its register model; every
+// other address NACKs. Each call holds the virtual clock for its bus
+// time at the set clock, as the AVR library busy-waits on the TWI; bus
+// traffic is counted in sim::i2cBytesTransferred().
+class TwoWire {
+public:
+    TwoWire();
+
+    void begin();
+    void setClock(uint32_t clock) { clockHz = clock; }
+    uint32_t getClock() const { return clockHz; }
+
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t quantity);
+    uint8_t endTransmission(bool sendStop = true);
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+    int available();
+    int read();
+
+private:
+    static const uint8_t BUFFER_LENGTH = 32;
+
+    uint8_t txAddress;
+    uint8_t txBuffer[BUFFER_LENGTH];
+    uint8_t txLength;
+
+    uint8_t rxBuffer[BUFFER_LENGTH];
+    uint8_t rxLength;
+    uint8_t rxIndex;
+
+    uint32_t clockHz;
+
+    // Count one transaction of `bytes` bytes and hold the clock for it
+    void transfer(uint8_t bytes);
+};
+
+extern TwoWire Wire;
+
+#endif // SIM_WIRE_H
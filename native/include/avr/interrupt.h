@@ -0,0 +1,13 @@
+#ifndef SIM_AVR_INTERRUPT_H
+#define SIM_AVR_INTERRUPT_H
+
+#include <Arduino.h>
+
+// Host stand-in: an ISR is a plain function the virtual clock calls
+// when its interrupt fires (see timer_sim.cpp)
+#define ISR(vector) extern "C" void vector(void)
+
+#define cli() noInterrupts()
+#define sei() interrupts()
+
+#endif // SIM_AVR_INTERRUPT_H
@@ -0,0 +1,103 @@
+#ifndef AVR_IO_H
+#define AVR_IO_H
+
+#include <stdint.h>
+
+// Host stand-in for the ATmega328 timer registers used by the direct PWM
+// backend. The registers are plain memory; sim::timerPwmDuty() reads
+// back what a pin would output.
+extern volatile uint8_t TCCR0A, TCCR1A, TCCR2A;
+extern volatile uint8_t OCR0A, OCR0B;
+extern volatile uint8_t OCR1AL, OCR1BL;
+extern volatile uint8_t OCR2A, OCR2B;
+
+#define COM0A1 7
+#define COM0B1 5
+#define COM1A1 7
+#define COM1B1 5
+#define COM2A1 7
+#define COM2B1 5
+
+#ifndef _BV
+#define _BV(bit) (1 << (bit))
+#endif
+
+// Timer2 in CTC mode with the compare-match A interrupt, as the BAM
+// backend uses it. The virtual clock counts it at the prescaled rate and
+// calls TIMER2_COMPA_vect (<avr/interrupt.h>) on each match.
+extern volatile uint8_t TCCR2B, TIMSK2, TCNT2;
+
+#define WGM21 1
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define OCIE2A 1
+
+// Timer0 compare-match A interrupt. Timer0 keeps running for millis()
+// (fast PWM, prescaler 64: one cycle per 1024 us); with OCIE0A set the
+// virtual clock calls TIMER0_COMPA_vect once per cycle, OCR0A * 4 us in.
+extern volatile uint8_t TIMSK0;
+
+#define OCIE0A 1
+
+// Two-wire interface (I2C master). Writing TWCR with TWINT set starts the
+// next bus action; the virtual clock completes it at the bit rate set by
+// TWBR and the TWSR prescaler, then sets TWINT and the status in TWSR
+// (<util/twi.h>) and calls TWI_vect if TWIE is set. The MPU6050 model
+// answers at 0x68. Clearing TWEN aborts whatever is in progress.
+struct SimTwiControl {
+    uint8_t value;
+
+    operator uint8_t() const { return value; }
+    SimTwiControl &operator=(uint8_t v);
+    SimTwiControl &operator|=(uint8_t v) { return *this = value | v; }
+    SimTwiControl &operator&=(uint8_t v) { return *this = value & v; }
+};
+
+extern SimTwiControl TWCR;
+extern volatile uint8_t TWBR, TWSR, TWDR;
+
+#define TWINT 7
+#define TWEA 6
+#define TWSTA 5
+#define TWSTO 4
+#define TWWC 3
+#define TWEN 2
+#define TWIE 0
+#define TWPS1 1
+#define TWPS0 0
+
+// GPIO ports. Writes are observed, so the simulator can track pin levels
+// and clock the 74HC595 latch; plain memory otherwise.
+struct SimPort {
+    uint8_t index;
+    uint8_t value;
+
+    operator uint8_t() const { return value; }
+    SimPort &operator=(uint8_t v);
+    SimPort &operator|=(uint8_t v) { return *this = value | v; }
+    SimPort &operator&=(uint8_t v) { return *this = value & v; }
+    SimPort &operator^=(uint8_t v) { return *this = value ^ v; }
+};
+
+extern SimPort PORTB, PORTC, PORTD;
+extern volatile uint8_t DDRB, DDRC, DDRD;
+
+// Hardware SPI master. A write to SPDR shifts the byte out at once and
+// sets SPIF.
+struct SimSpiData {
+    uint8_t value;
+
+    operator uint8_t() const { return value; }
+    SimSpiData &operator=(uint8_t v);
+};
+
+extern SimSpiData SPDR;
+extern volatile uint8_t SPCR, SPSR;
+
+#define SPE 6
+#define MSTR 4
+#define SPIF 7
+#define SPI2X 0
+
+#endif // AVR_IO_H
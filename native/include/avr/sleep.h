@@ -0,0 +1,17 @@
+#ifndef SIM_AVR_SLEEP_H
+#define SIM_AVR_SLEEP_H
+
+#include <stdint.h>
+
+// Host stand-in for the AVR sleep API. sleep_cpu() with SE set runs the
+// virtual clock until an interrupt is serviced; in power-down,
+// millis()/micros() stand still meanwhile, as Timer0 does on the chip.
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_PWR_DOWN 2
+
+void set_sleep_mode(uint8_t mode);
+void sleep_enable();
+void sleep_disable();
+void sleep_cpu();
+
+#endif // SIM_AVR_SLEEP_H
@@ -0,0 +1,130 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+// Host-side simulator controls for the `native` environment.
+// The firmware sees a virtual clock through millis()/micros()/delay(),
+// a scriptable MPU6050 and captured LED output. Benchmarks and tools
+// drive everything through this header.
+namespace sim {
+
+// ===== Virtual clock =====
+// Time only moves when delay()/delayMicroseconds() is called or when
+// the host advances it explicitly, so runs are fully deterministic.
+uint64_t nowMicros();
+void setMicros(uint64_t us);
+void advanceMicros(uint64_t us);
+inline void advanceMillis(uint32_t ms) { advanceMicros((uint64_t)ms * 1000); }
+
+// Virtual time spent in power-down sleep, and the number of sleeps.
+// millis()/micros() don't advance while powered down (Timer0 stops),
+// so after the first sleep they run behind nowMicros().
+uint64_t powerDownMicros();
+uint32_t powerDownCount();
+
+// ===== MPU6050 feed =====
+// Physical sensor state: acceleration in g, angular rate in deg/s
+struct ImuState {
+    float ax, ay, az;
+    float gx, gy, gz;
+};
+
+// A feed returns the sensor state at a given virtual time
+typedef ImuState (*ImuFeed)(uint64_t us, void *context);
+
+void setImuFeed(ImuFeed feed, void *context = nullptr);
+
+// Pin the MPU6050 INT output is wired to (default 2). While the sensor
+// is awake it samples on its own clock; the virtual clock delivers each
+// sample (FIFO push + INT pulse) at its exact time.
+void setImuIntPin(uint8_t pin);
+uint32_t imuSamplesGenerated();
+void setImuConnected(bool connected);
+bool isImuConnected();
+ImuState readImu();
+
+// Static pose with the hand pitched `pitchDeg` above horizontal
+ImuState handAtPitch(float pitchDeg);
+
+// ===== I2C =====
+// Traffic through Wire or the TWI registers: bytes moved (address bytes
+// included), transactions (one per START) and the SCL clock of the last
+// one. A Wire call holds the virtual clock for its bus time (9 bits per
+// byte plus the START), as the AVR library busy-waits; a TWI transfer
+// runs alongside the firmware, one interrupt per byte.
+uint32_t i2cBytesTransferred();
+uint32_t i2cTransactions();
+uint32_t i2cClockHz();
+
+// A slave holding SDA low: TWI actions stop completing until released
+// (Wire is not affected)
+void setTwiStuck(bool stuck);
+
+// A handler set here runs instead of the firmware's TWI_vect (nullptr
+// restores the firmware's)
+void setTwiHandler(void (*handler)());
+
+// ===== Pins =====
+const uint8_t NUM_PINS = 20;
+
+uint8_t pinValue(uint8_t pin);        // Last analogWrite/digitalWrite value
+uint32_t pinWriteCount(uint8_t pin);  // Number of writes to this pin
+
+// Duty a PWM pin outputs under direct timer-register control
+// (0 while the pin is disconnected from its compare unit)
+uint8_t timerPwmDuty(uint8_t pin);
+
+// Time a pin has spent high through PORTB/C/D writes
+uint64_t pinHighMicros(uint8_t pin);
+
+// ===== Timer2 =====
+// In CTC mode with OCIE2A set, Timer2 calls TIMER2_COMPA_vect on each
+// compare match, counted at the prescaled rate on the virtual clock.
+// A handler set here runs instead (nullptr restores the firmware's).
+void setTimer2Handler(void (*handler)());
+uint32_t timer2MatchCount();
+
+// ===== 74HC595 chain =====
+// Registers on hardware SPI (MOSI 11, SCK 13), register 0 nearest the
+// MCU, all latched by a rising edge on pin 10
+uint8_t shiftRegisterOutput(uint8_t reg);
+
+// Time output Q(output % 8) of register output / 8 has spent high
+uint64_t shiftOutputHighMicros(uint16_t output);
+
+// ===== FastLED capture =====
+struct LedFrame {
+    const uint8_t *rgb;     // NUM_LEDS * 3 bytes, scaled by brightness
+    uint16_t numLeds;
+    uint8_t brightness;
+    uint32_t showCount;     // Number of FastLED.show() calls so far
+};
+
+LedFrame lastFrame();
+
+// ===== Serial =====
+// When echo is off (default) serial output is counted and discarded
+void setSerialEcho(bool echo);
+uint32_t serialBytesWritten();
+
+// After Serial.begin(baud) the UART is modelled: writes fill the 64-byte
+// TX buffer, which empties at the baud rate on the virtual clock, and a
+// write to a full buffer blocks (advances the clock) like the AVR core.
+// Before begin() output is instantaneous.
+uint64_t serialBlockedMicros();
+
+// Copy serial output into `buffer` (up to `size` bytes; nullptr stops)
+void setSerialCapture(uint8_t *buffer, uint32_t size);
+uint32_t serialCapturedBytes();
+
+// Bytes for Serial.read() to return, as if typed into the port monitor
+// (the text must stay valid until read; nullptr clears)
+void setSerialInput(const char *text);
+
+// Reset clock, pins, captured frames and sensor feed
+void reset();
+
+} // namespace sim
+
+#endif // SIM_H
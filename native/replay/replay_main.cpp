@@ -0,0 +1,315 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "config.h"
+#include "imu_trace.h"
+#include "motion_detector.h"
+#include "sim.h"
+
+#ifdef LED_TYPE_FASTLED
+#include "fastled_facade.h"
+typedef FastLEDFacade LEDFacadeType;
+#elif defined(F5_BAM)
+#include "bam_facade.h"
+typedef BAMFacade LEDFacadeType;
+#elif defined(F5_DIRECT_PWM)
+#include "timer_pwm_facade.h"
+typedef TimerPWMFacade LEDFacadeType;
+#else
+#include "f5led_facade.h"
+typedef F5LEDFacade LEDFacadeType;
+#endif
+
+// Host replay of captured IMU traces (see imu_trace.h).
+//
+// Usage:
+//   program <trace.imt>                       replay through main_unified
+//   program --synthesize <out.imt> [seconds]  write a scripted hand-raise trace
+//
+// The trace drives the simulated MPU6050 on the virtual clock while the
+// unmodified setup()/loop() run. Reports each activation with its latency
+// from the sample where the reference pitch first crossed ACTIVATION_ANGLE
+// to the activation and to the first LED frame, then times
+// MotionDetector::isHandRaised() once per recorded sample.
+
+// Entry points and state from main_unified.cpp
+void setup();
+void loop();
+extern bool isActive;
+extern MotionDetector motionDetector;
+extern LEDFacadeType ledFacade;
+
+struct TraceSample {
+    uint64_t us;            // Since the first record
+    MotionSample sample;
+};
+
+static std::vector<TraceSample> samples;
+static size_t traceBytes = 0;
+static float accelPerG = 16384.0f;
+static float gyroPerDps = 131.0f;
+
+// Virtual time of the trace's first sample
+static uint64_t traceStart = 0;
+
+static bool loadTrace(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + got);
+    }
+    fclose(file);
+    traceBytes = data.size();
+
+    ImuTraceDecoder decoder;
+    size_t offset = decoder.readHeader(data.data(), data.size());
+    if (offset == 0) {
+        fprintf(stderr, "%s is not an IMU trace\n", path);
+        return false;
+    }
+    accelPerG = (float)(16384 >> decoder.header().accelRange);
+    gyroPerDps = 131.0f / (float)(1 << decoder.header().gyroRange);
+
+    // Unwrap the 32-bit device clock
+    ImuTraceRecord record;
+    uint32_t lastMicros = 0;
+    uint64_t now = 0;
+    size_t used;
+    while ((used = decoder.decode(data.data() + offset, data.size() - offset, record)) > 0) {
+        offset += used;
+        if (!samples.empty()) {
+            now += (uint32_t)(record.micros - lastMicros);
+        }
+        lastMicros = record.micros;
+        samples.push_back({ now, record.sample });
+    }
+    if (offset != data.size()) {
+        fprintf(stderr, "warning: %zu trailing bytes (truncated record)\n", data.size() - offset);
+    }
+    return !samples.empty();
+}
+
+// Sample-and-hold: the most recent recorded sample at virtual time `us`
+static const MotionSample &sampleAt(uint64_t us) {
+    uint64_t t = us > traceStart ? us - traceStart : 0;
+    auto next = std::upper_bound(samples.begin(), samples.end(), t,
+                                 [](uint64_t value, const TraceSample &s) { return value < s.us; });
+    return next == samples.begin() ? samples.front().sample : (next - 1)->sample;
+}
+
+static sim::ImuState traceFeed(uint64_t us, void *) {
+    const MotionSample &s = sampleAt(us);
+    sim::ImuState state;
+    state.ax = s.ax / accelPerG;
+    state.ay = s.ay / accelPerG;
+    state.az = s.az / accelPerG;
+    state.gx = s.gx / gyroPerDps;
+    state.gy = s.gy / gyroPerDps;
+    state.gz = s.gz / gyroPerDps;
+    return state;
+}
+
+// Trace times where the float reference pitch rises above ACTIVATION_ANGLE
+static std::vector<uint64_t> referenceCrossings() {
+    std::vector<uint64_t> crossings;
+    bool above = false;
+    for (const TraceSample &s : samples) {
+        bool now = MotionDetector::calculatePitch(s.sample.ax, s.sample.ay, s.sample.az) >
+                   ACTIVATION_ANGLE;
+        if (now && !above) {
+            crossings.push_back(s.us);
+        }
+        above = now;
+    }
+    return crossings;
+}
+
+static void replayFirmware() {
+    std::vector<uint64_t> crossings = referenceCrossings();
+    uint64_t duration = samples.back().us;
+
+    sim::reset();
+    sim::setImuFeed(traceFeed);
+    traceStart = UINT64_MAX;
+    setup();
+    traceStart = sim::nowMicros();
+
+    printf("\nActivations:\n");
+    bool wasActive = false;
+    bool awaitingFrame = false;
+    uint32_t framesAtActivation = 0;
+    uint64_t activationUs = 0;
+    uint32_t activations = 0;
+    size_t matched = 0;
+    size_t nextCrossing = 0;
+    double latencySumMs = 0.0;
+
+    while (sim::nowMicros() < traceStart + duration) {
+        loop();
+        uint64_t t = sim::nowMicros() - traceStart;
+
+        if (isActive && !wasActive) {
+            activations++;
+            activationUs = t;
+            framesAtActivation = ledFacade.getCommittedFrames();
+            awaitingFrame = true;
+        }
+        wasActive = isActive;
+
+        if (awaitingFrame && ledFacade.getCommittedFrames() != framesAtActivation) {
+            awaitingFrame = false;
+
+            // Latest reference crossing before this activation
+            while (nextCrossing < crossings.size() && crossings[nextCrossing] <= activationUs) {
+                nextCrossing++;
+            }
+            printf("  #%-3u at %8.3f s", activations, activationUs / 1e6);
+            if (nextCrossing > 0 && activationUs - crossings[nextCrossing - 1] < 2000000) {
+                uint64_t crossing = crossings[nextCrossing - 1];
+                double latencyMs = (activationUs - crossing) / 1000.0;
+                latencySumMs += latencyMs;
+                matched++;
+                printf("  activation +%6.1f ms, first frame +%6.1f ms after the pitch crossed\n",
+                       latencyMs, (t - crossing) / 1000.0);
+            } else {
+                printf("  (no reference crossing in the last 2 s), first frame +%.1f ms\n",
+                       (t - activationUs) / 1000.0);
+            }
+        }
+    }
+
+    printf("  %u activations, %zu reference crossings", activations, crossings.size());
+    if (matched) {
+        printf(", mean activation latency %.1f ms", latencySumMs / matched);
+    }
+    printf("\n");
+}
+
+// Per-sample cost of the detector, each recorded sample read once
+static void timeDetector() {
+    sim::reset();
+    sim::setImuFeed(traceFeed);
+    traceStart = UINT64_MAX;
+    motionDetector.begin();
+    traceStart = sim::nowMicros();
+
+    double totalNs = 0.0, minNs = 0.0, maxNs = 0.0;
+    uint32_t triggered = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        uint64_t target = traceStart + samples[i].us;
+        if (target > sim::nowMicros()) {
+            sim::advanceMicros(target - sim::nowMicros());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        bool raised = motionDetector.isHandRaised();
+        auto end = std::chrono::steady_clock::now();
+        double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+        triggered += raised;
+        totalNs += ns;
+        if (i == 0 || ns < minNs) minNs = ns;
+        if (i == 0 || ns > maxNs) maxNs = ns;
+    }
+
+    printf("\nisHandRaised() per sample: mean %.1f ns, min %.1f ns, max %.1f ns (%u triggers)\n",
+           totalNs / samples.size(), minNs, maxNs, triggered);
+}
+
+// ===== Synthetic trace =====
+
+static float noise() {
+    return (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+static int16_t toCounts(float value, float perUnit) {
+    float counts = value * perUnit;
+    if (counts > 32767.0f) return 32767;
+    if (counts < -32768.0f) return -32768;
+    return (int16_t)lroundf(counts);
+}
+
+// Hand flat, raised to 70 degrees over 300 ms every 6 seconds, held for a
+// second and lowered, with sensor noise and a little polling jitter
+static int synthesize(const char *path, float seconds) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "cannot create %s\n", path);
+        return 1;
+    }
+
+    const uint32_t period = 1000000UL / SAMPLE_RATE;
+    ImuTraceEncoder encoder(period);
+    uint8_t buffer[IMU_TRACE_MAX_RECORD];
+    fwrite(buffer, 1, encoder.writeHeader(buffer, MPU6050_ACCEL_2G, MPU6050_GYRO_250DPS), file);
+
+    srand(1);
+    size_t bytes = IMU_TRACE_HEADER_SIZE;
+    uint32_t count = 0;
+    for (uint64_t us = 0; us < (uint64_t)(seconds * 1e6f); us += period) {
+        unsigned long stamp = (unsigned long)(us + 150000 + (rand() % 400));
+        uint32_t t = (uint32_t)((us / 1000) % 6000);
+        float pitch = 0.0f;
+        float rate = 0.0f;
+        if (t >= 2000 && t < 2300) {
+            pitch = 70.0f * (t - 2000) / 300.0f;
+            rate = 70.0f / 0.3f;
+        } else if (t >= 2300 && t < 3300) {
+            pitch = 70.0f;
+        } else if (t >= 3300 && t < 3600) {
+            pitch = 70.0f * (3600 - t) / 300.0f;
+            rate = -70.0f / 0.3f;
+        }
+
+        sim::ImuState s = sim::handAtPitch(pitch);
+        MotionSample m;
+        m.ax = toCounts(s.ax + 0.01f * noise(), 16384.0f);
+        m.ay = toCounts(s.ay + 0.01f * noise(), 16384.0f);
+        m.az = toCounts(s.az + 0.01f * noise(), 16384.0f);
+        m.gx = toCounts(0.5f * noise(), 131.0f);
+        m.gy = toCounts(rate + 0.5f * noise(), 131.0f);
+        m.gz = toCounts(0.5f * noise(), 131.0f);
+
+        uint8_t n = encoder.encode(m, stamp, buffer);
+        fwrite(buffer, 1, n, file);
+        bytes += n;
+        count++;
+    }
+    fclose(file);
+    printf("wrote %u samples, %zu bytes (%.1f bytes/sample) to %s\n", count, bytes,
+           (double)(bytes - IMU_TRACE_HEADER_SIZE) / count, path);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 3 && strcmp(argv[1], "--synthesize") == 0) {
+        return synthesize(argv[2], argc >= 4 ? (float)atof(argv[3]) : 30.0f);
+    }
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <trace.imt>\n       %s --synthesize <out.imt> [seconds]\n",
+                argv[0], argv[0]);
+        return 2;
+    }
+    if (!loadTrace(argv[1])) {
+        return 1;
+    }
+
+    double seconds = samples.back().us / 1e6;
+    printf("Trace %s: %zu samples over %.2f s (%.1f Hz), %.1f bytes/sample\n", argv[1],
+           samples.size(), seconds, seconds > 0 ? (samples.size() - 1) / seconds : 0.0,
+           (double)(traceBytes - IMU_TRACE_HEADER_SIZE) / samples.size());
+
+    replayFirmware();
+    timeDetector();
+    return 0;
+}
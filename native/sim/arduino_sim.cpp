@@ -0,0 +1,432 @@
+#include <Arduino.h>
+#include <avr/sleep.h>
+#include <stdio.h>
+#include "sim.h"
+#include "sim_internal.h"
+
+// ===== Virtual clock =====
+
+static uint64_t virtualMicros = 0;
+
+// Time spent in power-down, invisible to millis()/micros()
+static uint64_t frozenMicros = 0;
+static uint64_t powerDownTotal = 0;
+static uint32_t powerDowns = 0;
+static uint8_t sleepMode = SLEEP_MODE_IDLE;
+static bool sleepEnabled = false;
+
+namespace sim {
+
+uint64_t nowMicros() {
+    return virtualMicros;
+}
+
+uint64_t timer0Micros() {
+    return virtualMicros - frozenMicros;
+}
+
+void setMicros(uint64_t us) {
+    virtualMicros = us;
+}
+
+void advanceMicros(uint64_t us) {
+    uint64_t target = virtualMicros + us;
+    
+    // Step through device events so each fires at its own timestamp
+    // (ties: sensor clock, Timer2, Timer0, then the TWI)
+    for (;;) {
+        uint64_t mpuNext = mpuNextEventMicros();
+        uint64_t timerNext = timer2NextEventMicros();
+        uint64_t tickNext = timer0NextEventMicros();
+        uint64_t twiNext = twiNextEventMicros();
+        uint64_t next = timerNext < mpuNext ? timerNext : mpuNext;
+        if (tickNext < next) next = tickNext;
+        if (twiNext < next) next = twiNext;
+        if (next > target) break;
+        if (next > virtualMicros) virtualMicros = next;
+        if (mpuNext == next) {
+            mpuTick();
+        } else if (timerNext == next) {
+            timer2Tick();
+        } else if (tickNext == next) {
+            timer0Tick();
+        } else {
+            twiTick();
+        }
+    }
+    virtualMicros = target;
+}
+
+} // namespace sim
+
+unsigned long millis() {
+    return (unsigned long)((virtualMicros - frozenMicros) / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)(virtualMicros - frozenMicros);
+}
+
+void delay(unsigned long ms) {
+    sim::advanceMicros((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    sim::advanceMicros(us);
+}
+
+// ===== Pins =====
+
+static uint8_t pinModes[sim::NUM_PINS];
+static uint8_t pinValues[sim::NUM_PINS];
+static uint32_t pinWrites[sim::NUM_PINS];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < sim::NUM_PINS) pinModes[pin] = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin >= sim::NUM_PINS) return;
+    pinValues[pin] = val ? 255 : 0;
+    pinWrites[pin]++;
+}
+
+int digitalRead(uint8_t pin) {
+    if (pin >= sim::NUM_PINS) return LOW;
+    return pinValues[pin] ? HIGH : LOW;
+}
+
+void analogWrite(uint8_t pin, int val) {
+    if (pin >= sim::NUM_PINS) return;
+    pinValues[pin] = (uint8_t)(val < 0 ? 0 : (val > 255 ? 255 : val));
+    pinWrites[pin]++;
+}
+
+// ===== Interrupts =====
+
+static void (*interruptHandlers[2])(void);
+static int interruptModes[2];
+static bool interruptsEnabled = true;
+static bool interruptPending[2];
+static uint32_t interruptsServiced = 0;
+
+static void serviceInterrupt(uint8_t num) {
+    interruptsServiced++;
+    interruptHandlers[num]();
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode) {
+    if (interruptNum >= 2) return;
+    interruptHandlers[interruptNum] = userFunc;
+    interruptModes[interruptNum] = mode;
+    interruptPending[interruptNum] = false;
+
+    // A low-level interrupt fires as soon as it is enabled on a low pin
+    if (mode == LOW && pinValues[interruptNum == 0 ? 2 : 3] == 0) {
+        if (interruptsEnabled) {
+            serviceInterrupt(interruptNum);
+        } else {
+            interruptPending[interruptNum] = true;
+        }
+    }
+}
+
+void detachInterrupt(uint8_t interruptNum) {
+    if (interruptNum >= 2) return;
+    interruptHandlers[interruptNum] = nullptr;
+}
+
+void noInterrupts() {
+    interruptsEnabled = false;
+}
+
+void interrupts() {
+    interruptsEnabled = true;
+    // Latched requests run as soon as the global enable returns
+    for (uint8_t i = 0; i < 2; i++) {
+        if (interruptPending[i] && interruptHandlers[i]) {
+            interruptPending[i] = false;
+            serviceInterrupt(i);
+        }
+    }
+    sim::serviceTimerPending();
+    sim::serviceTwiPending();
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// ===== Serial =====
+
+HardwareSerial Serial;
+
+static bool serialEcho = false;
+static uint32_t serialBytes = 0;
+static uint8_t *serialCapture = nullptr;
+static uint32_t serialCaptureSize = 0;
+static uint32_t serialCaptured = 0;
+static const char *serialInput = nullptr;
+
+// UART model (nanoseconds, so 86.8 us bytes at 115200 don't drift)
+static const uint32_t SERIAL_TX_BUFFER = 64;    // 63 usable, as in the AVR core
+static uint64_t serialByteNs = 0;               // 0 until begin()
+static uint64_t serialIdleAtNs = 0;             // When the last queued byte is out
+static uint64_t serialBlocked = 0;
+
+// Bytes written but not yet fully shifted out (buffer + shift register)
+static uint32_t serialUnsent() {
+    uint64_t now = virtualMicros * 1000;
+    if (serialByteNs == 0 || serialIdleAtNs <= now) return 0;
+    return (uint32_t)((serialIdleAtNs - now + serialByteNs - 1) / serialByteNs);
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+    serialByteNs = baud ? 10000000000ULL / baud : 0;   // 8N1: 10 bits per byte
+    serialIdleAtNs = 0;
+}
+
+void HardwareSerial::flush() {
+    // Wait for the last byte to leave the shift register
+    uint64_t now = virtualMicros * 1000;
+    if (serialIdleAtNs > now) {
+        sim::advanceMicros((serialIdleAtNs - now + 999) / 1000);
+    }
+}
+
+int HardwareSerial::availableForWrite() {
+    uint32_t unsent = serialUnsent();
+    uint32_t buffered = unsent > 0 ? unsent - 1 : 0;
+    return (int)(SERIAL_TX_BUFFER - 1 - buffered);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    if (serialByteNs != 0) {
+        // Full buffer: spin until the shift register takes the next byte
+        if (availableForWrite() == 0) {
+            uint64_t freeAtNs = serialIdleAtNs - (SERIAL_TX_BUFFER - 1) * serialByteNs;
+            uint64_t waitUs = (freeAtNs + 999) / 1000 - virtualMicros;
+            serialBlocked += waitUs;
+            sim::advanceMicros(waitUs);
+        }
+        uint64_t now = virtualMicros * 1000;
+        serialIdleAtNs = (serialIdleAtNs > now ? serialIdleAtNs : now) + serialByteNs;
+    }
+
+    serialBytes++;
+    if (serialCapture && serialCaptured < serialCaptureSize) {
+        serialCapture[serialCaptured++] = c;
+    }
+    if (serialEcho) fputc(c, stdout);
+    return 1;
+}
+
+int HardwareSerial::available() {
+    return serialInput ? (int)strlen(serialInput) : 0;
+}
+
+int HardwareSerial::read() {
+    if (!serialInput || !*serialInput) return -1;
+    return (uint8_t)*serialInput++;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+    for (size_t i = 0; i < size; i++) write(buffer[i]);
+    return size;
+}
+
+size_t HardwareSerial::print(const char *s) {
+    return write((const uint8_t *)s, strlen(s));
+}
+
+size_t HardwareSerial::print(char c) {
+    return write((uint8_t)c);
+}
+
+size_t HardwareSerial::print(long n) {
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%ld", n);
+    return print(buffer);
+}
+
+size_t HardwareSerial::print(unsigned long n) {
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%lu", n);
+    return print(buffer);
+}
+
+size_t HardwareSerial::print(double n, int digits) {
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, n);
+    return print(buffer);
+}
+
+namespace sim {
+
+uint8_t pinValue(uint8_t pin) {
+    return pin < NUM_PINS ? pinValues[pin] : 0;
+}
+
+uint32_t pinWriteCount(uint8_t pin) {
+    return pin < NUM_PINS ? pinWrites[pin] : 0;
+}
+
+void setPinLevel(uint8_t pin, bool high) {
+    if (pin < NUM_PINS) pinValues[pin] = high ? 255 : 0;
+}
+
+bool interruptsOn() {
+    return interruptsEnabled;
+}
+
+void setSerialEcho(bool echo) {
+    serialEcho = echo;
+}
+
+uint32_t serialBytesWritten() {
+    return serialBytes;
+}
+
+uint64_t serialBlockedMicros() {
+    return serialBlocked;
+}
+
+void setSerialCapture(uint8_t *buffer, uint32_t size) {
+    serialCapture = buffer;
+    serialCaptureSize = buffer ? size : 0;
+    serialCaptured = 0;
+}
+
+uint32_t serialCapturedBytes() {
+    return serialCaptured;
+}
+
+void setSerialInput(const char *text) {
+    serialInput = text;
+}
+
+void raisePinEdge(uint8_t pin, bool rising) {
+    int num = digitalPinToInterrupt(pin);
+    if (pin < NUM_PINS) pinValues[pin] = rising ? 255 : 0;
+    if (num < 0 || !interruptHandlers[num]) return;
+
+    // LOW fires once on the falling edge (handlers detach themselves)
+    int mode = interruptModes[num];
+    bool match = mode == CHANGE || (mode == RISING && rising) ||
+                 ((mode == FALLING || mode == LOW) && !rising);
+    if (!match) return;
+
+    if (interruptsEnabled) {
+        serviceInterrupt(num);
+    } else {
+        interruptPending[num] = true;
+    }
+}
+
+void resetInterrupts() {
+    for (uint8_t i = 0; i < 2; i++) {
+        interruptHandlers[i] = nullptr;
+        interruptPending[i] = false;
+    }
+    interruptsEnabled = true;
+}
+
+uint64_t powerDownMicros() {
+    return powerDownTotal;
+}
+
+uint32_t powerDownCount() {
+    return powerDowns;
+}
+
+void reset() {
+    virtualMicros = 0;
+    frozenMicros = 0;
+    powerDownTotal = 0;
+    powerDowns = 0;
+    sleepMode = SLEEP_MODE_IDLE;
+    sleepEnabled = false;
+    resetInterrupts();
+    memset(pinModes, 0, sizeof(pinModes));
+    memset(pinValues, 0, sizeof(pinValues));
+    memset(pinWrites, 0, sizeof(pinWrites));
+    serialBytes = 0;
+    serialByteNs = 0;
+    serialIdleAtNs = 0;
+    serialBlocked = 0;
+    serialCapture = nullptr;
+    serialCaptureSize = 0;
+    serialCaptured = 0;
+    serialInput = nullptr;
+    resetMpu6050();
+    resetFastLED();
+    resetTimers();
+    resetTwi();
+    resetGpio();
+}
+
+} // namespace sim
+
+// ===== Sleep =====
+
+void set_sleep_mode(uint8_t mode) {
+    sleepMode = mode;
+}
+
+void sleep_enable() {
+    sleepEnabled = true;
+}
+
+void sleep_disable() {
+    sleepEnabled = false;
+}
+
+void sleep_cpu() {
+    if (!sleepEnabled) return;
+
+    // Only device events can wake the CPU; with none scheduled it would
+    // sleep forever. Timers 0 and 2 and the TWI run in idle sleep and
+    // stop in power-down; in idle sleep the Timer0 overflow (millis())
+    // wakes the CPU every 1024 us even with nothing else enabled.
+    uint32_t serviced = interruptsServiced;
+    uint64_t start = virtualMicros;
+    bool powerDown = sleepMode == SLEEP_MODE_PWR_DOWN;
+    while (interruptsServiced == serviced) {
+        uint64_t mpuNext = sim::mpuNextEventMicros();
+        uint64_t timerNext = powerDown ? UINT64_MAX : sim::timer2NextEventMicros();
+        uint64_t tickNext = powerDown ? UINT64_MAX : sim::timer0NextEventMicros();
+        uint64_t twiNext = powerDown ? UINT64_MAX : sim::twiNextEventMicros();
+        uint64_t overflowNext = powerDown ? UINT64_MAX : sim::timer0NextOverflowMicros();
+        if (mpuNext == UINT64_MAX && timerNext == UINT64_MAX && overflowNext == UINT64_MAX) {
+            fprintf(stderr, "sim: sleep_cpu() with no wake-up source\n");
+            exit(1);
+        }
+        uint64_t next = timerNext < mpuNext ? timerNext : mpuNext;
+        if (tickNext < next) next = tickNext;
+        if (twiNext < next) next = twiNext;
+        if (overflowNext < next) next = overflowNext;
+        if (next > virtualMicros) virtualMicros = next;
+        
+        // Ties: sensor clock, Timer2, Timer0, TWI, then the overflow
+        if (mpuNext == next) {
+            sim::mpuTick();
+        } else if (timerNext == next) {
+            sim::timer2Tick();
+            if (interruptsEnabled) break;
+        } else if (tickNext == next) {
+            sim::timer0Tick();
+            if (interruptsEnabled) break;
+        } else if (twiNext == next) {
+            if (sim::twiTick() && interruptsEnabled) break;
+        } else if (interruptsEnabled) {
+            break;
+        }
+    }
+
+    if (powerDown) {
+        sim::timer2Pause(virtualMicros - start);
+        frozenMicros += virtualMicros - start;
+        powerDownTotal += virtualMicros - start;
+        powerDowns++;
+    }
+}
@@ -0,0 +1,68 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "sim.h"
+#include "sim_internal.h"
+
+CFastLED FastLED;
+
+static uint8_t capturedFrame[256 * 3];
+static uint16_t capturedLeds = 0;
+static uint8_t capturedBrightness = 0;
+static uint32_t showCount = 0;
+
+CFastLED::CFastLED() : brightness(255) {
+}
+
+CLEDController &CFastLED::attach(CRGB *data, int count, uint8_t pin) {
+    (void)pin;
+    return controller.setLeds(data, count);
+}
+
+void CFastLED::clear(bool writeData) {
+    if (controller.leds()) {
+        memset((void *)controller.leds(), 0, sizeof(CRGB) * controller.size());
+    }
+    if (writeData) show();
+}
+
+void CFastLED::show() {
+    // Capture what would go out on the data line: pixels scaled by
+    // global brightness the way FastLED's scale8 does it
+    CRGB *leds = controller.leds();
+    int numLeds = controller.size();
+    capturedLeds = numLeds > 256 ? 256 : (uint16_t)numLeds;
+    capturedBrightness = brightness;
+    for (uint16_t i = 0; i < capturedLeds; i++) {
+        for (uint8_t c = 0; c < 3; c++) {
+            capturedFrame[i * 3 + c] =
+                (uint8_t)(((uint16_t)leds[i].raw[c] * (1 + (uint16_t)brightness)) >> 8);
+        }
+    }
+    showCount++;
+
+    // The data line is bit-banged with interrupts off: 24 bits at
+    // 800 kHz per LED, then the 50 us latch
+    noInterrupts();
+    sim::advanceMicros((uint64_t)numLeds * 30 + 50);
+    interrupts();
+}
+
+namespace sim {
+
+LedFrame lastFrame() {
+    LedFrame frame;
+    frame.rgb = capturedFrame;
+    frame.numLeds = capturedLeds;
+    frame.brightness = capturedBrightness;
+    frame.showCount = showCount;
+    return frame;
+}
+
+void resetFastLED() {
+    memset(capturedFrame, 0, sizeof(capturedFrame));
+    capturedLeds = 0;
+    capturedBrightness = 0;
+    showCount = 0;
+}
+
+} // namespace sim
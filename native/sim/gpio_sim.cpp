@@ -0,0 +1,123 @@
+#include <Arduino.h>
+#include "sim.h"
+#include "sim_internal.h"
+
+// ===== Ports =====
+// Nano pins: 0-7 on PORTD, 8-13 on PORTB, 14-19 (A0-A5) on PORTC
+
+SimPort PORTB = { 0, 0 };
+SimPort PORTC = { 1, 0 };
+SimPort PORTD = { 2, 0 };
+volatile uint8_t DDRB, DDRC, DDRD;
+
+static const uint8_t PORT_FIRST_PIN[3] = { 8, 14, 0 };
+static const uint8_t PORT_PINS[3] = { 6, 6, 8 };
+
+static uint64_t pinHighSince[sim::NUM_PINS];
+static uint64_t pinHighTotal[sim::NUM_PINS];
+static bool pinHigh[sim::NUM_PINS];
+
+// ===== 74HC595 chain =====
+
+static const uint8_t MAX_SHIFT_REGISTERS = 32;
+static const uint8_t LATCH_PIN = 10;
+
+SimSpiData SPDR = { 0 };
+volatile uint8_t SPCR, SPSR;
+
+static uint8_t shiftStage[MAX_SHIFT_REGISTERS];
+static uint8_t shiftOutput[MAX_SHIFT_REGISTERS];
+static uint64_t outputHighSince[MAX_SHIFT_REGISTERS * 8];
+static uint64_t outputHighTotal[MAX_SHIFT_REGISTERS * 8];
+
+static void latchShiftRegisters() {
+    uint64_t now = sim::nowMicros();
+    for (uint8_t r = 0; r < MAX_SHIFT_REGISTERS; r++) {
+        uint8_t changed = shiftOutput[r] ^ shiftStage[r];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            if (!(changed & _BV(bit))) continue;
+            uint16_t output = r * 8 + bit;
+            if (shiftStage[r] & _BV(bit)) {
+                outputHighSince[output] = now;
+            } else {
+                outputHighTotal[output] += now - outputHighSince[output];
+            }
+        }
+        shiftOutput[r] = shiftStage[r];
+    }
+}
+
+SimPort &SimPort::operator=(uint8_t v) {
+    uint8_t changed = value ^ v;
+    value = v;
+
+    uint64_t now = sim::nowMicros();
+    for (uint8_t bit = 0; bit < PORT_PINS[index]; bit++) {
+        if (!(changed & _BV(bit))) continue;
+        uint8_t pin = PORT_FIRST_PIN[index] + bit;
+        bool high = (v & _BV(bit)) != 0;
+        if (high) {
+            pinHighSince[pin] = now;
+        } else {
+            pinHighTotal[pin] += now - pinHighSince[pin];
+        }
+        pinHigh[pin] = high;
+        sim::setPinLevel(pin, high);
+
+        if (pin == LATCH_PIN && high) {
+            latchShiftRegisters();
+        }
+    }
+    return *this;
+}
+
+SimSpiData &SimSpiData::operator=(uint8_t v) {
+    value = v;
+    if (SPCR & _BV(SPE)) {
+        // Each register's serial output feeds the next one in the chain
+        for (uint8_t r = MAX_SHIFT_REGISTERS - 1; r > 0; r--) {
+            shiftStage[r] = shiftStage[r - 1];
+        }
+        shiftStage[0] = v;
+    }
+    SPSR |= _BV(SPIF);
+    return *this;
+}
+
+namespace sim {
+
+uint64_t pinHighMicros(uint8_t pin) {
+    if (pin >= NUM_PINS) return 0;
+    uint64_t total = pinHighTotal[pin];
+    if (pinHigh[pin]) total += nowMicros() - pinHighSince[pin];
+    return total;
+}
+
+uint8_t shiftRegisterOutput(uint8_t reg) {
+    return reg < MAX_SHIFT_REGISTERS ? shiftOutput[reg] : 0;
+}
+
+uint64_t shiftOutputHighMicros(uint16_t output) {
+    if (output >= MAX_SHIFT_REGISTERS * 8) return 0;
+    uint64_t total = outputHighTotal[output];
+    if (shiftOutput[output / 8] & _BV(output % 8)) {
+        total += nowMicros() - outputHighSince[output];
+    }
+    return total;
+}
+
+void resetGpio() {
+    PORTB.value = PORTC.value = PORTD.value = 0;
+    DDRB = DDRC = DDRD = 0;
+    SPCR = SPSR = 0;
+    SPDR.value = 0;
+    memset(pinHighSince, 0, sizeof(pinHighSince));
+    memset(pinHighTotal, 0, sizeof(pinHighTotal));
+    memset(pinHigh, 0, sizeof(pinHigh));
+    memset(shiftStage, 0, sizeof(shiftStage));
+    memset(shiftOutput, 0, sizeof(shiftOutput));
+    memset(outputHighSince, 0, sizeof(outputHighSince));
+    memset(outputHighTotal, 0, sizeof(outputHighTotal));
+}
+
+} // namespace sim
@@ -0,0 +1,437 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include "sim.h"
+#include "sim_internal.h"
+
+// ===== Register model =====
+
+static const uint8_t REG_SMPLRT_DIV = 0x19;
+static const uint8_t REG_CONFIG = 0x1A;
+static const uint8_t REG_GYRO_CONFIG = 0x1B;
+static const uint8_t REG_ACCEL_CONFIG = 0x1C;
+static const uint8_t REG_MOT_THR = 0x1F;
+static const uint8_t REG_FIFO_EN = 0x23;
+static const uint8_t REG_INT_PIN_CFG = 0x37;
+static const uint8_t REG_INT_ENABLE = 0x38;
+static const uint8_t REG_INT_STATUS = 0x3A;
+static const uint8_t REG_DATA_START = 0x3B;  // ACCEL_XOUT_H
+static const uint8_t REG_USER_CTRL = 0x6A;
+static const uint8_t REG_PWR_MGMT_1 = 0x6B;
+static const uint8_t REG_PWR_MGMT_2 = 0x6C;
+static const uint8_t REG_FIFO_COUNTH = 0x72;
+static const uint8_t REG_FIFO_COUNTL = 0x73;
+static const uint8_t REG_FIFO_R_W = 0x74;
+static const uint8_t REG_WHO_AM_I = 0x75;
+
+static uint8_t registers[128];
+static uint8_t registerPointer = 0;
+static bool connected = true;
+
+static const uint16_t FIFO_SIZE = 1024;
+static uint8_t fifo[FIFO_SIZE];
+static uint16_t fifoHead = 0;   // Next write
+static uint16_t fifoLength = 0;
+
+static uint8_t intPin = 2;
+static bool intLatched = false;     // Latched INT held at its active level
+static uint64_t nextSampleMicros = UINT64_MAX;
+static uint32_t samplesGenerated = 0;
+
+// Accel pose held by ACCEL_HPF = hold, the motion comparator's reference
+static int16_t motionReference[3];
+
+static sim::ImuFeed imuFeed = nullptr;
+static void *imuFeedContext = nullptr;
+
+static int16_t clampToInt16(float value) {
+    if (value > 32767.0f) return 32767;
+    if (value < -32768.0f) return -32768;
+    return (int16_t)lroundf(value);
+}
+
+static void storeWord(uint8_t reg, int16_t value) {
+    registers[reg] = (uint8_t)((uint16_t)value >> 8);
+    registers[reg + 1] = (uint8_t)(value & 0xFF);
+}
+
+// Convert the physical feed into the big-endian output registers,
+// honouring the configured full-scale ranges
+static void latchSample() {
+    sim::ImuState s = sim::readImu();
+
+    float accelLsbPerG = 16384.0f / (float)(1 << ((registers[REG_ACCEL_CONFIG] >> 3) & 0x03));
+    float gyroLsbPerDps = 131.0f / (float)(1 << ((registers[REG_GYRO_CONFIG] >> 3) & 0x03));
+
+    storeWord(0x3B, clampToInt16(s.ax * accelLsbPerG));
+    storeWord(0x3D, clampToInt16(s.ay * accelLsbPerG));
+    storeWord(0x3F, clampToInt16(s.az * accelLsbPerG));
+    storeWord(0x41, clampToInt16((25.0f - 36.53f) * 340.0f));
+    // Gyros in standby read zero
+    bool gyroOn = (registers[REG_PWR_MGMT_2] & 0x07) == 0;
+    storeWord(0x43, gyroOn ? clampToInt16(s.gx * gyroLsbPerDps) : 0);
+    storeWord(0x45, gyroOn ? clampToInt16(s.gy * gyroLsbPerDps) : 0);
+    storeWord(0x47, gyroOn ? clampToInt16(s.gz * gyroLsbPerDps) : 0);
+}
+
+static int16_t registerWord(uint8_t reg) {
+    return (int16_t)((uint16_t)registers[reg] << 8 | registers[reg + 1]);
+}
+
+// INT is push-pull; INT_PIN_CFG.INT_LEVEL makes it active low
+static bool intActiveHigh() {
+    return !(registers[REG_INT_PIN_CFG] & 0x80);
+}
+
+// Raise an interrupt: a 50 us pulse, or held until the status is read
+// when INT_PIN_CFG.LATCH_INT_EN is set (only edges matter to the MCU)
+static void assertInt() {
+    if (registers[REG_INT_PIN_CFG] & 0x20) {
+        if (!intLatched) {
+            intLatched = true;
+            sim::raisePinEdge(intPin, intActiveHigh());
+        }
+        return;
+    }
+    sim::raisePinEdge(intPin, intActiveHigh());
+    sim::raisePinEdge(intPin, !intActiveHigh());
+}
+
+static void releaseInt() {
+    if (intLatched) {
+        intLatched = false;
+        sim::raisePinEdge(intPin, !intActiveHigh());
+    }
+}
+
+// Motion detection against the held pose. MOT_DUR is not modelled: in
+// cycle mode one wake-up sample over MOT_THR (2 mg steps) is enough.
+static bool motionDetected() {
+    if ((registers[REG_ACCEL_CONFIG] & 0x07) != 0x07) return false;
+    float countsPerMg = 16.384f / (float)(1 << ((registers[REG_ACCEL_CONFIG] >> 3) & 0x03));
+    int32_t threshold = (int32_t)(registers[REG_MOT_THR] * 2 * countsPerMg);
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        int32_t delta = (int32_t)registerWord(REG_DATA_START + 2 * axis) - motionReference[axis];
+        if (delta > threshold || -delta > threshold) return true;
+    }
+    return false;
+}
+
+static void resetFifo() {
+    fifoHead = 0;
+    fifoLength = 0;
+}
+
+static void pushFifo(uint8_t value) {
+    if (fifoLength == FIFO_SIZE) {
+        // Full: the oldest byte is overwritten and OFLOW is flagged
+        fifoLength--;
+        registers[REG_INT_STATUS] |= 0x10;
+    }
+    fifo[fifoHead] = value;
+    fifoHead = (fifoHead + 1) % FIFO_SIZE;
+    fifoLength++;
+}
+
+static uint8_t popFifo() {
+    if (fifoLength == 0) return 0xFF;
+    uint16_t tail = (fifoHead + FIFO_SIZE - fifoLength) % FIFO_SIZE;
+    fifoLength--;
+    return fifo[tail];
+}
+
+// Output data rate: 8 kHz internal with the DLPF off, 1 kHz with it on.
+// In cycle mode the chip wakes at LP_WAKE_CTRL for one accel sample.
+static uint64_t samplePeriodMicros() {
+    if (registers[REG_PWR_MGMT_1] & 0x20) {
+        static const uint32_t WAKE_PERIODS[4] = { 800000, 200000, 50000, 25000 };
+        return WAKE_PERIODS[registers[REG_PWR_MGMT_2] >> 6];
+    }
+    uint8_t dlpf = registers[REG_CONFIG] & 0x07;
+    uint32_t internalHz = (dlpf == 0 || dlpf == 7) ? 8000 : 1000;
+    return (uint64_t)1000000 * (1 + registers[REG_SMPLRT_DIV]) / internalHz;
+}
+
+static bool isAsleep() {
+    return registers[REG_PWR_MGMT_1] & 0x40;
+}
+
+// Restart the sample clock after wake-up or a rate change
+static void rescheduleSampling() {
+    nextSampleMicros = isAsleep() ? UINT64_MAX : sim::nowMicros() + samplePeriodMicros();
+}
+
+// Power-on register state (also what a DEVICE_RESET restores)
+static void resetRegisters() {
+    memset(registers, 0, sizeof(registers));
+    registers[REG_PWR_MGMT_1] = 0x40;  // Sleep bit set after power-on
+    registers[REG_WHO_AM_I] = sim::MPU6050_ADDRESS;
+    registerPointer = 0;
+    resetFifo();
+    nextSampleMicros = UINT64_MAX;
+    intLatched = false;
+}
+
+namespace sim {
+
+void resetMpu6050() {
+    resetRegisters();
+    intPin = 2;
+    samplesGenerated = 0;
+    connected = true;
+    imuFeed = nullptr;
+    imuFeedContext = nullptr;
+}
+
+void mpuSetRegisterPointer(uint8_t reg) {
+    registerPointer = reg & 0x7F;
+}
+
+void mpuWriteRegister(uint8_t value) {
+    uint8_t reg = registerPointer;
+    registerPointer = (registerPointer + 1) & 0x7F;
+
+    switch (reg) {
+        case REG_WHO_AM_I:
+        case REG_INT_STATUS:
+        case REG_FIFO_COUNTH:
+        case REG_FIFO_COUNTL:
+            return;  // Read-only
+
+        case REG_FIFO_R_W:
+            registerPointer = reg;
+            pushFifo(value);
+            return;
+
+        case REG_PWR_MGMT_1:
+            if (value & 0x80) {
+                resetRegisters();
+                return;
+            }
+            registers[reg] = value;
+            rescheduleSampling();
+            return;
+
+        case REG_USER_CTRL:
+            if (value & 0x04) resetFifo();
+            registers[reg] = value & ~0x04;  // FIFO_RESET self-clears
+            return;
+
+        case REG_SMPLRT_DIV:
+        case REG_CONFIG:
+        case REG_PWR_MGMT_2:
+            registers[reg] = value;
+            rescheduleSampling();
+            return;
+
+        case REG_ACCEL_CONFIG:
+            // Entering HPF hold captures the latest sample as the reference
+            if ((value & 0x07) == 0x07 && (registers[reg] & 0x07) != 0x07) {
+                for (uint8_t axis = 0; axis < 3; axis++) {
+                    motionReference[axis] = registerWord(REG_DATA_START + 2 * axis);
+                }
+            }
+            registers[reg] = value;
+            return;
+
+        case REG_INT_PIN_CFG: {
+            // The pin follows the new polarity straight away
+            bool wasHigh = sim::pinValue(intPin) != 0;
+            registers[reg] = value;
+            intLatched = false;
+            if (wasHigh != !intActiveHigh()) {
+                sim::raisePinEdge(intPin, !intActiveHigh());
+            }
+            return;
+        }
+
+        default:
+            registers[reg] = value;
+            return;
+    }
+}
+
+uint8_t mpuReadRegister() {
+    uint8_t reg = registerPointer;
+    registerPointer = (registerPointer + 1) & 0x7F;
+
+    switch (reg) {
+        case REG_FIFO_COUNTH:
+            return (uint8_t)(fifoLength >> 8);
+
+        case REG_FIFO_COUNTL:
+            return (uint8_t)(fifoLength & 0xFF);
+
+        case REG_FIFO_R_W:
+            // Burst reads keep popping the FIFO
+            registerPointer = reg;
+            return popFifo();
+
+        case REG_INT_STATUS: {
+            uint8_t status = registers[reg];
+            registers[reg] = 0;  // Cleared by reading
+            releaseInt();
+            return status;
+        }
+
+        default:
+            // INT_RD_CLEAR: any read clears the status
+            if (registers[REG_INT_PIN_CFG] & 0x10) {
+                releaseInt();
+            }
+            return registers[reg];
+    }
+}
+
+uint64_t mpuNextEventMicros() {
+    return nextSampleMicros;
+}
+
+void mpuTick() {
+    nextSampleMicros += samplePeriodMicros();
+    samplesGenerated++;
+
+    latchSample();
+
+    // FIFO_EN.ACCEL_FIFO_EN with USER_CTRL.FIFO_EN: push the 6 accel bytes
+    if ((registers[REG_USER_CTRL] & 0x40) && (registers[REG_FIFO_EN] & 0x08)) {
+        for (uint8_t i = 0; i < 6; i++) {
+            pushFifo(registers[REG_DATA_START + i]);
+        }
+    }
+
+    registers[REG_INT_STATUS] |= 0x01;  // DATA_RDY_INT
+    if (registers[REG_INT_ENABLE] & 0x01) {
+        assertInt();
+    }
+
+    if ((registers[REG_INT_ENABLE] & 0x40) && motionDetected()) {
+        registers[REG_INT_STATUS] |= 0x40;  // MOT_INT
+        assertInt();
+    }
+}
+
+void setImuIntPin(uint8_t pin) {
+    intPin = pin;
+}
+
+uint32_t imuSamplesGenerated() {
+    return samplesGenerated;
+}
+
+void setImuFeed(ImuFeed feed, void *context) {
+    imuFeed = feed;
+    imuFeedContext = context;
+}
+
+void setImuConnected(bool isConnected) {
+    connected = isConnected;
+}
+
+bool isImuConnected() {
+    return connected;
+}
+
+ImuState readImu() {
+    if (imuFeed) {
+        return imuFeed(nowMicros(), imuFeedContext);
+    }
+    return handAtPitch(0);
+}
+
+ImuState handAtPitch(float pitchDeg) {
+    // Inverse of atan2(-x, sqrt(y*y + z*z)) with gravity in the X/Z plane
+    float rad = pitchDeg * (float)DEG_TO_RAD;
+    ImuState s = {};
+    s.ax = -sinf(rad);
+    s.ay = 0.0f;
+    s.az = cosf(rad);
+    return s;
+}
+
+} // namespace sim
+
+// ===== Wire =====
+
+TwoWire Wire;
+
+TwoWire::TwoWire()
+    : txAddress(0), txLength(0), rxLength(0), rxIndex(0), clockHz(100000) {
+}
+
+void TwoWire::transfer(uint8_t bytes) {
+    sim::i2cCountStart(clockHz);
+    sim::i2cCountBytes(bytes);
+    // START, then 8 bits + ACK per byte
+    uint64_t bits = 1 + 9 * (uint64_t)bytes;
+    sim::advanceMicros((bits * 1000000 + clockHz - 1) / clockHz);
+}
+
+void TwoWire::begin() {
+    txLength = 0;
+    rxLength = 0;
+    rxIndex = 0;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    txAddress = address;
+    txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (txLength >= BUFFER_LENGTH) return 0;
+    txBuffer[txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity) {
+    for (size_t i = 0; i < quantity; i++) {
+        if (!write(data[i])) return i;
+    }
+    return quantity;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    (void)sendStop;
+
+    if (txAddress != sim::MPU6050_ADDRESS || !sim::isImuConnected()) {
+        transfer(1);
+        return 2;  // Address NACK
+    }
+
+    if (txLength > 0) {
+        sim::mpuSetRegisterPointer(txBuffer[0]);
+        for (uint8_t i = 1; i < txLength; i++) {
+            sim::mpuWriteRegister(txBuffer[i]);
+        }
+    }
+    transfer(1 + txLength);
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop) {
+    (void)sendStop;
+    rxIndex = 0;
+    rxLength = 0;
+
+    if (address != sim::MPU6050_ADDRESS || !sim::isImuConnected()) {
+        transfer(1);
+        return 0;
+    }
+
+    if (quantity > BUFFER_LENGTH) quantity = BUFFER_LENGTH;
+    for (uint8_t i = 0; i < quantity; i++) {
+        rxBuffer[i] = sim::mpuReadRegister();
+    }
+    rxLength = quantity;
+    transfer(1 + quantity);
+    return quantity;
+}
+
+int TwoWire::available() {
+    return rxLength - rxIndex;
+}
+
+int TwoWire::read() {
+    if (rxIndex >= rxLength) return -1;
+    return rxBuffer[rxIndex++];
+}
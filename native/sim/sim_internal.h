@@ -0,0 +1,64 @@
+#ifndef SIM_INTERNAL_H
+#define SIM_INTERNAL_H
+
+#include <stdint.h>
+
+// Hooks shared between the stand-in translation units
+namespace sim {
+
+// MPU6050 register model (I2C address 0x68)
+const uint8_t MPU6050_ADDRESS = 0x68;
+
+void resetMpu6050();
+void mpuSetRegisterPointer(uint8_t reg);
+void mpuWriteRegister(uint8_t value);
+uint8_t mpuReadRegister();
+
+// Sensor-clock events: next sample time (UINT64_MAX when asleep) and
+// the handler the virtual clock calls at that time
+uint64_t mpuNextEventMicros();
+void mpuTick();
+
+// Deliver an edge on an external-interrupt pin
+void raisePinEdge(uint8_t pin, bool rising);
+void resetInterrupts();
+
+void resetFastLED();
+void resetTimers();
+void resetGpio();
+
+// Global interrupt enable, and pin levels driven through PORTx writes
+bool interruptsOn();
+void setPinLevel(uint8_t pin, bool high);
+
+// Timer2 compare-match events: next match time (UINT64_MAX while the
+// interrupt is off) and the handler the virtual clock calls then. The
+// timer stops in power-down, so sleeps shift its schedule.
+uint64_t timer2NextEventMicros();
+void timer2Tick();
+void timer2Pause(uint64_t us);
+void serviceTimerPending();
+
+// Timer0: micros() time (stands still in power-down, like the timer),
+// compare-match A events on the virtual clock (UINT64_MAX while the
+// interrupt is off), and the next overflow, which wakes idle sleep
+uint64_t timer0Micros();
+uint64_t timer0NextEventMicros();
+void timer0Tick();
+uint64_t timer0NextOverflowMicros();
+
+// I2C accounting shared by Wire and the TWI model
+void i2cCountStart(uint32_t clockHz);
+void i2cCountBytes(uint32_t bytes);
+
+// TWI events: next completion time (UINT64_MAX while idle or stuck) and
+// the handler the virtual clock calls then. twiTick() returns true if
+// it raised the interrupt (TWIE set).
+uint64_t twiNextEventMicros();
+bool twiTick();
+void serviceTwiPending();
+void resetTwi();
+
+} // namespace sim
+
+#endif // SIM_INTERNAL_H
@@ -0,0 +1,168 @@
+#include <Arduino.h>
+#include <avr/io.h>
+#include "sim.h"
+#include "sim_internal.h"
+
+volatile uint8_t TCCR0A, TCCR1A, TCCR2A;
+volatile uint8_t OCR0A, OCR0B;
+volatile uint8_t OCR1AL, OCR1BL;
+volatile uint8_t OCR2A, OCR2B;
+volatile uint8_t TCCR2B, TIMSK2, TCNT2;
+volatile uint8_t TIMSK0;
+
+// The firmware's handlers, if it defines them
+extern "C" void TIMER2_COMPA_vect(void) __attribute__((weak));
+extern "C" void TIMER0_COMPA_vect(void) __attribute__((weak));
+
+static const uint64_t CYCLES_PER_MICRO = F_CPU / 1000000UL;
+static const uint16_t TIMER2_PRESCALERS[8] = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+
+// Timer2 CTC state, in CPU cycles on the virtual clock
+static bool timer2Running = false;
+static uint64_t timer2LastMatch = 0;
+static bool timer2Pending = false;
+static uint32_t timer2Matches = 0;
+static void (*timer2Handler)() = nullptr;
+
+// Timer0 compare A, in micros() time: one match per 1024 us cycle
+static const uint64_t TIMER0_CYCLE_MICROS = 1024;
+static bool timer0Armed = false;
+static uint64_t timer0NextMatch = 0;
+static bool timer0Pending = false;
+
+static void runTimer0Handler() {
+    if (TIMER0_COMPA_vect) {
+        TIMER0_COMPA_vect();
+    }
+}
+
+static bool timer2InterruptArmed() {
+    return (TIMSK2 & _BV(OCIE2A)) && (TCCR2A & _BV(WGM21)) && (TCCR2B & 7);
+}
+
+static uint64_t timer2PeriodCycles() {
+    return (uint64_t)(OCR2A + 1) * TIMER2_PRESCALERS[TCCR2B & 7];
+}
+
+static void runTimer2Handler() {
+    if (timer2Handler) {
+        timer2Handler();
+    } else if (TIMER2_COMPA_vect) {
+        TIMER2_COMPA_vect();
+    }
+}
+
+namespace sim {
+
+uint64_t timer2NextEventMicros() {
+    if (!timer2InterruptArmed()) {
+        timer2Running = false;
+        return UINT64_MAX;
+    }
+    // Counting starts when the interrupt is first armed
+    if (!timer2Running) {
+        timer2Running = true;
+        timer2LastMatch = nowMicros() * CYCLES_PER_MICRO;
+    }
+    uint64_t next = timer2LastMatch + timer2PeriodCycles();
+    return (next + CYCLES_PER_MICRO - 1) / CYCLES_PER_MICRO;
+}
+
+void timer2Tick() {
+    timer2LastMatch += timer2PeriodCycles();
+    timer2Matches++;
+    // One flag: matches while interrupts are off coalesce, as on the chip
+    if (interruptsOn()) {
+        runTimer2Handler();
+    } else {
+        timer2Pending = true;
+    }
+}
+
+void timer2Pause(uint64_t us) {
+    timer2LastMatch += us * CYCLES_PER_MICRO;
+}
+
+void serviceTimerPending() {
+    if (timer2Pending && timer2InterruptArmed()) {
+        timer2Pending = false;
+        runTimer2Handler();
+    }
+    if (timer0Pending && (TIMSK0 & _BV(OCIE0A))) {
+        timer0Pending = false;
+        runTimer0Handler();
+    }
+}
+
+uint64_t timer0NextEventMicros() {
+    if (!(TIMSK0 & _BV(OCIE0A))) {
+        timer0Armed = false;
+        return UINT64_MAX;
+    }
+    uint64_t now = timer0Micros();
+    if (!timer0Armed) {
+        // First match after arming, at the OCR0A phase of the cycle
+        timer0Armed = true;
+        uint64_t phase = OCR0A * (TIMER0_CYCLE_MICROS / 256);
+        uint64_t cycle = now < phase ? 0 : (now - phase) / TIMER0_CYCLE_MICROS + 1;
+        timer0NextMatch = phase + cycle * TIMER0_CYCLE_MICROS;
+    }
+    return nowMicros() + (timer0NextMatch - now);
+}
+
+void timer0Tick() {
+    timer0NextMatch += TIMER0_CYCLE_MICROS;
+    if (interruptsOn()) {
+        runTimer0Handler();
+    } else {
+        timer0Pending = true;
+    }
+}
+
+uint64_t timer0NextOverflowMicros() {
+    uint64_t now = timer0Micros();
+    return nowMicros() + (now / TIMER0_CYCLE_MICROS + 1) * TIMER0_CYCLE_MICROS - now;
+}
+
+void setTimer2Handler(void (*handler)()) {
+    timer2Handler = handler;
+}
+
+uint32_t timer2MatchCount() {
+    return timer2Matches;
+}
+
+uint8_t timerPwmDuty(uint8_t pin) {
+    switch (pin) {
+        case 3:  return (TCCR2A & _BV(COM2B1)) ? OCR2B : 0;
+        case 5:  return (TCCR0A & _BV(COM0B1)) ? OCR0B : 0;
+        case 6:  return (TCCR0A & _BV(COM0A1)) ? OCR0A : 0;
+        case 9:  return (TCCR1A & _BV(COM1A1)) ? OCR1AL : 0;
+        case 10: return (TCCR1A & _BV(COM1B1)) ? OCR1BL : 0;
+        case 11: return (TCCR2A & _BV(COM2A1)) ? OCR2A : 0;
+        default: return 0;
+    }
+}
+
+void resetTimers() {
+    // Arduino core init: Timer0 fast PWM, Timers 1/2 phase-correct 8-bit,
+    // no pins connected to the compare units
+    TCCR0A = _BV(1) | _BV(0);
+    TCCR1A = _BV(0);
+    TCCR2A = _BV(0);
+    OCR0A = OCR0B = 0;
+    OCR1AL = OCR1BL = 0;
+    OCR2A = OCR2B = 0;
+    TCCR2B = TIMSK2 = TCNT2 = 0;
+    timer2Running = false;
+    timer2LastMatch = 0;
+    timer2Pending = false;
+    timer2Matches = 0;
+    timer2Handler = nullptr;
+    TIMSK0 = 0;
+    timer0Armed = false;
+    timer0NextMatch = 0;
+    timer0Pending = false;
+}
+
+} // namespace sim
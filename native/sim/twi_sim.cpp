@@ -0,0 +1,226 @@
+#include <Arduino.h>
+#include <avr/io.h>
+#include <util/twi.h>
+#include "sim.h"
+#include "sim_internal.h"
+
+SimTwiControl TWCR;
+volatile uint8_t TWBR, TWSR, TWDR;
+
+// The firmware's handler, if it defines one
+extern "C" void TWI_vect(void) __attribute__((weak));
+
+static const uint64_t CYCLES_PER_MICRO = F_CPU / 1000000UL;
+static const uint8_t TWI_PRESCALERS[4] = { 1, 4, 16, 64 };
+
+// Bus traffic, both transports
+static uint32_t busBytes = 0;
+static uint32_t busTransactions = 0;
+static uint32_t busClockHz = 100000;
+
+// The action in progress and its result, in CPU cycles on the virtual clock
+enum TwiAction : uint8_t {
+    ACTION_NONE,
+    ACTION_START,
+    ACTION_ADDRESS,
+    ACTION_WRITE,
+    ACTION_READ
+};
+
+static TwiAction action = ACTION_NONE;
+static uint8_t actionStatus = 0;    // TWSR status once it completes
+static uint8_t actionBits = 0;      // Bus time, in SCL periods
+static uint64_t actionDone = 0;     // Completion, CPU cycles
+static bool busOwned = false;       // START sent, no STOP yet
+static bool pointerSet = false;     // First byte after SLA+W sets the register
+static bool stuck = false;
+static bool pending = false;        // TWINT with TWIE while interrupts were off
+static void (*twiHandler)() = nullptr;
+
+static uint64_t bitCycles() {
+    return 16 + 2 * (uint64_t)TWBR * TWI_PRESCALERS[TWSR & 3];
+}
+
+static void schedule(TwiAction next, uint8_t status, uint8_t bits) {
+    action = next;
+    actionStatus = status;
+    actionBits = bits;
+    actionDone = sim::nowMicros() * CYCLES_PER_MICRO + bits * bitCycles();
+}
+
+static void runTwiHandler() {
+    if (twiHandler) {
+        twiHandler();
+    } else if (TWI_vect) {
+        TWI_vect();
+    }
+}
+
+SimTwiControl &SimTwiControl::operator=(uint8_t v) {
+    if (!(v & _BV(TWEN))) {
+        // TWI off: the pins go back to the port, the transfer is lost
+        value = v & ~_BV(TWINT);
+        action = ACTION_NONE;
+        busOwned = false;
+        pending = false;
+        return *this;
+    }
+    if (!(v & _BV(TWINT))) {
+        // Enable bits only; the flag and the action in progress stay
+        value = (value & _BV(TWINT)) | (v & ~_BV(TWINT));
+        return *this;
+    }
+
+    // Writing one clears TWINT and starts the next action
+    value = v & ~_BV(TWINT);
+    pending = false;
+    if (v & _BV(TWSTA)) {
+        schedule(ACTION_START, busOwned ? TW_REP_START : TW_START, 1);
+        return *this;
+    }
+    if (v & _BV(TWSTO)) {
+        // The STOP goes out at once and TWSTO clears
+        value &= ~_BV(TWSTO);
+        busOwned = false;
+        action = ACTION_NONE;
+        return *this;
+    }
+    if (!busOwned) {
+        return *this;
+    }
+
+    bool present = sim::isImuConnected();
+    switch (TWSR & TW_STATUS_MASK) {
+        case TW_START:
+        case TW_REP_START: {
+            bool addressed = (TWDR >> 1) == sim::MPU6050_ADDRESS && present;
+            bool read = TWDR & TW_READ;
+            pointerSet = false;
+            schedule(ACTION_ADDRESS,
+                     read ? (addressed ? TW_MR_SLA_ACK : TW_MR_SLA_NACK)
+                          : (addressed ? TW_MT_SLA_ACK : TW_MT_SLA_NACK), 9);
+            break;
+        }
+        case TW_MT_SLA_ACK:
+        case TW_MT_DATA_ACK:
+            schedule(ACTION_WRITE, TW_MT_DATA_ACK, 9);
+            break;
+        case TW_MR_SLA_ACK:
+        case TW_MR_DATA_ACK:
+            schedule(ACTION_READ, (v & _BV(TWEA)) ? TW_MR_DATA_ACK : TW_MR_DATA_NACK, 9);
+            break;
+        default:
+            // After a NACK only a STOP or a START does anything
+            break;
+    }
+    return *this;
+}
+
+namespace sim {
+
+void i2cCountStart(uint32_t clockHz) {
+    busTransactions++;
+    busClockHz = clockHz;
+}
+
+void i2cCountBytes(uint32_t bytes) {
+    busBytes += bytes;
+}
+
+uint64_t twiNextEventMicros() {
+    if (action == ACTION_NONE || stuck) {
+        return UINT64_MAX;
+    }
+    return (actionDone + CYCLES_PER_MICRO - 1) / CYCLES_PER_MICRO;
+}
+
+bool twiTick() {
+    // The byte moves at completion, so an abort before then loses it
+    switch (action) {
+        case ACTION_START:
+            busOwned = true;
+            i2cCountStart((uint32_t)(F_CPU / bitCycles()));
+            break;
+        case ACTION_ADDRESS:
+            i2cCountBytes(1);
+            break;
+        case ACTION_WRITE:
+            i2cCountBytes(1);
+            if (pointerSet) {
+                mpuWriteRegister(TWDR);
+            } else {
+                mpuSetRegisterPointer(TWDR);
+                pointerSet = true;
+            }
+            break;
+        case ACTION_READ:
+            i2cCountBytes(1);
+            TWDR = mpuReadRegister();
+            break;
+        case ACTION_NONE:
+            return false;
+    }
+    action = ACTION_NONE;
+    TWSR = (TWSR & ~TW_STATUS_MASK) | actionStatus;
+    TWCR.value |= _BV(TWINT);
+
+    if (!(TWCR.value & _BV(TWIE))) {
+        return false;
+    }
+    if (interruptsOn()) {
+        runTwiHandler();
+    } else {
+        pending = true;
+    }
+    return true;
+}
+
+void serviceTwiPending() {
+    // Level-triggered: still pending only while TWINT and TWIE are set
+    if (pending && (TWCR.value & _BV(TWINT)) && (TWCR.value & _BV(TWIE))) {
+        pending = false;
+        runTwiHandler();
+    }
+}
+
+void resetTwi() {
+    TWCR.value = 0;
+    TWBR = 0;
+    TWSR = TW_NO_INFO;
+    TWDR = 0xFF;
+    action = ACTION_NONE;
+    busOwned = false;
+    pointerSet = false;
+    stuck = false;
+    pending = false;
+    twiHandler = nullptr;
+    busBytes = 0;
+    busTransactions = 0;
+    busClockHz = 100000;
+}
+
+uint32_t i2cBytesTransferred() {
+    return busBytes;
+}
+
+uint32_t i2cTransactions() {
+    return busTransactions;
+}
+
+uint32_t i2cClockHz() {
+    return busClockHz;
+}
+
+void setTwiStuck(bool hold) {
+    if (stuck && !hold && action != ACTION_NONE) {
+        // The action restarts from where the bus was let go
+        schedule(action, actionStatus, actionBits);
+    }
+    stuck = hold;
+}
+
+void setTwiHandler(void (*handler)()) {
+    twiHandler = handler;
+}
+
+} // namespace sim
@@ -0,0 +1,126 @@
+#include "led_capture.h"
+#include <avr_ioport.h>
+#include <avr_timer.h>
+#include <sim_io.h>
+
+// Arduino Nano pin to AVR port and bit
+static void portBit(uint8_t pin, char &port, uint8_t &bit) {
+    if (pin < 8) {
+        port = 'D';
+        bit = pin;
+    } else if (pin < 14) {
+        port = 'B';
+        bit = pin - 8;
+    } else {
+        port = 'C';
+        bit = pin - 14;
+    }
+}
+
+LedCapture::LedCapture(avr_t *avr)
+    : avr(avr), oneCycles((uint64_t)avr->frequency * 550 / 1000000000),
+      latchCycles((uint64_t)avr->frequency * 50 / 1000000),
+      bitCount(0), partial(0), riseAt(0), fallAt(0), frameStart(0), receiving(false),
+      lastChange(0), changes(0), frames(0), streamCycles(0), streamWorst(0) {
+    for (uint8_t i = 0; i < 6; i++) {
+        channels[i].capture = this;
+        channels[i].duty = 0;
+    }
+}
+
+void LedCapture::attachWs2812(uint8_t pin) {
+    char port;
+    uint8_t bit;
+    portBit(pin, port, bit);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), bit), onWs2812,
+                            this);
+}
+
+void LedCapture::attachPwm() {
+    static const uint8_t PWM_PINS[6] = { 3, 5, 6, 9, 10, 11 };
+    for (uint8_t i = 0; i < 6; i++) {
+        char port;
+        uint8_t bit;
+        portBit(PWM_PINS[i], port, bit);
+        avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(port), bit),
+                                onPwmPin, this);
+    }
+    static const char TIMERS[3] = { '0', '1', '2' };
+    for (uint8_t t = 0; t < 3; t++) {
+        avr_irq_register_notify(
+            avr_io_getirq(avr, AVR_IOCTL_TIMER_GETIRQ(TIMERS[t]), TIMER_IRQ_OUT_PWM0), onDuty,
+            &channels[t * 2]);
+        avr_irq_register_notify(
+            avr_io_getirq(avr, AVR_IOCTL_TIMER_GETIRQ(TIMERS[t]), TIMER_IRQ_OUT_PWM1), onDuty,
+            &channels[t * 2 + 1]);
+    }
+}
+
+void LedCapture::change(uint64_t cycle) {
+    lastChange = cycle;
+    changes++;
+}
+
+void LedCapture::poll() {
+    if (receiving && avr->cycle - fallAt >= latchCycles) {
+        latch();
+    }
+}
+
+void LedCapture::latch() {
+    // The LEDs take the frame once the reset time has passed
+    uint64_t latchedAt = fallAt + latchCycles;
+    uint64_t stream = fallAt - frameStart;
+    streamCycles += stream;
+    if (stream > streamWorst) {
+        streamWorst = stream;
+    }
+    frames++;
+    if (current != previous) {
+        change(latchedAt);
+        previous.swap(current);
+    }
+    current.clear();
+    bitCount = 0;
+    partial = 0;
+    receiving = false;
+}
+
+void LedCapture::onWs2812(avr_irq_t *, uint32_t value, void *param) {
+    LedCapture *c = (LedCapture *)param;
+    uint64_t now = c->avr->cycle;
+    if (value) {
+        if (c->receiving && now - c->fallAt >= c->latchCycles) {
+            c->latch();
+        }
+        if (!c->receiving) {
+            c->receiving = true;
+            c->frameStart = now;
+        }
+        c->riseAt = now;
+        return;
+    }
+    if (!c->receiving) {
+        return;
+    }
+    c->partial = c->partial << 1 | (now - c->riseAt > c->oneCycles);
+    c->fallAt = now;
+    if (++c->bitCount == 8) {
+        c->current.push_back(c->partial);
+        c->bitCount = 0;
+        c->partial = 0;
+    }
+}
+
+void LedCapture::onPwmPin(avr_irq_t *, uint32_t, void *param) {
+    LedCapture *c = (LedCapture *)param;
+    c->change(c->avr->cycle);
+}
+
+void LedCapture::onDuty(avr_irq_t *, uint32_t value, void *param) {
+    DutyChannel *channel = (DutyChannel *)param;
+    if (value != channel->duty) {
+        channel->duty = value;
+        channel->capture->change(channel->capture->avr->cycle);
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef SIMAVR_LED_CAPTURE_H
+#define SIMAVR_LED_CAPTURE_H
+
+#include <stdint.h>
+#include <vector>
+#include <sim_avr.h>
+#include <sim_irq.h>
+
+// LED output of a firmware image in simavr, timestamped in CPU cycles.
+//
+// WS2812: the data pin is decoded bit by bit (high longer than 550 ns is
+// a one) and a frame latches once the line has been low for 50 us. A
+// latched frame that differs from the one before is an LED change.
+//
+// PWM (F5 LEDs): every compare-output duty the timers report and every
+// edge on the six PWM pins is an LED change.
+
+class LedCapture {
+public:
+    explicit LedCapture(avr_t *avr);
+
+    // Decode WS2812 data on Arduino pin `pin`
+    void attachWs2812(uint8_t pin);
+
+    // Watch Timer0/1/2 duties and pins 3, 5, 6, 9, 10, 11
+    void attachPwm();
+
+    // Between instructions: latch a WS2812 frame whose reset time is up
+    void poll();
+
+    // Cycle of the last LED change (0 before the first) and the count
+    uint64_t getLastChange() const { return lastChange; }
+    uint32_t getChanges() const { return changes; }
+
+    // WS2812 frames latched, LEDs in the last one, and the time each
+    // frame's bit stream took (the firmware holds interrupts off for it)
+    uint32_t getFrames() const { return frames; }
+    uint16_t getFrameLeds() const { return (uint16_t)(previous.size() / 3); }
+    uint64_t getStreamCycles() const { return streamCycles; }
+    uint64_t getStreamWorst() const { return streamWorst; }
+
+private:
+    avr_t *avr;
+    uint64_t oneCycles;     // High time above this is a one bit
+    uint64_t latchCycles;   // Low time that latches the frame
+
+    std::vector<uint8_t> current;
+    std::vector<uint8_t> previous;
+    uint8_t bitCount;
+    uint8_t partial;
+    uint64_t riseAt;
+    uint64_t fallAt;
+    uint64_t frameStart;
+    bool receiving;
+
+    // Compare outputs A and B of Timers 0, 1 and 2
+    struct DutyChannel {
+        LedCapture *capture;
+        uint32_t duty;
+    };
+    DutyChannel channels[6];
+
+    uint64_t lastChange;
+    uint32_t changes;
+    uint32_t frames;
+    uint64_t streamCycles;
+    uint64_t streamWorst;
+
+    void change(uint64_t cycle);
+    void latch();
+
+    static void onWs2812(avr_irq_t *irq, uint32_t value, void *param);
+    static void onPwmPin(avr_irq_t *irq, uint32_t value, void *param);
+    static void onDuty(avr_irq_t *irq, uint32_t value, void *param);
+};
+
+#endif // SIMAVR_LED_CAPTURE_H
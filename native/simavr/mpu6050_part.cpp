@@ -0,0 +1,133 @@
+#include "mpu6050_part.h"
+#include <math.h>
+#include <string.h>
+#include <avr_twi.h>
+#include <sim_io.h>
+
+static const uint8_t REG_GYRO_CONFIG = 0x1B;
+static const uint8_t REG_ACCEL_CONFIG = 0x1C;
+static const uint8_t REG_INT_STATUS = 0x3A;
+static const uint8_t REG_ACCEL_XOUT_H = 0x3B;
+static const uint8_t REG_GYRO_ZOUT_L = 0x48;
+static const uint8_t REG_PWR_MGMT_1 = 0x6B;
+static const uint8_t REG_WHO_AM_I = 0x75;
+
+static const int16_t TEMP_25C = -3920;  // 36.53 + raw / 340 degrees C
+
+Mpu6050Part::Mpu6050Part(avr_t *avr, Mpu6050Script script, void *context)
+    : avr(avr), script(script), context(context), reads(0), writes(0) {
+    static const char *names[2] = { "8>mpu6050.out", "32<mpu6050.in" };
+    irq = avr_alloc_irq(&avr->irq_pool, 0, 2, names);
+    avr_irq_register_notify(irq + TWI_IRQ_OUTPUT, onTwi, this);
+
+    // Our INPUT drives the AVR's TWI input, its OUTPUT reaches us
+    avr_connect_irq(irq + TWI_IRQ_INPUT, avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0),
+                                                       TWI_IRQ_INPUT));
+    avr_connect_irq(avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT),
+                    irq + TWI_IRQ_OUTPUT);
+    reset();
+}
+
+void Mpu6050Part::reset() {
+    memset(registers, 0, sizeof(registers));
+    registers[REG_PWR_MGMT_1] = 0x40;  // Sleep bit set after power-on
+    registers[REG_WHO_AM_I] = ADDRESS;
+    pointer = 0;
+    selected = false;
+    pointerSet = false;
+}
+
+static void putInt16(uint8_t *bytes, float value) {
+    float clamped = value > 32767.0f ? 32767.0f : (value < -32768.0f ? -32768.0f : value);
+    int16_t raw = (int16_t)lroundf(clamped);
+    bytes[0] = (uint8_t)(raw >> 8);
+    bytes[1] = (uint8_t)raw;
+}
+
+void Mpu6050Part::latchSample() {
+    if (registers[REG_PWR_MGMT_1] & 0x40) {
+        return;  // Asleep: the data registers hold the last sample
+    }
+    uint64_t us = avr->cycle * 1000000ULL / avr->frequency;
+    Mpu6050Pose pose = script(us, context);
+    float accelLsb = (float)(16384 >> ((registers[REG_ACCEL_CONFIG] >> 3) & 3));
+    float gyroLsb = 131.0f / (1 << ((registers[REG_GYRO_CONFIG] >> 3) & 3));
+
+    uint8_t *data = &registers[REG_ACCEL_XOUT_H];
+    putInt16(data + 0, pose.ax * accelLsb);
+    putInt16(data + 2, pose.ay * accelLsb);
+    putInt16(data + 4, pose.az * accelLsb);
+    putInt16(data + 6, TEMP_25C);
+    putInt16(data + 8, pose.gx * gyroLsb);
+    putInt16(data + 10, pose.gy * gyroLsb);
+    putInt16(data + 12, pose.gz * gyroLsb);
+}
+
+void Mpu6050Part::writeRegister(uint8_t value) {
+    if (!pointerSet) {
+        pointer = value & 0x7F;
+        pointerSet = true;
+        return;
+    }
+    writes++;
+    if (pointer == REG_PWR_MGMT_1 && (value & 0x80)) {
+        reset();
+        return;
+    }
+    registers[pointer] = value;
+    pointer = (pointer + 1) & 0x7F;
+}
+
+uint8_t Mpu6050Part::readRegister() {
+    reads++;
+    uint8_t reg = pointer;
+    pointer = (pointer + 1) & 0x7F;
+    if (reg == REG_INT_STATUS) {
+        return 0x01;  // DATA_RDY: there is always a fresh sample
+    }
+    return registers[reg];
+}
+
+void Mpu6050Part::onTwi(avr_irq_t *, uint32_t value, void *param) {
+    Mpu6050Part *p = (Mpu6050Part *)param;
+    avr_twi_msg_irq_t msg;
+    msg.u.v = value;
+
+    if (msg.u.twi.msg & TWI_COND_STOP) {
+        p->selected = false;
+    }
+    if (msg.u.twi.msg & TWI_COND_START) {
+        // START and repeated START carry the address byte; the register
+        // pointer survives a repeated START
+        p->selected = (msg.u.twi.addr >> 1) == ADDRESS;
+        if (!p->selected) {
+            return;
+        }
+        p->pointerSet = false;
+        bool read = msg.u.twi.addr & 1;
+        if (read && p->pointer >= REG_ACCEL_XOUT_H && p->pointer <= REG_GYRO_ZOUT_L) {
+            p->latchSample();
+        }
+        avr_raise_irq(p->irq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_ACK, msg.u.twi.addr, 1));
+    }
+    if (!p->selected) {
+        return;
+    }
+    if (msg.u.twi.msg & TWI_COND_WRITE) {
+        p->writeRegister(msg.u.twi.data);
+        avr_raise_irq(p->irq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_ACK, msg.u.twi.addr, 1));
+    }
+    if (msg.u.twi.msg & TWI_COND_READ) {
+        avr_raise_irq(p->irq + TWI_IRQ_INPUT,
+                      avr_twi_irq_msg(TWI_COND_READ, msg.u.twi.addr, p->readRegister()));
+    }
+}
+
+Mpu6050Pose poseAtPitch(float pitchDeg) {
+    // Same pose as sim::handAtPitch(): gravity in the X/Z plane
+    float rad = pitchDeg * (float)M_PI / 180.0f;
+    Mpu6050Pose pose = {};
+    pose.ax = -sinf(rad);
+    pose.az = cosf(rad);
+    return pose;
+}
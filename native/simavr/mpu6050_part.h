@@ -0,0 +1,59 @@
+#ifndef SIMAVR_MPU6050_PART_H
+#define SIMAVR_MPU6050_PART_H
+
+#include <stdint.h>
+#include <sim_avr.h>
+#include <sim_irq.h>
+
+// MPU6050 on the simavr TWI bus at 0x68: register writes and burst
+// reads as the firmware's driver issues them, WHO_AM_I, DATA_RDY always
+// set in INT_STATUS. A read burst starting in the data block (0x3B up)
+// latches accelerometer and gyro from the pose script at that cycle,
+// scaled by the programmed full-scale ranges. No FIFO, INT pin or
+// motion interrupt: images built with MPU_FIFO_MODE or LOW_POWER_MODE
+// won't see samples.
+
+struct Mpu6050Pose {
+    float ax, ay, az;   // g
+    float gx, gy, gz;   // deg/s
+};
+
+// The pose at a given time since reset, in microseconds
+typedef Mpu6050Pose (*Mpu6050Script)(uint64_t us, void *context);
+
+class Mpu6050Part {
+public:
+    Mpu6050Part(avr_t *avr, Mpu6050Script script, void *context);
+
+    // Reads and writes addressed to the part (register bytes, not
+    // address bytes)
+    uint32_t getReads() const { return reads; }
+    uint32_t getWrites() const { return writes; }
+
+private:
+    static const uint8_t ADDRESS = 0x68;
+
+    avr_t *avr;
+    avr_irq_t *irq;
+    Mpu6050Script script;
+    void *context;
+
+    uint8_t registers[128];
+    uint8_t pointer;
+    bool selected;
+    bool pointerSet;    // First byte written after SLA+W is the pointer
+    uint32_t reads;
+    uint32_t writes;
+
+    void reset();
+    void latchSample();
+    void writeRegister(uint8_t value);
+    uint8_t readRegister();
+
+    static void onTwi(avr_irq_t *irq, uint32_t value, void *param);
+};
+
+// Hand pitched `pitchDeg` above horizontal, at rest
+Mpu6050Pose poseAtPitch(float pitchDeg);
+
+#endif // SIMAVR_MPU6050_PART_H
@@ -0,0 +1,417 @@
+#include <fcntl.h>
+#include <gelf.h>
+#include <libelf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include <avr_uart.h>
+#include <sim_avr.h>
+#include <sim_elf.h>
+#include <sim_io.h>
+#include "led_capture.h"
+#include "mpu6050_part.h"
+
+// Cycle-accurate benchmark of a firmware image: the firmware.elf of the
+// `full` or `unified` env runs in simavr on an ATmega328P at 16 MHz,
+// with a scripted MPU6050 on the TWI bus and the LED pins captured.
+//
+// Usage:
+//   program [options] firmware.elf
+//     --leds ws2812|pwm   LED output: WS2812 on pin 6 (default) or F5 PWM
+//     --seconds N         glove time to run (default 60)
+//     --raise-every N     seconds between hand raises (default 10)
+//     --baseline FILE     compare with an earlier run's output
+//     --tolerance PCT     slowdown allowed against the baseline (default 2)
+//
+// The hand lies flat, then every --raise-every seconds (from 2 s on)
+// raises to 70 degrees over 300 ms, holds for a second and lowers over
+// 300 ms. Results go to stdout as `name value` lines, comments after #:
+//   loop_*, frame_*, sensor_*   CPU cycles per call of loop(),
+//                               animationTask() and sensorTask(), found
+//                               by symbol (skipped if inlined away)
+//   cpu_busy_pct                cycles not spent in sleep
+//   ws2812_*                    frames latched and bit-stream cycles
+//   raise_to_pixel_us_*         raise onset to the first LED change
+// A raise only counts when the LEDs had been still for 500 ms before it.
+// Exits 1 if the firmware crashes or a counted raise gets no LED change
+// before the next one.
+//
+// With --baseline, every *_mean, *_max and *_pct metric is compared with
+// the baseline's (lower is better) and the run fails if one is more than
+// --tolerance percent higher. simavr is deterministic, so an unchanged
+// image reproduces its numbers exactly.
+
+static const uint32_t F_CPU_HZ = 16000000UL;
+static const uint64_t RAISE_ONSET_US = 2000000ULL;
+static const uint64_t QUIET_US = 500000ULL;
+
+// ===== Pose script =====
+
+static uint64_t raiseEveryMicros = 10000000ULL;
+
+static Mpu6050Pose raiseCycle(uint64_t us, void *) {
+    float pitch = 0.0f;
+    if (us >= RAISE_ONSET_US) {
+        uint64_t t = (us - RAISE_ONSET_US) % raiseEveryMicros / 1000;
+        if (t < 300) pitch = 70.0f * t / 300.0f;
+        else if (t < 1300) pitch = 70.0f;
+        else if (t < 1600) pitch = 70.0f * (1600 - t) / 300.0f;
+    }
+    return poseAtPitch(pitch);
+}
+
+// ===== Function probes =====
+
+// CPU cycles (sleep excluded) from a function's entry to its return.
+// The return is the first instruction after which SP is above its value
+// at entry, which also covers a tail call out of the function.
+struct Probe {
+    const char *metric;
+    const char *symbol;
+    uint32_t address;
+    bool found;
+    bool inside;
+    uint16_t entrySp;
+    uint64_t entryBusy;
+    uint32_t calls;
+    uint64_t total;
+    uint64_t worst;
+};
+
+// The tilt test is an out-of-line static member unless LTO inlines it
+// (int16_t is int on AVR, hence the iii)
+static Probe probes[] = {
+    { "loop", "_Z4loopv" },
+    { "frame", "_Z13animationTaskv" },
+    { "sensor", "_Z10sensorTaskv" },
+    { "tilt", "_ZN14MotionDetector21isPitchAboveThresholdEiii" },
+};
+static const uint8_t NUM_PROBES = sizeof(probes) / sizeof(probes[0]);
+
+// Image size as avr-size counts it: flash holds .text and the .data
+// initializers, static RAM is .data, .bss and .noinit
+static uint32_t flashBytes = 0;
+static uint32_t ramBytes = 0;
+
+static void addSection(const char *name, uint32_t size) {
+    if (strcmp(name, ".text") == 0 || strcmp(name, ".data") == 0) {
+        flashBytes += size;
+    }
+    if (strcmp(name, ".data") == 0 || strcmp(name, ".bss") == 0 ||
+        strcmp(name, ".noinit") == 0) {
+        ramBytes += size;
+    }
+}
+
+// Look the probes up in the symbol table (LTO may add a .suffix) and
+// add up the image size
+static bool findProbes(const char *path) {
+    if (elf_version(EV_CURRENT) == EV_NONE) {
+        return false;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    Elf *elf = elf_begin(fd, ELF_C_READ, nullptr);
+    size_t names = 0;
+    if (elf && elf_getshdrstrndx(elf, &names) != 0) {
+        names = 0;
+    }
+    Elf_Scn *section = nullptr;
+    while (elf && (section = elf_nextscn(elf, section)) != nullptr) {
+        GElf_Shdr header;
+        if (!gelf_getshdr(section, &header)) {
+            continue;
+        }
+        const char *sectionName = names ? elf_strptr(elf, names, header.sh_name) : nullptr;
+        if (sectionName) {
+            addSection(sectionName, (uint32_t)header.sh_size);
+        }
+        if (header.sh_type != SHT_SYMTAB) {
+            continue;
+        }
+        Elf_Data *data = elf_getdata(section, nullptr);
+        size_t count = header.sh_entsize ? header.sh_size / header.sh_entsize : 0;
+        for (size_t i = 0; i < count; i++) {
+            GElf_Sym symbol;
+            if (!gelf_getsym(data, (int)i, &symbol) ||
+                GELF_ST_TYPE(symbol.st_info) != STT_FUNC) {
+                continue;
+            }
+            const char *name = elf_strptr(elf, header.sh_link, symbol.st_name);
+            for (uint8_t p = 0; name && p < NUM_PROBES; p++) {
+                size_t length = strlen(probes[p].symbol);
+                if (strncmp(name, probes[p].symbol, length) == 0 &&
+                    (name[length] == '\0' || name[length] == '.')) {
+                    probes[p].address = (uint32_t)symbol.st_value;
+                    probes[p].found = true;
+                }
+            }
+        }
+    }
+    if (elf) {
+        elf_end(elf);
+    }
+    close(fd);
+    return true;
+}
+
+static uint16_t stackPointer(avr_t *avr) {
+    return avr->data[R_SPL] | avr->data[R_SPH] << 8;
+}
+
+static void updateProbes(avr_t *avr, uint64_t busy) {
+    for (uint8_t i = 0; i < NUM_PROBES; i++) {
+        Probe &p = probes[i];
+        if (!p.found) {
+            continue;
+        }
+        if (!p.inside) {
+            if (avr->pc == p.address) {
+                p.inside = true;
+                p.entrySp = stackPointer(avr);
+                p.entryBusy = busy;
+            }
+        } else if (stackPointer(avr) > p.entrySp) {
+            uint64_t cycles = busy - p.entryBusy;
+            p.inside = false;
+            p.calls++;
+            p.total += cycles;
+            if (cycles > p.worst) {
+                p.worst = cycles;
+            }
+        }
+    }
+}
+
+// ===== Results =====
+
+struct Result {
+    char name[48];
+    double value;
+};
+
+static std::vector<Result> results;
+
+static void result(const char *name, double value) {
+    Result r;
+    snprintf(r.name, sizeof(r.name), "%s", name);
+    r.value = value;
+    results.push_back(r);
+    printf("%-28s %.1f\n", name, value);
+}
+
+static bool lowerIsBetter(const char *name) {
+    size_t length = strlen(name);
+    return (length > 6 && strcmp(name + length - 6, "_bytes") == 0) ||
+           (length > 5 && strcmp(name + length - 5, "_mean") == 0) ||
+           (length > 4 && strcmp(name + length - 4, "_max") == 0) ||
+           (length > 4 && strcmp(name + length - 4, "_pct") == 0);
+}
+
+// Regressions against a baseline run, or -1 if it can't be read
+static int compareBaseline(const char *path, double tolerancePct) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    int compared = 0, regressions = 0;
+    char line[128];
+    while (fgets(line, sizeof(line), file)) {
+        char name[48];
+        double base;
+        if (line[0] == '#' || sscanf(line, "%47s %lf", name, &base) != 2 ||
+            !lowerIsBetter(name)) {
+            continue;
+        }
+        for (const Result &r : results) {
+            if (strcmp(r.name, name) != 0) {
+                continue;
+            }
+            compared++;
+            double limit = base * (1.0 + tolerancePct / 100.0);
+            if (r.value > limit && r.value > base) {
+                regressions++;
+                printf("# REGRESSION %s: %.1f -> %.1f (%+.1f%%)\n", name, base, r.value,
+                       base > 0 ? (r.value - base) * 100.0 / base : 100.0);
+            }
+        }
+    }
+    fclose(file);
+    printf("# baseline %s: %d metrics compared, %d regressed (tolerance %.1f%%)\n", path,
+           compared, regressions, tolerancePct);
+    return regressions;
+}
+
+// ===== Run =====
+
+static void usage() {
+    fprintf(stderr, "usage: program [--leds ws2812|pwm] [--seconds N] [--raise-every N]\n"
+                    "               [--baseline FILE] [--tolerance PCT] firmware.elf\n");
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    const char *firmwarePath = nullptr;
+    const char *baselinePath = nullptr;
+    bool pwm = false;
+    uint32_t seconds = 60;
+    double tolerancePct = 2.0;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--leds") == 0 && hasValue) {
+            pwm = strcmp(argv[++i], "pwm") == 0;
+        } else if (strcmp(argv[i], "--seconds") == 0 && hasValue) {
+            seconds = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--raise-every") == 0 && hasValue) {
+            raiseEveryMicros = (uint64_t)atoi(argv[++i]) * 1000000ULL;
+        } else if (strcmp(argv[i], "--baseline") == 0 && hasValue) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && hasValue) {
+            tolerancePct = atof(argv[++i]);
+        } else if (argv[i][0] != '-' && !firmwarePath) {
+            firmwarePath = argv[i];
+        } else {
+            usage();
+        }
+    }
+    if (!firmwarePath || seconds == 0 || raiseEveryMicros < 2 * RAISE_ONSET_US) {
+        usage();
+    }
+
+    static elf_firmware_t firmware;
+    if (elf_read_firmware(firmwarePath, &firmware) != 0) {
+        fprintf(stderr, "can't load %s\n", firmwarePath);
+        return 2;
+    }
+    strcpy(firmware.mmcu, "atmega328p");
+    firmware.frequency = F_CPU_HZ;
+    avr_t *avr = avr_make_mcu_by_name(firmware.mmcu);
+    if (!avr) {
+        fprintf(stderr, "simavr has no atmega328p core\n");
+        return 2;
+    }
+    avr_init(avr);
+    avr_load_firmware(avr, &firmware);
+    findProbes(firmwarePath);
+
+    // DEBUG text costs the firmware its cycles but isn't echoed here
+    uint32_t uartFlags = 0;
+    avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &uartFlags);
+    uartFlags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &uartFlags);
+
+    Mpu6050Part mpu(avr, raiseCycle, nullptr);
+    LedCapture leds(avr);
+    if (pwm) {
+        leds.attachPwm();
+    } else {
+        leds.attachWs2812(6);
+    }
+
+    const uint64_t cyclesPerMicro = F_CPU_HZ / 1000000UL;
+    const uint64_t end = (uint64_t)seconds * F_CPU_HZ;
+    uint64_t nextOnset = RAISE_ONSET_US * cyclesPerMicro;
+    uint64_t armedAt = 0;
+    bool armed = false;
+    uint32_t raises = 0, skipped = 0, unanswered = 0;
+    std::vector<uint64_t> latencies;
+
+    uint64_t busy = 0;
+    int state = cpu_Running;
+    while (avr->cycle < end) {
+        uint64_t before = avr->cycle;
+        bool running = avr->state == cpu_Running;
+        state = avr_run(avr);
+        if (state == cpu_Done || state == cpu_Crashed) {
+            break;
+        }
+        if (running) {
+            busy += avr->cycle - before;
+        }
+        updateProbes(avr, busy);
+        leds.poll();
+
+        if (armed && leds.getLastChange() > armedAt) {
+            latencies.push_back(leds.getLastChange() - armedAt);
+            armed = false;
+        }
+        if (avr->cycle >= nextOnset) {
+            raises++;
+            unanswered += armed;
+            // LEDs still moving from the last raise: nothing to time
+            armed = leds.getLastChange() + QUIET_US * cyclesPerMicro <= nextOnset;
+            skipped += !armed;
+            armedAt = nextOnset;
+            nextOnset += raiseEveryMicros * cyclesPerMicro;
+        }
+    }
+    unanswered += armed;
+
+    printf("# %s: %u s at %lu MHz, %s LEDs, raise every %lu s\n", firmwarePath,
+           (unsigned)seconds, (unsigned long)(F_CPU_HZ / 1000000UL), pwm ? "PWM" : "WS2812",
+           (unsigned long)(raiseEveryMicros / 1000000ULL));
+    if (state == cpu_Crashed || state == cpu_Done) {
+        printf("# firmware %s at cycle %llu (pc 0x%04x)\n",
+               state == cpu_Crashed ? "CRASHED" : "stopped", (unsigned long long)avr->cycle,
+               (unsigned)avr->pc);
+    }
+    if (flashBytes) {
+        result("flash_bytes", flashBytes);
+        result("ram_static_bytes", ramBytes);
+    }
+    result("cycles", (double)avr->cycle);
+    result("cpu_busy_pct", avr->cycle ? busy * 100.0 / avr->cycle : 0.0);
+    for (uint8_t i = 0; i < NUM_PROBES; i++) {
+        const Probe &p = probes[i];
+        char name[48];
+        if (!p.found || p.calls == 0) {
+            printf("# %s: no calls to %s%s\n", p.metric, p.symbol,
+                   p.found ? "" : " (symbol not in the image)");
+            continue;
+        }
+        snprintf(name, sizeof(name), "%s_calls", p.metric);
+        result(name, p.calls);
+        snprintf(name, sizeof(name), "%s_cycles_mean", p.metric);
+        result(name, (double)p.total / p.calls);
+        snprintf(name, sizeof(name), "%s_cycles_max", p.metric);
+        result(name, (double)p.worst);
+    }
+    if (!pwm) {
+        result("ws2812_frames", leds.getFrames());
+        result("ws2812_leds", leds.getFrameLeds());
+        if (leds.getFrames()) {
+            result("ws2812_stream_cycles_mean", (double)leds.getStreamCycles() / leds.getFrames());
+            result("ws2812_stream_cycles_max", (double)leds.getStreamWorst());
+        }
+    }
+    result("led_changes", leds.getChanges());
+    result("i2c_register_reads", mpu.getReads());
+    result("raises", raises);
+    result("raises_skipped", skipped);
+    result("raises_unanswered", unanswered);
+    if (!latencies.empty()) {
+        uint64_t sum = 0, worst = 0;
+        for (uint64_t l : latencies) {
+            sum += l;
+            worst = l > worst ? l : worst;
+        }
+        result("raise_to_pixel_us_mean", (double)sum / latencies.size() / cyclesPerMicro);
+        result("raise_to_pixel_us_max", (double)worst / cyclesPerMicro);
+    }
+
+    int failed = state == cpu_Crashed || unanswered > 0;
+    if (baselinePath) {
+        int regressions = compareBaseline(baselinePath, tolerancePct);
+        if (regressions < 0) {
+            fprintf(stderr, "can't read baseline %s\n", baselinePath);
+            return 2;
+        }
+        failed |= regressions > 0;
+    }
+    fflush(stdout);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "config.h"
+#include "gesture_recognizer.h"
+#include "orientation_filter.h"
+#include "telemetry.h"
+
+// Host decoder for the TELEMETRY stream (see telemetry.h).
+//
+// Usage:
+//   program [capture.tlm]     decode a capture (stdin without a file)
+//
+// Capture with: pio device monitor -e full_telemetry --raw > glove.tlm
+// Prints one line per record, then totals: records, frames that failed
+// to decode (including any DEBUG text), and records lost to seq gaps.
+
+static const char *TASK_NAMES[] = { "sensor", "animation", "housekeeping", "telemetry", "sample" };
+static const uint8_t NUM_TASK_NAMES = sizeof(TASK_NAMES) / sizeof(TASK_NAMES[0]);
+
+static void printRecord(const TelemetryRecord &r) {
+    printf("%10.3f s  #%-3u ", r.millis / 1000.0, r.seq);
+    switch (r.type) {
+        case TELEM_SAMPLE: {
+            int16_t x = r.int16At(0), y = r.int16At(2), z = r.int16At(4);
+            float pitch = atan2f(-x, sqrtf((float)y * y + (float)z * z)) * (float)RAD_TO_DEG;
+            printf("sample    %6d %6d %6d  pitch %6.1f", x, y, z, pitch);
+            if (r.int16At(6) != TELEM_NO_PITCH) {
+                printf("  fused %6.1f", r.int16At(6) / (float)ORIENTATION_UNITS_PER_DEG);
+            }
+            printf("%s%s\n", r.payload[8] & TELEM_FLAG_RAISED ? "  raised" : "",
+                   r.payload[8] & TELEM_FLAG_TRIGGERED ? "  TRIGGERED" : "");
+            break;
+        }
+        case TELEM_GESTURE:
+            printf("gesture   %s  confidence %u\n", GestureRecognizer::name(r.payload[0]),
+                   r.payload[1]);
+            break;
+        case TELEM_FIFO_OVERFLOW:
+            printf("fifo      overflow, reset\n");
+            break;
+        case TELEM_DROPPED:
+            printf("dropped   %u records (ring full)\n", (uint16_t)r.int16At(0));
+            break;
+        case TELEM_TASK_STATS:
+            printf("task      %-12s idle %3u%%  overruns %u  max late %u us  max run %u us\n",
+                   r.payload[0] < NUM_TASK_NAMES ? TASK_NAMES[r.payload[0]] : "?", r.payload[1],
+                   (uint16_t)r.int16At(2), (uint16_t)r.int16At(4), (uint16_t)r.int16At(6));
+            break;
+        case TELEM_WAKE:
+            printf("wake      #%u  first sample after %u us\n", (uint16_t)r.int16At(2),
+                   (uint16_t)r.int16At(0));
+            break;
+        case TELEM_SAMPLING:
+            printf("sampling  %s  %u Hz  variance %u\n", r.payload[0] ? "motion" : "still",
+                   (uint16_t)r.int16At(1), (uint16_t)r.int16At(3));
+            break;
+        case TELEM_SAMPLING_STATS:
+            printf("sampling  average %u Hz  sensor busy %u us  switches %u\n",
+                   (uint16_t)r.int16At(0), (uint16_t)r.int16At(2), (uint16_t)r.int16At(4));
+            break;
+        default:
+            printf("type %u   (%u bytes)\n", r.type, r.length);
+            break;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc > 2) {
+        fprintf(stderr, "usage: %s [capture.tlm]\n", argv[0]);
+        return 2;
+    }
+    FILE *file = argc == 2 ? fopen(argv[1], "rb") : stdin;
+    if (!file) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    TelemetryDecoder decoder;
+    TelemetryRecord record;
+    uint32_t dropped = 0;
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        if (decoder.push((uint8_t)c, record)) {
+            if (record.type == TELEM_DROPPED) {
+                dropped += (uint16_t)record.int16At(0);
+            }
+            printRecord(record);
+        }
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+
+    printf("\n%u records, %u bad frames, %u lost by seq (%u reported dropped)\n",
+           decoder.getRecords(), decoder.getBadFrames(), decoder.getLost(), dropped);
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "adaptive_sampler.h"
+
+static_assert(ADAPTIVE_STILL_MG < ADAPTIVE_MOVE_MG,
+              "ADAPTIVE_STILL_MG must be below ADAPTIVE_MOVE_MG");
+static_assert(ADAPTIVE_STILL_RATE < ADAPTIVE_MOTION_RATE && ADAPTIVE_MOTION_RATE <= 1000 &&
+              1000 % ADAPTIVE_STILL_RATE == 0 && 1000 % ADAPTIVE_MOTION_RATE == 0,
+              "adaptive rates must divide the 1 kHz DLPF rate");
+
+// Counts are reduced to 1024 per g (as in the tilt test), so one axis
+// deviation squared stays below 2^24 and three of them fit in 32 bits
+static const uint8_t ACCEL_SHIFT = 4;
+
+static constexpr uint32_t varianceFromMg(uint32_t mg) {
+    return (mg * 1024 / 1000) * (mg * 1024 / 1000);
+}
+
+static constexpr uint32_t MOVE_VARIANCE = varianceFromMg(ADAPTIVE_MOVE_MG);
+static constexpr uint32_t STILL_VARIANCE = varianceFromMg(ADAPTIVE_STILL_MG);
+
+AdaptiveSampler::AdaptiveSampler()
+    : meanX(0), meanY(0), meanZ(0), varianceSum(0), seeded(false), current(SAMPLING_MOTION),
+      lastMoving(0) {
+}
+
+void AdaptiveSampler::reset(SamplingProfile profile, unsigned long now) {
+    seeded = false;
+    varianceSum = 0;
+    current = profile;
+    lastMoving = now;
+}
+
+uint16_t AdaptiveSampler::rateFor(SamplingProfile profile) {
+    return profile == SAMPLING_STILL ? ADAPTIVE_STILL_RATE : ADAPTIVE_MOTION_RATE;
+}
+
+MPU6050Bandwidth AdaptiveSampler::bandwidthFor(SamplingProfile profile) {
+    return profile == SAMPLING_STILL ? MPU6050_DLPF_10HZ : MPU6050_DLPF_94HZ;
+}
+
+bool AdaptiveSampler::update(int16_t x, int16_t y, int16_t z, unsigned long timestamp) {
+    int16_t xs = x >> ACCEL_SHIFT;
+    int16_t ys = y >> ACCEL_SHIFT;
+    int16_t zs = z >> ACCEL_SHIFT;
+
+    if (!seeded) {
+        meanX = (int32_t)xs << ADAPTIVE_VARIANCE_SHIFT;
+        meanY = (int32_t)ys << ADAPTIVE_VARIANCE_SHIFT;
+        meanZ = (int32_t)zs << ADAPTIVE_VARIANCE_SHIFT;
+        seeded = true;
+    }
+
+    // Deviation from the mean so far; the scaled mean then moves by the
+    // whole deviation, i.e. the mean by 1 / 2^SHIFT of it
+    int16_t dx = xs - (int16_t)(meanX >> ADAPTIVE_VARIANCE_SHIFT);
+    int16_t dy = ys - (int16_t)(meanY >> ADAPTIVE_VARIANCE_SHIFT);
+    int16_t dz = zs - (int16_t)(meanZ >> ADAPTIVE_VARIANCE_SHIFT);
+    meanX += dx;
+    meanY += dy;
+    meanZ += dz;
+
+    uint32_t deviation = (uint32_t)((int32_t)dx * dx) + (uint32_t)((int32_t)dy * dy) +
+                         (uint32_t)((int32_t)dz * dz);
+    if (deviation > varianceSum) {
+        varianceSum += (deviation - varianceSum) >> ADAPTIVE_VARIANCE_SHIFT;
+    } else {
+        varianceSum -= (varianceSum - deviation) >> ADAPTIVE_VARIANCE_SHIFT;
+    }
+
+    if (current == SAMPLING_STILL) {
+        if (varianceSum > MOVE_VARIANCE) {
+            current = SAMPLING_MOTION;
+            lastMoving = timestamp;
+            return true;
+        }
+        return false;
+    }
+
+    if (varianceSum > STILL_VARIANCE) {
+        lastMoving = timestamp;
+        return false;
+    }
+    if (timestamp - lastMoving >= ADAPTIVE_HOLD_MS) {
+        current = SAMPLING_STILL;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,60 @@
+#ifndef ADAPTIVE_SAMPLER_H
+#define ADAPTIVE_SAMPLER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "mpu6050_driver.h"
+
+// ===== Motion-Adaptive Sample Rate =====
+// Running mean and variance of the accelerometer, each moved
+// 1 / 2^ADAPTIVE_VARIANCE_SHIFT of the way toward the newest sample (the
+// variance is the sum over the three axes). Above ADAPTIVE_MOVE_MG
+// squared the sampler switches to the motion profile at once. It drops
+// back to the still profile once the variance has stayed below
+// ADAPTIVE_STILL_MG squared for ADAPTIVE_HOLD_MS. Integer only. Counts
+// are taken at +/-2g and reduced to 1024 per g, as in the tilt test.
+//
+// The sampler only decides; MotionDetector programs the MPU6050 and
+// reports each switch as a SamplingEvent.
+
+enum SamplingProfile : uint8_t {
+    SAMPLING_STILL,     // ADAPTIVE_STILL_RATE, DLPF 10 Hz
+    SAMPLING_MOTION     // ADAPTIVE_MOTION_RATE, DLPF 94 Hz
+};
+
+// A profile switch, as reported by MotionDetector::pollSamplingChange()
+struct SamplingEvent {
+    uint8_t profile;            // SamplingProfile
+    uint16_t rate;              // Output data rate now set (Hz)
+    unsigned long timestamp;    // ms, of the sample that caused it
+};
+
+class AdaptiveSampler {
+public:
+    AdaptiveSampler();
+
+    // Forget the history (after a gap) and start in `profile`
+    void reset(SamplingProfile profile, unsigned long now);
+
+    // Fold in one raw sample taken at `timestamp` (ms). Returns true if
+    // the profile changed.
+    bool update(int16_t x, int16_t y, int16_t z, unsigned long timestamp);
+
+    SamplingProfile profile() const { return current; }
+
+    // Running variance, (1024-per-g counts)^2
+    uint32_t variance() const { return varianceSum; }
+
+    static uint16_t rateFor(SamplingProfile profile);
+    static MPU6050Bandwidth bandwidthFor(SamplingProfile profile);
+
+private:
+    // Means, 1024-per-g counts scaled by 2^ADAPTIVE_VARIANCE_SHIFT
+    int32_t meanX, meanY, meanZ;
+    uint32_t varianceSum;
+    bool seeded;
+    SamplingProfile current;
+    unsigned long lastMoving;   // ms, last sample above the still level
+};
+
+#endif // ADAPTIVE_SAMPLER_H
@@ -0,0 +1,131 @@
+#include "animation.h"
+
+// Keyframe fields:
+//   duration, curve, LED pattern, from, to, breathe cycle step, LED offset,
+//   color set
+
+const uint8_t ANIM_COLOR_SETS[ANIM_COLOR_SET_COUNT][2][3] PROGMEM = {
+    { { COLOR_PRIMARY }, { COLOR_SECONDARY } },
+    { { COLOR_FAULT }, { COLOR_FAULT } },
+    { { COLOR_LOW_BATTERY }, { COLOR_LOW_BATTERY } },
+};
+
+// Sequence timings
+#define POWER_UP_MS 500
+#define FADE_OUT_MS 1000
+
+static_assert(ACTIVE_DURATION > POWER_UP_MS && ACTIVE_DURATION - POWER_UP_MS <= 65535,
+              "steady phase must fit a keyframe");
+static_assert(waveCycleStep(BREATHE_PERIOD_MS) <= 65535, "breathe period too short");
+
+// Activation: LEDs light one by one, breathe until ACTIVE_DURATION after
+// the trigger, then fade out
+const AnimKeyframe ANIM_ACTIVATION[3] PROGMEM = {
+    { POWER_UP_MS, ANIM_HOLD, ANIM_LEDS_FILL, BRIGHTNESS, BRIGHTNESS,
+      0, POWER_UP_MS / NUM_LEDS, ANIM_COLORS_THEME },
+    { ACTIVE_DURATION - POWER_UP_MS, ANIM_BREATHE, ANIM_LEDS_ALL, 150, 255,
+      waveCycleStep(BREATHE_PERIOD_MS), 0, ANIM_COLORS_THEME },
+    { FADE_OUT_MS, ANIM_GAMMA, ANIM_LEDS_ALL, BRIGHTNESS, 0,
+      0, 0, ANIM_COLORS_THEME },
+};
+
+static_assert(waveCycleStep(IDLE_GLOW_PERIOD_MS) <= 65535, "idle glow period too short");
+
+// Idle glow: every LED breathing well below full brightness
+const AnimKeyframe ANIM_IDLE_GLOW[1] PROGMEM = {
+    { IDLE_GLOW_PERIOD_MS, ANIM_BREATHE, ANIM_LEDS_ALL, IDLE_GLOW_LOW, IDLE_GLOW_HIGH,
+      waveCycleStep(IDLE_GLOW_PERIOD_MS), 0, ANIM_COLORS_THEME },
+};
+
+// Sensor fault: all LEDs blinking at 2.5 Hz (the old setup() error loop)
+const AnimKeyframe ANIM_STATUS_FAULT[2] PROGMEM = {
+    { 200, ANIM_HOLD, ANIM_LEDS_ALL, 255, 255, 0, 0, ANIM_COLORS_FAULT },
+    { 200, ANIM_HOLD, ANIM_LEDS_OFF, 255, 255, 0, 0, ANIM_COLORS_FAULT },
+};
+
+// Low battery: the first LED fades in and out every 2 s, the rest untouched
+const AnimKeyframe ANIM_STATUS_LOW_BATTERY[2] PROGMEM = {
+    { 1000, ANIM_EASE, ANIM_LEDS_CHASE, 0, 255, 0, 65535, ANIM_COLORS_LOW_BATTERY },
+    { 1000, ANIM_EASE, ANIM_LEDS_CHASE, 255, 0, 0, 65535, ANIM_COLORS_LOW_BATTERY },
+};
+
+// LED validation loop for TEST_MODE
+const AnimKeyframe ANIM_LED_TEST[4] PROGMEM = {
+    { 2000, ANIM_HOLD, ANIM_LEDS_ALL, BRIGHTNESS, BRIGHTNESS, 0, 0, ANIM_COLORS_THEME },
+    { 2000, ANIM_HOLD, ANIM_LEDS_OFF, BRIGHTNESS, BRIGHTNESS, 0, 0, ANIM_COLORS_THEME },
+    { 4000, ANIM_HOLD, ANIM_LEDS_CHASE, BRIGHTNESS, BRIGHTNESS, 0, 500, ANIM_COLORS_THEME },
+    { 5000, ANIM_BREATHE, ANIM_LEDS_ALL, 50, 255, waveCycleStep(BREATHE_PERIOD_MS), 0,
+      ANIM_COLORS_THEME },
+};
+
+bool AnimationTimeline::advance(unsigned long now, uint8_t numLeds) {
+    if (!timeline) {
+        return false;
+    }
+    
+    // Keyframes end on exact boundaries, so a late frame does not
+    // stretch the timeline
+    unsigned long elapsed = now - keyframeStart;
+    while (elapsed >= current.durationMs) {
+        keyframeStart += current.durationMs;
+        elapsed -= current.durationMs;
+        if (++index >= numKeyframes) {
+            if (!looping) {
+                stop();
+                return false;
+            }
+            index = 0;
+        }
+        load(index);
+    }
+    
+    level = brightnessAt(elapsed);
+    
+    firstLit = 0;
+    endLit = 0;
+    switch (current.pattern) {
+        case ANIM_LEDS_ALL:
+            endLit = numLeds;
+            break;
+        case ANIM_LEDS_FILL: {
+            unsigned long lit = elapsed / current.ledOffsetMs;
+            endLit = lit < numLeds ? lit : numLeds;
+            break;
+        }
+        case ANIM_LEDS_CHASE:
+            firstLit = (elapsed / current.ledOffsetMs) % numLeds;
+            endLit = firstLit + 1;
+            break;
+    }
+    return true;
+}
+
+void AnimationTimeline::load(uint8_t keyframe) {
+    index = keyframe;
+    memcpy_P(&current, &timeline[keyframe], sizeof(current));
+    rampStep = 16777216UL / current.durationMs;
+    DEBUG_PRINT("Keyframe ");
+    DEBUG_PRINTLN(keyframe);
+}
+
+uint8_t AnimationTimeline::brightnessAt(unsigned long elapsed) const {
+    uint8_t t;
+    switch (current.curve) {
+        case ANIM_LINEAR:
+            t = (elapsed * rampStep) >> 16;
+            break;
+        case ANIM_GAMMA:
+            t = waveGammaRamp8((elapsed * rampStep) >> 16, current.from <= current.to);
+            break;
+        case ANIM_EASE:
+            t = waveEaseInOut8((elapsed * rampStep) >> 16);
+            break;
+        case ANIM_BREATHE:
+            return waveScale8(waveSine8(wavePhase8(elapsed, current.cycleStep)),
+                              current.from, current.to);
+        case ANIM_HOLD:
+        default:
+            return current.from;
+    }
+    return colorLerp8(current.from, current.to, t);
+}
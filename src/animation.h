@@ -0,0 +1,204 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include "config.h"
+#include "waveforms.h"
+#include "profiler.h"
+
+// ===== Keyframe Animation Engine =====
+// An animation is a timeline of keyframes stored in flash. Each keyframe
+// runs for a fixed time and describes the global brightness curve,
+// which LEDs are lit and the color set they show (one color for even
+// indices, one for odd). One interpreter plays every sequence against
+// any LEDBackend.
+
+// Global brightness across a keyframe
+enum AnimCurve : uint8_t {
+    ANIM_HOLD,          // Stay at `from`
+    ANIM_LINEAR,        // from -> to
+    ANIM_GAMMA,         // from -> to, perceptually even (gamma 2.2)
+    ANIM_EASE,          // from -> to, ease-in/out
+    ANIM_BREATHE        // Sine between from and to, one cycle per `cycleStep`
+};
+
+// Which LEDs are lit across a keyframe
+enum AnimPattern : uint8_t {
+    ANIM_LEDS_OFF,
+    ANIM_LEDS_ALL,
+    ANIM_LEDS_FILL,     // LED i lights at (i + 1) * ledOffsetMs and stays lit
+    ANIM_LEDS_CHASE     // One LED at a time, advancing every ledOffsetMs
+};
+
+// Colors of lit LEDs across a keyframe: entries of ANIM_COLOR_SETS
+enum AnimColors : uint8_t {
+    ANIM_COLORS_THEME,          // COLOR_PRIMARY / COLOR_SECONDARY
+    ANIM_COLORS_FAULT,          // COLOR_FAULT
+    ANIM_COLORS_LOW_BATTERY,    // COLOR_LOW_BATTERY
+    ANIM_COLOR_SET_COUNT
+};
+
+// Even-LED and odd-LED color (R, G, B) of each AnimColors
+extern const uint8_t ANIM_COLOR_SETS[ANIM_COLOR_SET_COUNT][2][3] PROGMEM;
+
+struct AnimKeyframe {
+    uint16_t durationMs;    // Must be non-zero
+    uint8_t curve;          // AnimCurve
+    uint8_t pattern;        // AnimPattern
+    uint8_t from;           // Brightness at the start (or breathing low)
+    uint8_t to;             // Brightness at the end (or breathing high)
+    uint16_t cycleStep;     // ANIM_BREATHE: waveCycleStep(period)
+    uint16_t ledOffsetMs;   // ANIM_LEDS_FILL / ANIM_LEDS_CHASE: per-LED step
+    uint8_t colors;         // AnimColors
+};
+
+// Timelines (animation.cpp)
+extern const AnimKeyframe ANIM_ACTIVATION[3] PROGMEM;   // Power-up, breathe, fade out
+extern const AnimKeyframe ANIM_LED_TEST[4] PROGMEM;     // On, off, one by one, breathe
+extern const AnimKeyframe ANIM_IDLE_GLOW[1] PROGMEM;    // Slow dim breathe, looped
+extern const AnimKeyframe ANIM_STATUS_FAULT[2] PROGMEM; // Fast blink, looped
+extern const AnimKeyframe ANIM_STATUS_LOW_BATTERY[2] PROGMEM;  // One LED pulsing, looped
+
+// Playback of one timeline, apart from any LEDs: the current keyframe,
+// its global brightness and the run of LEDs it lights. AnimationEngine
+// drives a backend with one; the compositor (compositor.h) stacks several.
+class AnimationTimeline {
+public:
+    AnimationTimeline()
+        : timeline(nullptr), numKeyframes(0), index(0), looping(false), keyframeStart(0),
+          rampStep(0), level(0), firstLit(0), endLit(0) {}
+    
+    // Start a timeline from its first keyframe
+    template <uint8_t N>
+    void play(const AnimKeyframe (&keyframes)[N], unsigned long now, bool loop = false) {
+        timeline = keyframes;
+        numKeyframes = N;
+        looping = loop;
+        keyframeStart = now;
+        load(0);
+    }
+    
+    void stop() {
+        timeline = nullptr;
+    }
+    
+    bool isPlaying() const {
+        return timeline != nullptr;
+    }
+    
+    uint8_t keyframeIndex() const {
+        return index;
+    }
+    
+    // Step to time `now` on a strip of numLeds. Returns false once a
+    // one-shot timeline has finished (it is then stopped).
+    bool advance(unsigned long now, uint8_t numLeds);
+    
+    // Frame state after advance()
+    uint8_t brightness() const {
+        return level;
+    }
+    
+    bool isLit(uint8_t i) const {
+        return i >= firstLit && i < endLit;
+    }
+    
+    // AnimColors of the current keyframe
+    uint8_t colors() const {
+        return current.colors;
+    }
+    
+    // Color of lit LED i in the current keyframe's set
+    void litColor(uint8_t i, uint8_t &r, uint8_t &g, uint8_t &b) const {
+        const uint8_t *entry = ANIM_COLOR_SETS[current.colors][i & 1];
+        r = pgm_read_byte(&entry[0]);
+        g = pgm_read_byte(&entry[1]);
+        b = pgm_read_byte(&entry[2]);
+    }
+    
+private:
+    const AnimKeyframe *timeline;
+    uint8_t numKeyframes;
+    uint8_t index;
+    bool looping;
+    
+    // Current keyframe, copied out of flash when it starts
+    AnimKeyframe current;
+    unsigned long keyframeStart;
+    uint32_t rampStep;      // 0-255 ramp position per ms, 16.16 fixed point
+    
+    // Lit LEDs form one run [firstLit, endLit)
+    uint8_t level;
+    uint8_t firstLit;
+    uint8_t endLit;
+    
+    void load(uint8_t keyframe);
+    uint8_t brightnessAt(unsigned long elapsed) const;
+};
+
+template <typename Backend>
+class AnimationEngine {
+public:
+    explicit AnimationEngine(Backend &target) : leds(target) {}
+    
+    // Start a timeline from its first keyframe
+    template <uint8_t N>
+    void play(const AnimKeyframe (&keyframes)[N], unsigned long now, bool loop = false) {
+        playback.play(keyframes, now, loop);
+    }
+    
+    // Turn the LEDs off and reset brightness (at once, even if the
+    // backend is holding refreshes for a slot)
+    void stop() {
+        playback.stop();
+        leds.clear();
+        leds.showNow();
+        leds.setBrightness(BRIGHTNESS);
+    }
+    
+    bool isPlaying() const {
+        return playback.isPlaying();
+    }
+    
+    uint8_t keyframeIndex() const {
+        return playback.keyframeIndex();
+    }
+    
+    // Render the frame for time `now`. Returns false once a one-shot
+    // timeline has finished (the LEDs are then off).
+    bool render(unsigned long now) {
+        if (!playback.isPlaying()) {
+            return false;
+        }
+        PROFILE_SECTION(PROF_ANIMATION);
+        
+        if (!playback.advance(now, Backend::getNumLEDs())) {
+            stop();
+            DEBUG_PRINTLN("Animation complete → Off");
+            return false;
+        }
+        
+        leds.setBrightness(playback.brightness());
+        for (uint8_t i = 0; i < Backend::getNumLEDs(); i++) {
+            if (!playback.isLit(i)) {
+                leds.setLED(i, COLOR_OFF);
+            } else {
+                uint8_t r, g, b;
+                playback.litColor(i, r, g, b);
+                leds.setLED(i, r, g, b);
+            }
+        }
+        {
+            PROFILE_SECTION(PROF_SHOW);
+            leds.show();
+        }
+        return true;
+    }
+    
+private:
+    Backend &leds;
+    AnimationTimeline playback;
+};
+
+#endif // ANIMATION_H
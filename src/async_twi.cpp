@@ -0,0 +1,236 @@
+#include "async_twi.h"
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <util/twi.h>
+
+#if ASYNC_TWI
+AsyncTwi asyncTwi;
+
+ISR(TWI_vect) {
+    asyncTwi.service();
+}
+#endif
+
+// TWINT written as one clears the flag and lets the TWI go on
+static const uint8_t CONTINUE = _BV(TWEN) | _BV(TWIE) | _BV(TWINT);
+
+AsyncTwi::AsyncTwi()
+    : result(TWI_OK), address(0), reg(0), rxBuffer(nullptr), txData(nullptr), length(0),
+      index(0), reading(false), regSent(false), callback(nullptr), started(0), errors(0),
+      timeouts(0) {
+}
+
+void AsyncTwi::begin(uint32_t clockHz) {
+    // SCL = F_CPU / (16 + 2 * TWBR), prescaler 1
+    uint32_t divider = F_CPU / clockHz;
+    TWSR = 0;
+    TWBR = divider > 16 ? (uint8_t)((divider - 16) / 2) : 0;
+    TWCR = _BV(TWEN);
+    result = TWI_OK;
+}
+
+void AsyncTwi::end() {
+    TWCR = 0;
+}
+
+bool AsyncTwi::start(uint8_t slave, uint8_t firstReg, uint8_t count, Callback done) {
+    if (result == TWI_BUSY || count == 0) {
+        return false;
+    }
+    // The last STOP may still be going out
+    unsigned long since = micros();
+    while (TWCR & _BV(TWSTO)) {
+        if (micros() - since > TWI_TIMEOUT_US) {
+            recoverBus();
+            TWCR = _BV(TWEN);
+            break;
+        }
+    }
+    address = slave;
+    reg = firstReg;
+    length = count;
+    index = 0;
+    regSent = false;
+    callback = done;
+    started = micros();
+    result = TWI_BUSY;
+    TWCR = CONTINUE | _BV(TWSTA);
+    return true;
+}
+
+bool AsyncTwi::startRead(uint8_t slave, uint8_t firstReg, uint8_t *buffer, uint8_t count,
+                         Callback done) {
+    if (result == TWI_BUSY) {
+        return false;
+    }
+    rxBuffer = buffer;
+    reading = true;
+    return start(slave, firstReg, count, done);
+}
+
+bool AsyncTwi::startWrite(uint8_t slave, uint8_t firstReg, const uint8_t *data, uint8_t count,
+                          Callback done) {
+    if (result == TWI_BUSY) {
+        return false;
+    }
+    txData = data;
+    reading = false;
+    return start(slave, firstReg, count, done);
+}
+
+uint8_t AsyncTwi::read(uint8_t slave, uint8_t firstReg, uint8_t *buffer, uint8_t count) {
+    if (count == 0) {
+        return TWI_OK;
+    }
+    while (!startRead(slave, firstReg, buffer, count)) {
+        wait();
+    }
+    return wait();
+}
+
+uint8_t AsyncTwi::write(uint8_t slave, uint8_t firstReg, const uint8_t *data, uint8_t count) {
+    if (count == 0) {
+        return TWI_OK;
+    }
+    while (!startWrite(slave, firstReg, data, count)) {
+        wait();
+    }
+    return wait();
+}
+
+uint8_t AsyncTwi::wait() {
+    // The TWI interrupt ends the sleep, and so does the Timer0 overflow
+    // (~1 ms), which keeps the timeout checked. Interrupts stay off from
+    // the check to the sleep instruction, as in TaskScheduler::idleUntil().
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    for (;;) {
+        noInterrupts();
+        if (result != TWI_BUSY) {
+            interrupts();
+            return result;
+        }
+        sleep_enable();
+        interrupts();
+        sleep_cpu();
+        sleep_disable();
+        checkTimeout();
+    }
+}
+
+bool AsyncTwi::checkTimeout() {
+    if (result != TWI_BUSY || micros() - started < TWI_TIMEOUT_US) {
+        return false;
+    }
+    // The last byte could still land; keep the interrupt out meanwhile
+    noInterrupts();
+    if (result != TWI_BUSY) {
+        interrupts();
+        return false;
+    }
+    TWCR = 0;
+    result = TWI_TIMEOUT;
+    timeouts++;
+    interrupts();
+
+    recoverBus();
+    TWCR = _BV(TWEN);
+    return true;
+}
+
+unsigned long AsyncTwi::getErrors() const {
+    noInterrupts();
+    unsigned long count = errors;
+    interrupts();
+    return count;
+}
+
+unsigned long AsyncTwi::getTimeouts() const {
+    noInterrupts();
+    unsigned long count = timeouts;
+    interrupts();
+    return count;
+}
+
+void AsyncTwi::recoverBus() {
+    // With the TWI off the pins are plain GPIO. A slave cut off mid-byte
+    // holds SDA low until it has clocked out the rest: up to nine SCL
+    // pulses (open drain: driven low, pulled up), then a STOP.
+    pinMode(SDA, INPUT_PULLUP);
+    pinMode(SCL, INPUT_PULLUP);
+    for (uint8_t i = 0; i < 9 && digitalRead(SDA) == LOW; i++) {
+        digitalWrite(SCL, LOW);
+        pinMode(SCL, OUTPUT);
+        delayMicroseconds(5);
+        pinMode(SCL, INPUT_PULLUP);
+        delayMicroseconds(5);
+    }
+    digitalWrite(SDA, LOW);
+    pinMode(SDA, OUTPUT);
+    delayMicroseconds(5);
+    pinMode(SDA, INPUT_PULLUP);
+}
+
+void AsyncTwi::finish(uint8_t status) {
+    // STOP with the interrupt off; TWSTO clears once it is on the bus
+    TWCR = _BV(TWEN) | _BV(TWINT) | _BV(TWSTO);
+    if (status != TWI_OK) {
+        errors++;
+    }
+    result = status;
+    if (callback) {
+        callback(status);
+    }
+}
+
+void AsyncTwi::service() {
+    switch (TW_STATUS) {
+        case TW_START:
+        case TW_REP_START:
+            // SLA+W for the register pointer, SLA+R after the repeated START
+            TWDR = address << 1 | (regSent ? TW_READ : TW_WRITE);
+            TWCR = CONTINUE;
+            break;
+
+        case TW_MT_SLA_ACK:
+            TWDR = reg;
+            regSent = true;
+            TWCR = CONTINUE;
+            break;
+
+        case TW_MT_DATA_ACK:
+            if (reading) {
+                TWCR = CONTINUE | _BV(TWSTA);
+            } else if (index < length) {
+                TWDR = txData[index++];
+                TWCR = CONTINUE;
+            } else {
+                finish(TWI_OK);
+            }
+            break;
+
+        case TW_MR_DATA_ACK:
+            rxBuffer[index++] = TWDR;
+            // ACK every byte but the last
+            __attribute__((fallthrough));
+        case TW_MR_SLA_ACK:
+            TWCR = index + 1 < length ? CONTINUE | _BV(TWEA) : CONTINUE;
+            break;
+
+        case TW_MR_DATA_NACK:
+            rxBuffer[index++] = TWDR;
+            finish(TWI_OK);
+            break;
+
+        case TW_MT_SLA_NACK:
+        case TW_MT_DATA_NACK:
+        case TW_MR_SLA_NACK:
+            finish(TWI_NACK);
+            break;
+
+        default:
+            // TW_BUS_ERROR, TW_MT_ARB_LOST (single master: a glitch)
+            finish(TWI_BUS_ERROR);
+            break;
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef ASYNC_TWI_H
+#define ASYNC_TWI_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ===== Interrupt-Driven TWI Master =====
+// Register reads and writes on the ATmega328 TWI, moved one byte per
+// TWI_vect interrupt instead of busy-waiting on TWINT as the Wire
+// library does. startRead()/startWrite() return at once; at 400 kHz each
+// byte takes ~23 us on the bus, during which the loop keeps running.
+// The transfer ends with its TwiStatus in status() and, optionally, a
+// callback from the interrupt. read()/write() are the blocking forms;
+// they idle-sleep until the interrupt rather than spin.
+//
+// A transfer still running TWI_TIMEOUT_US after its START (a slave
+// holding SDA low, or SCL stretched for good) is aborted by
+// checkTimeout(), which the blocking calls run for themselves: the TWI
+// is reset and SCL clocked until the slave lets go of SDA. Timeouts are
+// only noticed from the loop, so they never reach the callback.
+//
+// Owns TWI_vect, as the Wire library does: an ASYNC_TWI build must not
+// use Wire.
+
+enum TwiStatus : uint8_t {
+    TWI_OK,
+    TWI_BUSY,           // In flight
+    TWI_NACK,           // Address or data byte not acknowledged
+    TWI_BUS_ERROR,      // Illegal START/STOP, lost arbitration
+    TWI_TIMEOUT         // Aborted by checkTimeout()
+};
+
+class AsyncTwi {
+public:
+    // Runs in the interrupt when a transfer ends, with its TwiStatus
+    typedef void (*Callback)(uint8_t status);
+
+    AsyncTwi();
+
+    // Enable the TWI at `clockHz` (prescaler 1: 31 kHz to 400 kHz at 16 MHz)
+    void begin(uint32_t clockHz);
+    void end();
+
+    // Read `length` (1 or more) registers from `reg` up: register write,
+    // repeated START, read. `buffer` fills as bytes arrive. False if a
+    // transfer is still in flight.
+    bool startRead(uint8_t address, uint8_t reg, uint8_t *buffer, uint8_t length,
+                   Callback done = nullptr);
+
+    // Write `length` registers from `reg` up; `data` must stay valid
+    // until the transfer ends
+    bool startWrite(uint8_t address, uint8_t reg, const uint8_t *data, uint8_t length,
+                    Callback done = nullptr);
+
+    // Blocking: wait out the transfer in flight, run this one, return its status
+    uint8_t read(uint8_t address, uint8_t reg, uint8_t *buffer, uint8_t length);
+    uint8_t write(uint8_t address, uint8_t reg, const uint8_t *data, uint8_t length);
+
+    bool isBusy() const { return result == TWI_BUSY; }
+
+    // TwiStatus of the last transfer (TWI_BUSY while it runs)
+    uint8_t status() const { return result; }
+
+    // Abort a transfer running longer than TWI_TIMEOUT_US and recover
+    // the bus. True if one was aborted.
+    bool checkTimeout();
+
+    // Idle-sleep until the transfer in flight ends or times out; returns
+    // its status
+    uint8_t wait();
+
+    // Transfers ended by a NACK or bus error, and by a timeout
+    unsigned long getErrors() const;
+    unsigned long getTimeouts() const;
+
+    // Interrupt body
+    void service();
+
+private:
+    volatile uint8_t result;
+    uint8_t address;
+    uint8_t reg;
+    uint8_t *rxBuffer;
+    const uint8_t *txData;
+    uint8_t length;
+    uint8_t index;
+    bool reading;
+    bool regSent;
+    Callback callback;
+    unsigned long started;
+    volatile unsigned long errors;
+    volatile unsigned long timeouts;
+
+    bool start(uint8_t address, uint8_t reg, uint8_t length, Callback done);
+
+    // STOP, status, callback (interrupt side)
+    void finish(uint8_t status);
+
+    // Clock a stuck slave off SDA with the TWI disabled
+    static void recoverBus();
+};
+
+#if ASYNC_TWI
+// Owns TWI_vect
+extern AsyncTwi asyncTwi;
+#endif
+
+#endif // ASYNC_TWI_H
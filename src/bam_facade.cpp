@@ -0,0 +1,10 @@
+#include "config.h"
+
+#if defined(LED_TYPE_F5) && defined(F5_BAM)
+#include <avr/interrupt.h>
+#include "bam_facade.h"
+
+ISR(TIMER2_COMPA_vect) {
+    BAMFacade::service();
+}
+#endif
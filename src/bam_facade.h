@@ -0,0 +1,337 @@
+#ifndef BAM_FACADE_H
+#define BAM_FACADE_H
+
+#include <avr/io.h>
+#include "led_backend.h"
+#include "color_math.h"
+#include "framebuffer.h"
+#include "config.h"
+
+// Bit-angle modulation (BAM) for many monochrome LEDs.
+// A duty cycle is shown one bit at a time: bit b is held for 2^b time
+// units, so the eight bits of a 255-unit cycle add up to duty / 255.
+// Timer2 runs in CTC mode at clk/64 and interrupts at the start of each
+// bit; the ISR (bam_facade.cpp) writes one precomputed bit plane and
+// sets the compare value for that bit's length. Bits longer than one
+// timer period are held over several interrupts that only count down.
+//
+// show() builds all eight planes from the duty cycles into a back
+// buffer, so the ISR copies bytes and never looks at a single LED. The
+// ISR swaps buffers at the start of a cycle, so a frame never tears.
+// While a frame waits for its swap, a newer one stays dirty until the
+// next show() or showDeferred().
+//
+// Outputs, per SHIFT_REGISTERS:
+//   0    GPIO pins from BAM_PINS. A plane is one byte per port
+//        (PORTB/C/D), written with a masked store, so the ISR costs the
+//        same for 1 or 15 LEDs.
+//   1-n  Chained 74HC595s on hardware SPI at clk/2 (MOSI 11, SCK 13,
+//        latch 10; register 0 nearest the MCU, LED i on output i % 8 of
+//        register i / 8). The ISR latches the plane it shifted during
+//        the previous interrupt, so the switch lands at a fixed offset
+//        from the compare match, then shifts the next plane, one byte
+//        per register.
+//
+// ISR cycle budget, at 16 MHz. Cycle counts are estimated from the
+// instruction sequence, entry and exit included (~55 for an interrupt
+// that only counts down). The ISR must fit half the shortest bit,
+// leaving room for the Timer0 and UART interrupts that can delay it;
+// CPU load is over a whole cycle.
+//
+//   LEDs  output      ISR cycles  BAM_UNIT_TICKS  shortest bit     load
+//   1-15  GPIO           ~110           8         512 cycles (21%)  0.8%
+//      8  1 x 74HC595    ~122           8         512 cycles (24%)  0.9%
+//     16  2 x 74HC595    ~144           8         512 cycles (28%)  1.1%
+//     32  4 x 74HC595    ~188           8         512 cycles (37%)  1.3%
+//     56  7 x 74HC595    ~254           8         512 cycles (50%)  1.7%
+//     64  8 x 74HC595    ~276          16        1024 cycles (27%)  1.1%
+//    128  16 x 74HC595   ~452          16        1024 cycles (44%)  1.6%
+//
+// At BAM_UNIT_TICKS 8 a cycle is 255 * 32 us (122 Hz); at 16, 61 Hz,
+// which can flicker in peripheral vision.
+template <uint8_t N, uint8_t SHIFT_REGISTERS, uint8_t UNIT_TICKS = BAM_UNIT_TICKS,
+          typename Format = ConfiguredPixelFormat>
+class BAMStrip : public LEDBackend<BAMStrip<N, SHIFT_REGISTERS, UNIT_TICKS, Format>, N> {
+public:
+    static const uint8_t PLANES = 8;
+
+    // Bytes per plane: PORTB, PORTC, PORTD, or one per shift register
+    static const uint8_t PLANE_BYTES = SHIFT_REGISTERS ? SHIFT_REGISTERS : 3;
+
+    static const uint16_t TIMER_PRESCALER = 64;
+    static const uint16_t SHORTEST_BIT_CYCLES = UNIT_TICKS * TIMER_PRESCALER;
+    static const uint32_t CYCLE_CYCLES = 255UL * SHORTEST_BIT_CYCLES;
+
+    // Estimated ISR length (see the table above)
+    static const uint16_t ISR_CYCLES = SHIFT_REGISTERS ? 100 + 22 * SHIFT_REGISTERS : 110;
+    static const uint16_t HOLD_ISR_CYCLES = 55;
+
+    static_assert(N > 0, "BAMStrip needs at least one LED");
+    static_assert(SHIFT_REGISTERS == 0 || N <= SHIFT_REGISTERS * 8,
+                  "More LEDs than 74HC595 outputs");
+    static_assert(UNIT_TICKS >= 2 && (UNIT_TICKS & (UNIT_TICKS - 1)) == 0,
+                  "BAM_UNIT_TICKS must be a power of two");
+    static_assert(ISR_CYCLES <= SHORTEST_BIT_CYCLES / 2,
+                  "BAM ISR does not fit the shortest bit; raise BAM_UNIT_TICKS");
+
+private:
+    // ISR-side state, one set per strip type
+    static uint8_t planes[2][PLANES][PLANE_BYTES];
+    static uint8_t (*volatile front)[PLANE_BYTES];
+    static volatile bool swapPending;
+    static uint8_t plane;
+    static uint8_t hold;
+    static uint8_t timerTop[PLANES];
+    static uint8_t timerRepeats[PLANES];
+    static uint8_t portMask[3];
+
+    // GPIO: plane byte (port) and bit of each LED
+    uint8_t ledPort[SHIFT_REGISTERS ? 1 : N];
+    uint8_t ledMask[SHIFT_REGISTERS ? 1 : N];
+
+    FrameBuffer<Format, N> frame;
+    uint8_t ledOutput[N];
+    uint8_t globalBrightness;
+    bool dirty;
+
+    uint32_t committedFrames;
+    uint32_t skippedFrames;
+
+    // Arduino Nano pin -> plane byte (0 = PORTB, 1 = PORTC, 2 = PORTD)
+    static bool resolvePin(uint8_t pin, uint8_t &port, uint8_t &mask) {
+        if (pin < 8) {
+            port = 2;
+            mask = _BV(pin);
+        } else if (pin < 14) {
+            port = 0;
+            mask = _BV(pin - 8);
+        } else if (pin < 20) {
+            port = 1;
+            mask = _BV(pin - 14);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    static void swapIfPending() {
+        if (swapPending) {
+            front = (front == planes[0]) ? planes[1] : planes[0];
+            swapPending = false;
+        }
+    }
+
+    static void shiftPlane(const uint8_t *bytes) {
+        for (int8_t r = SHIFT_REGISTERS - 1; r >= 0; r--) {
+            SPDR = bytes[r];
+            while (!(SPSR & _BV(SPIF))) {}
+        }
+    }
+
+    static void latch() {
+        PORTB |= _BV(2);
+        PORTB &= ~_BV(2);
+    }
+
+public:
+    BAMStrip()
+        : globalBrightness(BRIGHTNESS), dirty(false), committedFrames(0), skippedFrames(0) {
+        for (uint8_t i = 0; i < N; i++) {
+            ledOutput[i] = 0;
+        }
+    }
+
+    // Timer2 compare-match A handler
+    static inline __attribute__((always_inline)) void service() {
+        if (--hold) {
+            return;
+        }
+        uint8_t next = (plane + 1) & (PLANES - 1);
+        plane = next;
+
+        if (SHIFT_REGISTERS) {
+            latch();
+            OCR2A = timerTop[next];
+            hold = timerRepeats[next];
+
+            uint8_t after = (next + 1) & (PLANES - 1);
+            if (after == 0) {
+                swapIfPending();
+            }
+            shiftPlane(front[after]);
+        } else {
+            if (next == 0) {
+                swapIfPending();
+            }
+            const uint8_t *bytes = front[next];
+            PORTB = (PORTB & ~portMask[0]) | bytes[0];
+            PORTC = (PORTC & ~portMask[1]) | bytes[1];
+            PORTD = (PORTD & ~portMask[2]) | bytes[2];
+            OCR2A = timerTop[next];
+            hold = timerRepeats[next];
+        }
+    }
+
+    void begin() {
+        memset(planes, 0, sizeof(planes));
+        front = planes[0];
+        swapPending = false;
+
+        // Bit b lasts UNIT_TICKS << b timer ticks, in periods of at most 256
+        for (uint8_t b = 0; b < PLANES; b++) {
+            uint16_t ticks = (uint16_t)UNIT_TICKS << b;
+            uint16_t period = ticks > 256 ? 256 : ticks;
+            timerTop[b] = (uint8_t)(period - 1);
+            timerRepeats[b] = (uint8_t)(ticks / period);
+        }
+
+        if (SHIFT_REGISTERS) {
+            // SS (the latch) must be an output before SPI master mode
+            pinMode(10, OUTPUT);
+            pinMode(11, OUTPUT);
+            pinMode(13, OUTPUT);
+            digitalWrite(10, LOW);
+            SPSR = _BV(SPI2X);
+            SPCR = _BV(SPE) | _BV(MSTR);
+
+            // All outputs off; plane 0 waits in the registers
+            shiftPlane(planes[0][0]);
+            latch();
+        } else {
+            static const uint8_t pins[] = { BAM_PINS };
+            static_assert(SHIFT_REGISTERS || sizeof(pins) >= N, "BAM_PINS lists fewer pins than LEDs");
+
+            portMask[0] = portMask[1] = portMask[2] = 0;
+            for (uint8_t i = 0; i < N; i++) {
+                pinMode(pins[i], OUTPUT);
+                digitalWrite(pins[i], LOW);
+                if (resolvePin(pins[i], ledPort[i], ledMask[i])) {
+                    portMask[ledPort[i]] |= ledMask[i];
+                } else {
+                    ledMask[i] = 0;
+                    DEBUG_PRINT("BAM: no such pin: ");
+                    DEBUG_PRINTLN(pins[i]);
+                }
+            }
+        }
+
+        // The first match starts plane 0
+        noInterrupts();
+        plane = PLANES - 1;
+        hold = 1;
+        TCCR2A = _BV(WGM21);
+        TCCR2B = _BV(CS22);
+        TCNT2 = 0;
+        OCR2A = timerTop[0];
+        TIMSK2 = _BV(OCIE2A);
+        interrupts();
+
+        DEBUG_PRINT("F5 LED initialized (BAM, ");
+        DEBUG_PRINT(N);
+        DEBUG_PRINTLN(SHIFT_REGISTERS ? " LEDs on 74HC595)" : " LEDs on GPIO)");
+    }
+
+    void setLED(uint8_t index, uint8_t r, uint8_t g, uint8_t b) {
+        if (index >= N) return;
+
+        if (frame.set(index, r, g, b)) {
+            dirty = true;
+        }
+    }
+
+    void show() {
+        if (!dirty) {
+            skippedFrames++;
+            return;
+        }
+        // The ISR has not taken the previous frame yet
+        if (swapPending) {
+            return;
+        }
+        dirty = false;
+
+        bool changed = false;
+        for (uint8_t i = 0; i < N; i++) {
+            uint8_t duty = colorScale8(frame.getMono(i), globalBrightness);
+            if (duty != ledOutput[i]) {
+                ledOutput[i] = duty;
+                changed = true;
+            }
+        }
+        if (!changed) {
+            skippedFrames++;
+            return;
+        }
+
+        // front only moves while swapPending is set
+        uint8_t (*back)[PLANE_BYTES] = (front == planes[0]) ? planes[1] : planes[0];
+        memset(back, 0, sizeof(planes[0]));
+        for (uint8_t i = 0; i < N; i++) {
+            uint8_t byte = SHIFT_REGISTERS ? i / 8 : ledPort[i];
+            uint8_t mask = SHIFT_REGISTERS ? _BV(i % 8) : ledMask[i];
+            uint8_t duty = ledOutput[i];
+            for (uint8_t b = 0; duty; b++, duty >>= 1) {
+                if (duty & 1) {
+                    back[b][byte] |= mask;
+                }
+            }
+        }
+        swapPending = true;
+        committedFrames++;
+    }
+
+    void showDeferred() {
+        if (dirty && !swapPending) {
+            show();
+        }
+    }
+
+    // Waits up to one BAM cycle for the ISR to take a pending frame
+    void showNow() {
+        while (swapPending) {
+            delayMicroseconds(SHORTEST_BIT_CYCLES / (F_CPU / 1000000UL));
+        }
+        show();
+    }
+
+    void setBrightness(uint8_t brightness) {
+        if (brightness != globalBrightness) {
+            globalBrightness = brightness;
+            dirty = true;
+        }
+    }
+
+    uint32_t getCommittedFrames() {
+        return committedFrames;
+    }
+
+    uint32_t getSkippedFrames() {
+        return skippedFrames;
+    }
+};
+
+template <uint8_t N, uint8_t R, uint8_t U, typename F>
+uint8_t BAMStrip<N, R, U, F>::planes[2][BAMStrip<N, R, U, F>::PLANES]
+                                    [BAMStrip<N, R, U, F>::PLANE_BYTES];
+template <uint8_t N, uint8_t R, uint8_t U, typename F>
+uint8_t (*volatile BAMStrip<N, R, U, F>::front)[BAMStrip<N, R, U, F>::PLANE_BYTES] =
+    BAMStrip<N, R, U, F>::planes[0];
+template <uint8_t N, uint8_t R, uint8_t U, typename F>
+volatile bool BAMStrip<N, R, U, F>::swapPending = false;
+template <uint8_t N, uint8_t R, uint8_t U, typename F>
+uint8_t BAMStrip<N, R, U, F>::plane = 0;
+template <uint8_t N, uint8_t R, uint8_t U, typename F>
+uint8_t BAMStrip<N, R, U, F>::hold = 1;
+template <uint8_t N, uint8_t R, uint8_t U, typename F>
+uint8_t BAMStrip<N, R, U, F>::timerTop[BAMStrip<N, R, U, F>::PLANES];
+template <uint8_t N, uint8_t R, uint8_t U, typename F>
+uint8_t BAMStrip<N, R, U, F>::timerRepeats[BAMStrip<N, R, U, F>::PLANES];
+template <uint8_t N, uint8_t R, uint8_t U, typename F>
+uint8_t BAMStrip<N, R, U, F>::portMask[3];
+
+#if defined(LED_TYPE_F5) && defined(F5_BAM)
+// The configured strip; its service() is the Timer2 ISR
+typedef BAMStrip<NUM_LEDS, BAM_SHIFT_REGISTERS> BAMFacade;
+#endif
+
+#endif // BAM_FACADE_H
@@ -0,0 +1,59 @@
+#ifndef COLOR_MATH_H
+#define COLOR_MATH_H
+
+#include <Arduino.h>
+
+// ===== 8-bit Color Math =====
+// Brightness and color arithmetic for every LED backend and animation,
+// using one 8x8 multiply and a shift instead of a division by 255. Values
+// and scales are fractions of 256: a scale of 255 passes a value through
+// unchanged and 0 gives 0. The results match FastLED's scale8,
+// nscale8x3, lerp8by8 and qadd8/qsub8. The names carry a prefix because
+// FastLED builds see both sets.
+
+// value * (scale + 1) / 256
+inline uint8_t colorScale8(uint8_t value, uint8_t scale) {
+    #ifdef __AVR__
+    // 8x8 hardware multiply plus one add, instead of widening the
+    // scale to 16 bits (three multiplies)
+    asm volatile(
+        "mul %0, %1          \n\t"   // r1:r0 = value * scale
+        "add r0, %0          \n\t"   // + value
+        "ldi %0, 0x00        \n\t"
+        "adc %0, r1          \n\t"   // High byte, with the carry
+        "clr __zero_reg__    \n\t"
+        : "+a" (value)
+        : "a" (scale)
+        : "r0", "r1");
+    return value;
+    #else
+    return (uint8_t)(((uint16_t)value * (uint16_t)(scale + 1)) >> 8);
+    #endif
+}
+
+// Scale an RGB triple in place
+inline void colorScale8x3(uint8_t &r, uint8_t &g, uint8_t &b, uint8_t scale) {
+    r = colorScale8(r, scale);
+    g = colorScale8(g, scale);
+    b = colorScale8(b, scale);
+}
+
+// from -> to as `t` goes 0 -> 255; t = 255 lands on `to` exactly
+inline uint8_t colorLerp8(uint8_t from, uint8_t to, uint8_t t) {
+    if (to >= from) {
+        return from + colorScale8(to - from, t);
+    }
+    return from - colorScale8(from - to, t);
+}
+
+// Saturating add / subtract
+inline uint8_t colorQadd8(uint8_t a, uint8_t b) {
+    uint16_t sum = (uint16_t)a + b;
+    return sum > 255 ? 255 : (uint8_t)sum;
+}
+
+inline uint8_t colorQsub8(uint8_t a, uint8_t b) {
+    return a > b ? a - b : 0;
+}
+
+#endif // COLOR_MATH_H
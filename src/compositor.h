@@ -0,0 +1,305 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "animation.h"
+#include "color_math.h"
+#include "framebuffer.h"
+#include "profiler.h"
+
+// ===== Layered Compositor =====
+// Plays several timelines at once onto one LEDBackend, such as an idle
+// glow, the activation sequence and a status overlay. Layers stack by
+// priority, the highest on top. A layer only paints the LEDs its
+// keyframe lights; the rest show what is below.
+//
+// Each layer's weight is its keyframe brightness times its opacity. A
+// lone NORMAL layer at opacity 255 over black therefore gives exactly
+// what AnimationEngine shows. The compositor runs the backend at a
+// fixed master brightness (255 by default).
+//
+// Starting or stopping a layer while anything is on the LEDs saves the
+// current frame and crossfades from it over CROSSFADE_MS, so a
+// restarted or interrupting effect does not cut to black. The saved
+// frame is the only pixel storage here: layers are worked out one pixel
+// at a time, straight into the backend.
+//
+// Everything is 8-bit fixed point. Per frame, each visible layer costs
+// six colorScale8() calls to scale its colors. Per lit pixel, each layer
+// costs three colorLerp8() calls (NORMAL) or three saturating adds. The
+// crossfade adds three colorLerp8() calls per pixel while it runs.
+
+enum BlendMode : uint8_t {
+    BLEND_NORMAL,       // Lit pixels cover what is below, in proportion to their weight
+    BLEND_ADD,          // Lit pixels add their weighted light (saturating)
+    BLEND_LIGHTEN       // Per channel, the brighter of the weighted layer and what is below
+};
+
+template <typename Backend, uint8_t LAYERS = 3, typename Format = ConfiguredPixelFormat>
+class Compositor {
+public:
+    explicit Compositor(Backend &target)
+        : leds(target), master(255), fading(false), fadeStart(0) {
+        for (uint8_t i = 0; i < LAYERS; i++) {
+            order[i] = i;
+            layers[i].priority = i;
+            layers[i].blend = BLEND_NORMAL;
+            layers[i].opacity = 255;
+            layers[i].visible = false;
+            setColors(i, COLOR_PRIMARY, COLOR_SECONDARY);
+        }
+    }
+
+    // Layer stacking and blending. Layers start at priority = index,
+    // BLEND_NORMAL, opacity 255; equal priorities stack by index.
+    void setLayer(uint8_t layer, uint8_t priority, BlendMode blend = BLEND_NORMAL,
+                  uint8_t opacity = 255) {
+        layers[layer].priority = priority;
+        layers[layer].blend = blend;
+        layers[layer].opacity = opacity;
+
+        // Insertion sort, bottom to top
+        for (uint8_t i = 0; i < LAYERS; i++) {
+            order[i] = i;
+        }
+        for (uint8_t i = 1; i < LAYERS; i++) {
+            uint8_t id = order[i];
+            uint8_t j = i;
+            while (j > 0 && layers[order[j - 1]].priority > layers[id].priority) {
+                order[j] = order[j - 1];
+                j--;
+            }
+            order[j] = id;
+        }
+    }
+
+    // Takes effect from the next frame, without a crossfade
+    void setOpacity(uint8_t layer, uint8_t opacity) {
+        layers[layer].opacity = opacity;
+    }
+
+    // Colors of lit LEDs in ANIM_COLORS_THEME keyframes: even indices, odd
+    // indices (the theme by default). Other keyframes show their own set.
+    void setColors(uint8_t layer, uint8_t r, uint8_t g, uint8_t b, uint8_t r2, uint8_t g2,
+                   uint8_t b2) {
+        uint8_t (&colors)[2][3] = layers[layer].colors;
+        colors[0][0] = r;
+        colors[0][1] = g;
+        colors[0][2] = b;
+        colors[1][0] = r2;
+        colors[1][1] = g2;
+        colors[1][2] = b2;
+    }
+
+    // Backend brightness applied under every layer
+    void setBrightness(uint8_t brightness) {
+        master = brightness;
+    }
+
+    // Start (or restart) a layer's timeline, crossfading from the frame
+    // on the LEDs
+    template <uint8_t N>
+    void play(uint8_t layer, const AnimKeyframe (&keyframes)[N], unsigned long now,
+              bool loop = false) {
+        crossfade(now);
+        layers[layer].timeline.play(keyframes, now, loop);
+    }
+
+    // Take a layer off, crossfading to what remains
+    void stop(uint8_t layer, unsigned long now) {
+        if (!layers[layer].timeline.isPlaying()) {
+            return;
+        }
+        crossfade(now);
+        layers[layer].timeline.stop();
+    }
+
+    // Stop every layer and turn the LEDs off at once (even if the backend
+    // is holding refreshes for a slot)
+    void stopAll() {
+        for (uint8_t i = 0; i < LAYERS; i++) {
+            layers[i].timeline.stop();
+            layers[i].visible = false;
+        }
+        fading = false;
+        leds.clear();
+        leds.showNow();
+    }
+
+    bool isPlaying(uint8_t layer) const {
+        return layers[layer].timeline.isPlaying();
+    }
+
+    // Something playing or a crossfade still running: render() has work
+    bool isShowing() const {
+        if (fading) {
+            return true;
+        }
+        for (uint8_t i = 0; i < LAYERS; i++) {
+            if (layers[i].timeline.isPlaying()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const AnimationTimeline &timeline(uint8_t layer) const {
+        return layers[layer].timeline;
+    }
+
+    // Render the frame for time `now`. Returns isShowing(); once it is
+    // false the LEDs are off and further calls can stop until play().
+    bool render(unsigned long now) {
+        PROFILE_SECTION(PROF_ANIMATION);
+
+        bool showing = prepare(now);
+        uint8_t t = fadeLevel(now);
+
+        leds.setBrightness(master);
+        for (uint8_t i = 0; i < Backend::getNumLEDs(); i++) {
+            uint8_t r, g, b;
+            compose(i, r, g, b);
+            if (fading) {
+                blendFrom(i, t, r, g, b);
+            }
+            leds.setLED(i, r, g, b);
+        }
+        {
+            PROFILE_SECTION(PROF_SHOW);
+            leds.show();
+        }
+        return showing || fading;
+    }
+
+private:
+    struct Layer {
+        AnimationTimeline timeline;
+        uint8_t priority;
+        uint8_t blend;          // BlendMode
+        uint8_t opacity;
+        uint8_t colors[2][3];   // Theme colors: even, odd LEDs
+
+        // Per frame, from prepare()
+        bool visible;
+        uint8_t weight;         // Keyframe brightness x opacity
+        uint8_t paint[2][3];    // colors, pre-scaled by weight for ADD / LIGHTEN
+    };
+
+    Backend &leds;
+    Layer layers[LAYERS];
+    uint8_t order[LAYERS];      // Layer ids, bottom to top
+    uint8_t master;
+
+    // Crossfade source: the frame on the LEDs when the last one began
+    FrameBuffer<Format, Backend::getNumLEDs()> from;
+    bool fading;
+    unsigned long fadeStart;
+
+    // 0-255 fade position per ms, 16.16 fixed point
+    static const uint32_t FADE_STEP = 16777216UL / CROSSFADE_MS;
+
+    // Advance every layer to `now` and scale its colors for the frame.
+    // True if any layer is still playing.
+    bool prepare(unsigned long now) {
+        bool playing = false;
+        for (uint8_t i = 0; i < LAYERS; i++) {
+            Layer &layer = layers[i];
+            layer.visible = layer.timeline.advance(now, Backend::getNumLEDs());
+            if (!layer.visible) {
+                continue;
+            }
+            playing = true;
+            layer.weight = colorScale8(layer.timeline.brightness(), layer.opacity);
+            layer.visible = layer.weight != 0;
+            uint8_t colors[2][3];
+            if (layer.timeline.colors() == ANIM_COLORS_THEME) {
+                memcpy(colors, layer.colors, sizeof(colors));
+            } else {
+                memcpy_P(colors, ANIM_COLOR_SETS[layer.timeline.colors()], sizeof(colors));
+            }
+            for (uint8_t parity = 0; parity < 2; parity++) {
+                for (uint8_t c = 0; c < 3; c++) {
+                    uint8_t color = colors[parity][c];
+                    layer.paint[parity][c] = layer.blend == BLEND_NORMAL
+                                                 ? color : colorScale8(color, layer.weight);
+                }
+            }
+        }
+        return playing;
+    }
+
+    // Pixel i of the layer stack for the prepared frame
+    void compose(uint8_t i, uint8_t &r, uint8_t &g, uint8_t &b) const {
+        r = g = b = 0;
+        for (uint8_t k = 0; k < LAYERS; k++) {
+            const Layer &layer = layers[order[k]];
+            if (!layer.visible || !layer.timeline.isLit(i)) {
+                continue;
+            }
+            const uint8_t *paint = layer.paint[i & 1];
+            switch (layer.blend) {
+                case BLEND_ADD:
+                    r = colorQadd8(r, paint[0]);
+                    g = colorQadd8(g, paint[1]);
+                    b = colorQadd8(b, paint[2]);
+                    break;
+                case BLEND_LIGHTEN:
+                    if (paint[0] > r) r = paint[0];
+                    if (paint[1] > g) g = paint[1];
+                    if (paint[2] > b) b = paint[2];
+                    break;
+                case BLEND_NORMAL:
+                default:
+                    r = colorLerp8(r, paint[0], layer.weight);
+                    g = colorLerp8(g, paint[1], layer.weight);
+                    b = colorLerp8(b, paint[2], layer.weight);
+                    break;
+            }
+        }
+    }
+
+    // Crossfade position at `now`, 0 (saved frame) to 255 (layers);
+    // ends the crossfade once CROSSFADE_MS have passed
+    uint8_t fadeLevel(unsigned long now) {
+        if (!fading) {
+            return 255;
+        }
+        unsigned long elapsed = now - fadeStart;
+        if (elapsed >= CROSSFADE_MS) {
+            fading = false;
+            return 255;
+        }
+        return (elapsed * FADE_STEP) >> 16;
+    }
+
+    void blendFrom(uint8_t i, uint8_t t, uint8_t &r, uint8_t &g, uint8_t &b) const {
+        uint8_t fr, fg, fb;
+        from.get(i, fr, fg, fb);
+        r = colorLerp8(fr, r, t);
+        g = colorLerp8(fg, g, t);
+        b = colorLerp8(fb, b, t);
+    }
+
+    // Save the frame on the LEDs at `now` (mid-crossfade included) and
+    // fade from it. Nothing on the LEDs: the new frame starts directly.
+    void crossfade(unsigned long now) {
+        if (!isShowing()) {
+            return;
+        }
+        prepare(now);
+        uint8_t t = fadeLevel(now);
+        for (uint8_t i = 0; i < Backend::getNumLEDs(); i++) {
+            uint8_t r, g, b;
+            compose(i, r, g, b);
+            if (fading) {
+                blendFrom(i, t, r, g, b);
+            }
+            from.set(i, r, g, b);
+        }
+        fading = true;
+        fadeStart = now;
+    }
+};
+
+#endif // COMPOSITOR_H
@@ -12,7 +12,9 @@
 #endif
 
 // ===== LED Configuration =====
-#define NUM_LEDS 4             // Number of LEDs in your setup
+#ifndef NUM_LEDS
+    #define NUM_LEDS 4         // Number of LEDs in your setup
+#endif
 
 // FastLED configuration (WS2812B addressable LEDs)
 #ifdef LED_TYPE_FASTLED
@@ -35,8 +37,42 @@
     
     // LED color (for single-color LEDs)
     #define LED_COLOR_BLUE     // Options: LED_COLOR_BLUE, LED_COLOR_RED, LED_COLOR_GREEN
+    
+    // Drive the timer compare registers directly instead of analogWrite()
+    // #define F5_DIRECT_PWM
+    
+    // Bit-angle modulation from a Timer2 interrupt instead of hardware PWM
+    // (bam_facade.h): LEDs on any GPIO pins or on chained 74HC595s, so
+    // NUM_LEDS is not capped at the six PWM pins. Takes Timer2, so
+    // analogWrite() on pins 3 and 11 stops working.
+    // #define F5_BAM
+    #define BAM_PINS 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17  // 14-17 = A0-A3
+    #define BAM_SHIFT_REGISTERS 0  // 74HC595s on SPI (MOSI 11, SCK 13, latch 10); 0 = BAM_PINS
+    #define BAM_UNIT_TICKS 8       // Shortest bit in Timer2 /64 ticks: 32 us, 122 Hz refresh
 #endif
 
+// ===== Framebuffer =====
+// Pixel format the LED colors are kept in between setLED() and show()
+// (framebuffer.h); show() converts to what the LEDs take. Per LED:
+//   PIXEL_MONO8     1 byte, the monochrome level (grey on WS2812B)
+//   PIXEL_RGB565    2 bytes
+//   PIXEL_RGB888    3 bytes, sent to FastLED as is
+//   PIXEL_PALETTE4  half a byte, an index into PIXEL_PALETTE (PROGMEM)
+// Other than RGB888, WS2812B builds convert into a 3-byte-per-LED stack
+// buffer during show(), so only the persistent SRAM shrinks.
+#define PIXEL_MONO8 0
+#define PIXEL_RGB565 1
+#define PIXEL_RGB888 2
+#define PIXEL_PALETTE4 3
+#ifndef PIXEL_FORMAT
+    #ifdef LED_TYPE_F5
+        #define PIXEL_FORMAT PIXEL_MONO8
+    #else
+        #define PIXEL_FORMAT PIXEL_RGB888
+    #endif
+#endif
+#define PIXEL_PALETTE PALETTE_GLOVE    // Or PALETTE_GREY16
+
 // ===== Motion Detection Settings =====
 #define MOTION_THRESHOLD 1.2   // G-force threshold (1.2 = ~20-30° tilt)
 #define ACTIVATION_ANGLE 45    // Degrees from horizontal to activate
@@ -47,11 +83,141 @@
 #define BRIGHTNESS 200         // 0-255 (reduce for longer battery life)
 #define FADE_SPEED 10          // Speed of fade in/out
 #define ANIMATION_FPS 60       // Frames per second for animations
+#define BREATHE_PERIOD_MS 3141.59  // Breathing cycle (the original sin(t / 500))
+
+// Layers (compositor.h): an idle glow under the activation sequence,
+// with status overlays on top. A new effect crossfades from the frame
+// on the LEDs over CROSSFADE_MS instead of cutting.
+#define CROSSFADE_MS 150
+#ifndef IDLE_GLOW
+    #define IDLE_GLOW 0        // 1 = breathe dimly while idle (draws LED current all the time)
+#endif
+#define IDLE_GLOW_LOW 8
+#define IDLE_GLOW_HIGH 40
+#define IDLE_GLOW_PERIOD_MS 6000
+
+// ===== Task Scheduling =====
+// Sensor polling runs at SAMPLE_RATE and rendering at ANIMATION_FPS,
+// each on its own deadline; housekeeping (stats, serial) runs slower.
+#define HOUSEKEEPING_PERIOD_MS 1000
+
+// WS2812 refreshes keep interrupts off (~30 us per LED), so they are
+// placed to end at least this long before a sensor read or telemetry
+// drain is due (refresh_scheduler.h)
+#define REFRESH_GUARD_US 100
+
+// Event loop: interrupts release tasks instead of the scheduler timing
+// them. A Timer0 compare interrupt posts each animation frame
+// (frame_clock.h), and in MPU_FIFO_MODE the INT interrupt posts the
+// sensor task once a batch is queued.
+#ifndef EVENT_LOOP
+    #define EVENT_LOOP 0
+#endif
 
 // ===== Power Management =====
-#define LOW_POWER_MODE true    // Enable sleep between readings
+// Low-power mode: once nothing has moved for LOW_POWER_IDLE_MS while the
+// LEDs are off, the MPU6050 drops to accel-only wake-on-motion cycling
+// and the ATmega powers down until the MPU6050 pulls INT low. Needs INT
+// wired to MPU_INT_PIN, like FIFO mode. millis() stands still while
+// powered down.
+#ifndef LOW_POWER_MODE
+    #define LOW_POWER_MODE 0
+#endif
+#define LOW_POWER_IDLE_MS 10000
+#define LOW_POWER_WAKE_MG 64       // Movement from the resting pose that wakes (~3.7 deg tilt)
+#define LOW_POWER_WAKE_RATE 2      // MPU6050 wake-up checks: 0 = 1.25, 1 = 5, 2 = 20, 3 = 40 Hz
 #define SAMPLE_RATE 50         // Accelerometer sample rate (Hz)
 
+// ===== Sensor Sampling Mode =====
+// FIFO mode: the MPU6050 samples into its on-chip FIFO at SAMPLE_RATE and
+// pulses INT once per sample; samples are drained in bursts and each one
+// gets an exact timestamp. Requires the MPU6050 INT pin wired to MPU_INT_PIN.
+#ifndef MPU_FIFO_MODE
+    #define MPU_FIFO_MODE 0
+#endif
+#define MPU_INT_PIN 2          // External interrupt pin (2 or 3)
+#define FIFO_BATCH_SIZE 4      // Samples queued before each drain
+
+// ===== I2C Bus =====
+// The MPU6050 runs fast mode; Wire would otherwise stay at 100 kHz
+#define I2C_CLOCK_HZ 400000
+
+// Interrupt-driven TWI (async_twi.h) in place of the blocking Wire
+// library. The sensor task only starts each read; the loop renders
+// while the bytes move, and the TWI interrupt posts a task that
+// processes the sample. A transfer still running after TWI_TIMEOUT_US
+// is aborted and the bus recovered. FIFO mode drains over it too, but
+// blocking.
+#ifndef ASYNC_TWI
+    #define ASYNC_TWI 0
+#endif
+#define TWI_TIMEOUT_US 5000    // Well past a WS2812 refresh, which stalls the TWI interrupt
+
+// ===== Adaptive Sampling =====
+// The sample rate follows the hand: while a running variance of the
+// accelerometer stays low, the MPU6050 samples at ADAPTIVE_STILL_RATE
+// behind a narrow DLPF; as soon as it rises, ADAPTIVE_MOTION_RATE with a
+// wide one. The sensor task period follows (adaptive_sampler.h). Reads
+// one sample per task run, so not with MPU_FIFO_MODE; gesture templates
+// assume SAMPLE_RATE, so not with GESTURE_RECOGNITION.
+#ifndef ADAPTIVE_SAMPLING
+    #define ADAPTIVE_SAMPLING 0
+#endif
+#define ADAPTIVE_STILL_RATE 25     // Hz, DLPF 10 Hz
+#define ADAPTIVE_MOTION_RATE 200   // Hz, DLPF 94 Hz
+#define ADAPTIVE_MOVE_MG 40        // Accel std deviation that switches to the motion rate
+#define ADAPTIVE_STILL_MG 15       // Std deviation below which the hand counts as still
+#define ADAPTIVE_HOLD_MS 500       // Still this long before dropping to the still rate
+#define ADAPTIVE_VARIANCE_SHIFT 3  // Running mean / variance weight: 1/8 per sample
+
+// ===== Gesture Recognition =====
+// Matches recent accel + gyro history against the templates in
+// gesture_recognizer.cpp. Needs gyro samples, which FIFO mode does not
+// queue, so it only runs with MPU_FIFO_MODE off.
+#ifndef GESTURE_RECOGNITION
+    #define GESTURE_RECOGNITION 0
+#endif
+#define GESTURE_DECIMATION 2   // Raw samples averaged per frame (1, 2 or 4)
+
+// ===== Orientation Fusion =====
+// Gyro + accel complementary filter (orientation_filter.h) drives the
+// tilt trigger instead of raw accelerometer tilt, so the DLPF can run at
+// 44 Hz instead of 21 Hz. Needs gyro samples, so not with MPU_FIFO_MODE.
+#ifndef ORIENTATION_FUSION
+    #define ORIENTATION_FUSION 0
+#endif
+#define FUSION_ACCEL_SHIFT 5   // Accel pull per sample: 1/32 (~0.64 s at 50 Hz)
+
+// ===== IMU Trace Capture =====
+// Streams every raw accel + gyro sample over Serial in the format of
+// imu_trace.h, for replay on the host (native/replay). The stream is
+// binary, so DEBUG output must be off.
+#ifndef TRACE_CAPTURE
+    #define TRACE_CAPTURE 0
+#endif
+#define TRACE_CAPTURE_BAUD 115200
+
+// ===== Telemetry =====
+// Binary records from the sensor path (telemetry.h), queued in RAM and
+// drained into the Serial TX buffer without ever blocking, so the loop
+// keeps release timing. Decode on the host with native/telemetry.
+#ifndef TELEMETRY
+    #define TELEMETRY 0
+#endif
+#define TELEMETRY_BAUD 115200
+#define TELEMETRY_BUFFER_SIZE 128      // Ring bytes, power of two (~6 samples)
+#define TELEMETRY_DRAIN_PERIOD_MS 5    // 64-byte TX buffer empties in 5.6 ms
+
+// ===== Section Profiler =====
+// Cycle counts for the sensor read, pitch, animation, show() and serial
+// sections (profiler.h). Send PROFILER_DUMP_COMMAND over Serial to print
+// the stats since the last dump. On AVR it takes Timer1, so it needs a
+// FastLED or F5_BAM build. Off, the instrumentation compiles away.
+#ifndef PROFILER
+    #define PROFILER 0
+#endif
+#define PROFILER_DUMP_COMMAND 'p'
+
 // ===== Debug Settings =====
 #if DEBUG
   #define DEBUG_PRINT(x) Serial.print(x)
@@ -86,4 +252,13 @@
     #define COLOR_SECONDARY COLOR_GOLD
 #endif
 
+// Status overlays; single-color LEDs can only blink in their own color
+#ifdef LED_TYPE_F5
+    #define COLOR_FAULT COLOR_PRIMARY
+    #define COLOR_LOW_BATTERY COLOR_PRIMARY
+#else
+    #define COLOR_FAULT COLOR_RED
+    #define COLOR_LOW_BATTERY COLOR_GOLD
+#endif
+
 #endif // CONFIG_H
\ No newline at end of file
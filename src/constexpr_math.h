@@ -0,0 +1,97 @@
+#ifndef CONSTEXPR_MATH_H
+#define CONSTEXPR_MATH_H
+
+// Compile-time math helpers for precomputing thresholds and tables.
+// Written as single-expression recursive functions so they stay valid
+// C++11 constexpr (the AVR toolchain default). Never call these at
+// run time - they exist only to fold into constants.
+
+namespace cmath_detail {
+
+constexpr double abs(double x) {
+    return x < 0 ? -x : x;
+}
+
+// Sum Taylor terms until they stop contributing
+constexpr double sinSeries(double x2, double term, int n) {
+    return abs(term) < 1e-15 ? term
+        : term + sinSeries(x2, -term * x2 / ((2.0 * n + 2.0) * (2.0 * n + 3.0)), n + 1);
+}
+
+constexpr double cosSeries(double x2, double term, int n) {
+    return abs(term) < 1e-15 ? term
+        : term + cosSeries(x2, -term * x2 / ((2.0 * n + 1.0) * (2.0 * n + 2.0)), n + 1);
+}
+
+// Reduce to [-pi, pi] so the series converges quickly
+constexpr double wrapPi(double x) {
+    return x > 3.14159265358979323846 ? wrapPi(x - 6.28318530717958647692)
+        : (x < -3.14159265358979323846 ? wrapPi(x + 6.28318530717958647692) : x);
+}
+
+constexpr double square(double x) {
+    return x * x;
+}
+
+// exp(x) = exp(x/2)^2 until |x| <= 1, then the Taylor series
+constexpr double expSeries(double x, double term, int n) {
+    return abs(term) < 1e-17 ? term : term + expSeries(x, term * x / (n + 1), n + 1);
+}
+
+constexpr double expReduced(double x) {
+    return abs(x) > 1.0 ? square(expReduced(x / 2.0)) : expSeries(x, 1.0, 0);
+}
+
+// ln(x) = 2 atanh((x - 1) / (x + 1)) after scaling x into [0.5, 2]
+constexpr double atanhSeries(double z2, double power, int n) {
+    return abs(power / (2 * n + 1)) < 1e-17 ? 0.0
+        : power / (2 * n + 1) + atanhSeries(z2, power * z2, n + 1);
+}
+
+constexpr double logReduced(double x) {
+    return x < 0.5 ? logReduced(x * 2.0) - 0.69314718055994530942
+        : (x > 2.0 ? logReduced(x / 2.0) + 0.69314718055994530942
+        : 2.0 * atanhSeries(square((x - 1.0) / (x + 1.0)), (x - 1.0) / (x + 1.0), 0));
+}
+
+} // namespace cmath_detail
+
+constexpr double CONSTEXPR_PI = 3.14159265358979323846;
+
+constexpr double constexprSin(double x) {
+    return cmath_detail::sinSeries(cmath_detail::wrapPi(x) * cmath_detail::wrapPi(x),
+                                   cmath_detail::wrapPi(x), 0);
+}
+
+constexpr double constexprCos(double x) {
+    return cmath_detail::cosSeries(cmath_detail::wrapPi(x) * cmath_detail::wrapPi(x), 1.0, 0);
+}
+
+constexpr double constexprTan(double x) {
+    return constexprSin(x) / constexprCos(x);
+}
+
+constexpr double constexprExp(double x) {
+    return cmath_detail::expReduced(x);
+}
+
+// Natural log; x must be > 0
+constexpr double constexprLog(double x) {
+    return cmath_detail::logReduced(x);
+}
+
+// base^exponent for base >= 0
+constexpr double constexprPow(double base, double exponent) {
+    return base <= 0.0 ? 0.0 : constexprExp(exponent * constexprLog(base));
+}
+
+constexpr double degreesToRadians(double deg) {
+    return deg * CONSTEXPR_PI / 180.0;
+}
+
+// Round a non-negative value to the nearest integer
+constexpr unsigned long constexprRound(double x) {
+    return (unsigned long)(x + 0.5);
+}
+
+#endif // CONSTEXPR_MATH_H
@@ -0,0 +1,89 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <Arduino.h>
+
+// ===== ISR-to-Main Event Queue =====
+// Single-producer / single-consumer ring buffer for handing events from
+// an interrupt to the main loop without a critical section. The producer
+// (push) only writes `head`, the consumer (pop) only writes `tail`, and
+// both are single bytes, which AVR loads and stores atomically. A
+// compiler barrier keeps the slot copy on the right side of each index
+// store, so the consumer never sees an index before its slot is written.
+//
+// AVR interrupts don't nest, so any number of ISRs together count as one
+// producer. Main-loop code must not push into a queue that an ISR also
+// pushes into.
+//
+// SIZE is a power of two up to 128. The indices run free and wrap at
+// 256, so all SIZE slots are usable. A push onto a full queue drops the
+// event and counts it; the consumer collects the count with
+// takeOverflows().
+
+template <typename T, uint8_t SIZE>
+class EventQueue {
+    static_assert(SIZE >= 2 && SIZE <= 128 && (SIZE & (SIZE - 1)) == 0,
+                  "EventQueue SIZE must be a power of two from 2 to 128");
+
+public:
+    EventQueue() : head(0), tail(0), overflows(0), overflowsSeen(0) {}
+
+    // Producer side. Returns false (and counts an overflow) if full.
+    bool push(const T &event) {
+        uint8_t h = head;
+        if ((uint8_t)(h - tail) == SIZE) {
+            overflows++;
+            return false;
+        }
+        slots[h & MASK] = event;
+        barrier();
+        head = h + 1;
+        return true;
+    }
+
+    // Consumer side. Returns false if empty.
+    bool pop(T &event) {
+        uint8_t t = tail;
+        if (t == head) {
+            return false;
+        }
+        barrier();
+        event = slots[t & MASK];
+        barrier();
+        tail = t + 1;
+        return true;
+    }
+
+    // Either side; a snapshot that the other side may change at once
+    uint8_t count() const { return (uint8_t)(head - tail); }
+    bool isEmpty() const { return head == tail; }
+
+    // Consumer side: a push was dropped since the last takeOverflows()
+    bool hasOverflowed() const { return overflows != overflowsSeen; }
+
+    // Consumer side: pushes dropped since the last call (modulo 256)
+    uint8_t takeOverflows() {
+        uint8_t seen = overflows;
+        uint8_t dropped = seen - overflowsSeen;
+        overflowsSeen = seen;
+        return dropped;
+    }
+
+    // Consumer side: drop everything queued so far
+    void clear() { tail = head; }
+
+    static uint8_t capacity() { return SIZE; }
+
+private:
+    static const uint8_t MASK = SIZE - 1;
+
+    static void barrier() { asm volatile("" ::: "memory"); }
+
+    T slots[SIZE];
+    volatile uint8_t head;          // Written by the producer only
+    volatile uint8_t tail;          // Written by the consumer only
+    volatile uint8_t overflows;     // Written by the producer only
+    uint8_t overflowsSeen;          // Consumer's copy of overflows
+};
+
+#endif // EVENT_QUEUE_H
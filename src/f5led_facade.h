@@ -1,11 +1,13 @@
 #ifndef F5LED_FACADE_H
 #define F5LED_FACADE_H
 
-#include "led_facade.h"
+#include "led_backend.h"
+#include "color_math.h"
+#include "framebuffer.h"
 #include "config.h"
 
 // F5 LED implementation for regular 5mm LEDs with individual pins
-class F5LEDFacade : public ILEDFacade {
+class F5LEDFacade : public LEDBackend<F5LEDFacade, NUM_LEDS> {
 private:
     // Pin assignments for each LED (must be PWM-capable)
     const uint8_t ledPins[NUM_LEDS] = {
@@ -29,54 +31,37 @@ private:
         #endif
     };
     
-    // Store brightness for each LED (0-255)
-    uint8_t ledBrightness[NUM_LEDS];
+    // Colors as set, in the configured pixel format
+    FrameBuffer<ConfiguredPixelFormat, NUM_LEDS> frame;
     uint8_t globalBrightness;
     
-    // Store desired RGB values (for single-color LEDs, we use brightness only)
-    uint8_t ledR[NUM_LEDS];
-    uint8_t ledG[NUM_LEDS];
-    uint8_t ledB[NUM_LEDS];
+    // Last duty cycle written to each pin, and whether any input changed
+    // since the last show()
+    uint8_t pinOutput[NUM_LEDS];
+    bool dirty;
     
-    // Calculate effective brightness from RGB (for monochrome LEDs)
-    uint8_t calculateBrightness(uint8_t r, uint8_t g, uint8_t b) {
-        // For blue LEDs, use the blue channel
-        // For other colors, use the max of RGB as brightness
-        #ifdef LED_COLOR_BLUE
-            return b;
-        #elif defined(LED_COLOR_RED)
-            return r;
-        #elif defined(LED_COLOR_GREEN)
-            return g;
-        #else
-            // Default: use max brightness from any channel
-            uint8_t max = r;
-            if (g > max) max = g;
-            if (b > max) max = b;
-            return max;
-        #endif
-    }
+    uint32_t committedFrames;
+    uint32_t skippedFrames;
     
     // Apply global brightness scaling
     uint8_t scaleByGlobalBrightness(uint8_t value) {
-        return (uint16_t)value * globalBrightness / 255;
+        return colorScale8(value, globalBrightness);
     }
     
 public:
-    F5LEDFacade() : globalBrightness(BRIGHTNESS) {
+    F5LEDFacade()
+        : globalBrightness(BRIGHTNESS), dirty(false), committedFrames(0), skippedFrames(0) {
         for (uint8_t i = 0; i < NUM_LEDS; i++) {
-            ledBrightness[i] = 0;
-            ledR[i] = 0;
-            ledG[i] = 0;
-            ledB[i] = 0;
+            pinOutput[i] = 0;
         }
     }
     
-    void begin() override {
+    void begin() {
         // Initialize all LED pins as outputs
         for (uint8_t i = 0; i < NUM_LEDS; i++) {
             pinMode(ledPins[i], OUTPUT);
             digitalWrite(ledPins[i], LOW);
+            pinOutput[i] = 0;
         }
         
         DEBUG_PRINT("F5 LED initialized on pins: ");
@@ -87,45 +72,52 @@ public:
         DEBUG_PRINTLN("");
     }
     
-    void setLED(uint8_t index, uint8_t r, uint8_t g, uint8_t b) override {
+    void setLED(uint8_t index, uint8_t r, uint8_t g, uint8_t b) {
         if (index >= NUM_LEDS) return;
         
-        ledR[index] = r;
-        ledG[index] = g;
-        ledB[index] = b;
-        ledBrightness[index] = calculateBrightness(r, g, b);
-    }
-    
-    void setAll(uint8_t r, uint8_t g, uint8_t b) override {
-        for (uint8_t i = 0; i < NUM_LEDS; i++) {
-            setLED(i, r, g, b);
+        if (frame.set(index, r, g, b)) {
+            dirty = true;
         }
     }
     
-    void clear() override {
+    void show() {
+        if (!dirty) {
+            skippedFrames++;
+            return;
+        }
+        dirty = false;
+        
+        // Only touch pins whose duty cycle actually changed
+        bool written = false;
         for (uint8_t i = 0; i < NUM_LEDS; i++) {
-            ledBrightness[i] = 0;
-            ledR[i] = 0;
-            ledG[i] = 0;
-            ledB[i] = 0;
-            digitalWrite(ledPins[i], LOW);
+            uint8_t scaledBrightness = scaleByGlobalBrightness(frame.getMono(i));
+            if (scaledBrightness != pinOutput[i]) {
+                analogWrite(ledPins[i], scaledBrightness);
+                pinOutput[i] = scaledBrightness;
+                written = true;
+            }
+        }
+        
+        if (written) {
+            committedFrames++;
+        } else {
+            skippedFrames++;
         }
     }
     
-    void show() override {
-        // Update all LEDs with current brightness values
-        for (uint8_t i = 0; i < NUM_LEDS; i++) {
-            uint8_t scaledBrightness = scaleByGlobalBrightness(ledBrightness[i]);
-            analogWrite(ledPins[i], scaledBrightness);
+    void setBrightness(uint8_t brightness) {
+        if (brightness != globalBrightness) {
+            globalBrightness = brightness;
+            dirty = true;
         }
     }
     
-    void setBrightness(uint8_t brightness) override {
-        globalBrightness = brightness;
+    uint32_t getCommittedFrames() {
+        return committedFrames;
     }
     
-    uint8_t getNumLEDs() override {
-        return NUM_LEDS;
+    uint32_t getSkippedFrames() {
+        return skippedFrames;
     }
 };
 
@@ -1,56 +1,138 @@
 #ifndef FASTLED_FACADE_H
 #define FASTLED_FACADE_H
 
-#include "led_facade.h"
+#include "led_backend.h"
+#include "framebuffer.h"
+#include "refresh_scheduler.h"
 #include <FastLED.h>
 #include "config.h"
 
-// FastLED implementation for WS2812B addressable LEDs
-class FastLEDFacade : public ILEDFacade {
+// FastLED implementation for WS2812B addressable LEDs.
+// Every write goes through the setters, so they track whether the strip
+// content changed; show() skips the refresh (and its interrupts-off
+// window) when it did not. Frames are only resent on change, so
+// FastLED's temporal dithering does not run between changes.
+//
+// Pixels live in a FrameBuffer of the given format. RGB888 is handed to
+// FastLED as is; other formats are widened into a CRGB array on the
+// stack for the length of each refresh. Only this strip may call
+// FastLED.show(), since the controller points at that array.
+//
+// With a RefreshScheduler attached, show() only refreshes in a slot that
+// ends before the next protected task release; otherwise the frame stays
+// dirty until showDeferred() or the next show().
+template <uint8_t N, uint8_t DATA_PIN, typename Format = ConfiguredPixelFormat>
+class FastLEDStrip : public LEDBackend<FastLEDStrip<N, DATA_PIN, Format>, N> {
+public:
+    // Interrupts-off time of one refresh: 24 bits at 800 kHz per LED,
+    // plus the 50 us latch
+    static const unsigned long REFRESH_MICROS = N * 30UL + 50;
+    
 private:
-    CRGB leds[NUM_LEDS];
+    FrameBuffer<Format, N> frame;
+    CLEDController *controller;
     uint8_t currentBrightness;
+    bool dirty;
+    RefreshScheduler *refresh;
+    
+    uint32_t committedFrames;
+    uint32_t skippedFrames;
+    
+    void commit(bool force) {
+        if (refresh && !force && !refresh->admit(REFRESH_MICROS)) {
+            return;
+        }
+        dirty = false;
+        committedFrames++;
+        send();
+        if (refresh) {
+            refresh->committed();
+        }
+    }
+    
+    void send() {
+        if (Format::CRGB_LAYOUT) {
+            FastLED.show();
+            return;
+        }
+        CRGB out[N];
+        for (uint8_t i = 0; i < N; i++) {
+            frame.get(i, out[i].r, out[i].g, out[i].b);
+        }
+        controller->setLeds(out, N);
+        FastLED.show();
+    }
     
 public:
-    FastLEDFacade() : currentBrightness(BRIGHTNESS) {}
+    FastLEDStrip()
+        : controller(nullptr), currentBrightness(BRIGHTNESS), dirty(false), refresh(nullptr),
+          committedFrames(0), skippedFrames(0) {}
     
-    void begin() override {
-        FastLED.addLeds<WS2812B, LED_PIN, GRB>(leds, NUM_LEDS);
+    void begin() {
+        CRGB *pixels = Format::CRGB_LAYOUT ? reinterpret_cast<CRGB *>(frame.raw()) : nullptr;
+        controller = &FastLED.addLeds<WS2812B, DATA_PIN, GRB>(pixels, N);
         FastLED.setBrightness(BRIGHTNESS);
-        FastLED.clear();
-        FastLED.show();
+        frame.clear();
+        send();
         
         DEBUG_PRINTLN("FastLED initialized (WS2812B)");
     }
     
-    void setLED(uint8_t index, uint8_t r, uint8_t g, uint8_t b) override {
-        if (index < NUM_LEDS) {
-            leds[index] = CRGB(r, g, b);
+    void setLED(uint8_t index, uint8_t r, uint8_t g, uint8_t b) {
+        if (index < N && frame.set(index, r, g, b)) {
+            dirty = true;
         }
     }
     
-    void setAll(uint8_t r, uint8_t g, uint8_t b) override {
-        for (uint8_t i = 0; i < NUM_LEDS; i++) {
-            leds[i] = CRGB(r, g, b);
+    void show() {
+        if (!dirty) {
+            skippedFrames++;
+            return;
+        }
+        if (refresh && refresh->isPending()) {
+            refresh->missed();
         }
+        commit(false);
     }
     
-    void clear() override {
-        FastLED.clear();
+    void setRefreshScheduler(RefreshScheduler *scheduler) {
+        refresh = scheduler;
     }
     
-    void show() override {
-        FastLED.show();
+    void showDeferred() {
+        if (dirty && refresh && refresh->isPending()) {
+            commit(false);
+        }
     }
     
-    void setBrightness(uint8_t brightness) override {
-        currentBrightness = brightness;
-        FastLED.setBrightness(brightness);
+    void showNow() {
+        if (!dirty) {
+            skippedFrames++;
+            return;
+        }
+        commit(true);
     }
     
-    uint8_t getNumLEDs() override {
-        return NUM_LEDS;
+    void setBrightness(uint8_t brightness) {
+        if (brightness != currentBrightness) {
+            currentBrightness = brightness;
+            FastLED.setBrightness(brightness);
+            dirty = true;
+        }
+    }
+    
+    uint32_t getCommittedFrames() {
+        return committedFrames;
+    }
+    
+    uint32_t getSkippedFrames() {
+        return skippedFrames;
     }
 };
 
-#endif // FASTLED_FACADE_H
\ No newline at end of file
+#ifdef LED_TYPE_FASTLED
+// The configured strip
+typedef FastLEDStrip<NUM_LEDS, LED_PIN> FastLEDFacade;
+#endif
+
+#endif // FASTLED_FACADE_H
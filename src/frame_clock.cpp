@@ -0,0 +1,64 @@
+#include "frame_clock.h"
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#if EVENT_LOOP
+FrameClock frameClock;
+
+ISR(TIMER0_COMPA_vect) {
+    frameClock.tick();
+}
+#endif
+
+FrameClock::FrameClock()
+    : scheduler(nullptr), task(0), period(0), nextFrame(0), frames(0), skipped(0) {
+}
+
+void FrameClock::begin(TaskScheduler &target, uint8_t id, unsigned long periodUs) {
+    noInterrupts();
+    scheduler = &target;
+    task = id;
+    period = periodUs;
+    nextFrame = micros() + periodUs;
+    frames = 0;
+    skipped = 0;
+    interrupts();
+    TIMSK0 |= _BV(OCIE0A);
+}
+
+void FrameClock::end() {
+    TIMSK0 &= ~_BV(OCIE0A);
+}
+
+unsigned long FrameClock::getFrames() const {
+    noInterrupts();
+    unsigned long count = frames;
+    interrupts();
+    return count;
+}
+
+unsigned long FrameClock::getSkipped() const {
+    noInterrupts();
+    unsigned long count = skipped;
+    interrupts();
+    return count;
+}
+
+void FrameClock::tick() {
+    unsigned long now = micros();
+    if ((long)(now - nextFrame) < 0) {
+        return;
+    }
+    nextFrame += period;
+    if (scheduler->post(task)) {
+        frames++;
+    } else {
+        skipped++;
+    }
+    // Grid points that went by while interrupts were off (a long
+    // refresh, power-down) are skipped, not posted back to back
+    while ((long)(now - nextFrame) >= 0) {
+        nextFrame += period;
+        skipped++;
+    }
+}
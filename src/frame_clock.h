@@ -0,0 +1,47 @@
+#ifndef FRAME_CLOCK_H
+#define FRAME_CLOCK_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "task_scheduler.h"
+
+// ===== Frame Clock =====
+// Releases a task on a fixed frame grid from the Timer0 compare-A
+// interrupt, through TaskScheduler::post(). Timer0 already runs for
+// millis() (one cycle per 1024 us at 16 MHz), so this costs no timer:
+// OCR0A only sets where in the cycle the interrupt lands, so PWM on
+// pin 6 keeps working. The grid is in micros(); each frame is posted
+// from the first interrupt at or after its grid point, so up to one
+// Timer0 cycle late. Grid points that pass while interrupts are off are
+// skipped and counted, not posted back to back (and TaskScheduler runs a
+// task posted twice before it got to run only once).
+class FrameClock {
+public:
+    FrameClock();
+
+    // Post `task` every `periodUs`, the first frame one period from now
+    void begin(TaskScheduler &scheduler, uint8_t task, unsigned long periodUs);
+    void end();
+
+    // Frames posted, and frames skipped (loop behind or post queue full)
+    unsigned long getFrames() const;
+    unsigned long getSkipped() const;
+
+    // Interrupt body
+    void tick();
+
+private:
+    TaskScheduler *scheduler;
+    uint8_t task;
+    unsigned long period;
+    unsigned long nextFrame;
+    volatile unsigned long frames;
+    volatile unsigned long skipped;
+};
+
+#if EVENT_LOOP
+// Owns TIMER0_COMPA_vect
+extern FrameClock frameClock;
+#endif
+
+#endif // FRAME_CLOCK_H
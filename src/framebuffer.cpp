@@ -0,0 +1,27 @@
+#include "framebuffer.h"
+
+const Palette16 PALETTE_GLOVE PROGMEM = {
+    {   0,   0,   0 },
+    { 255,   0,   0 },  // COLOR_RED
+    { 255, 180,   0 },  // COLOR_GOLD
+    {   0,   0, 255 },  // COLOR_BLUE
+    { 255, 255, 255 },
+    { 128,   0,   0 },
+    {  64,   0,   0 },
+    {  32,   0,   0 },
+    { 128,  90,   0 },
+    {  64,  45,   0 },
+    { 255,  90,   0 },
+    {   0,   0, 128 },
+    {   0,   0,  64 },
+    {   0, 128, 255 },
+    {   0, 255,   0 },
+    {  64,  64,  64 },
+};
+
+const Palette16 PALETTE_GREY16 PROGMEM = {
+    {   0,   0,   0 }, {  17,  17,  17 }, {  34,  34,  34 }, {  51,  51,  51 },
+    {  68,  68,  68 }, {  85,  85,  85 }, { 102, 102, 102 }, { 119, 119, 119 },
+    { 136, 136, 136 }, { 153, 153, 153 }, { 170, 170, 170 }, { 187, 187, 187 },
+    { 204, 204, 204 }, { 221, 221, 221 }, { 238, 238, 238 }, { 255, 255, 255 },
+};
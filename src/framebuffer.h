@@ -0,0 +1,254 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include "config.h"
+
+// ===== Framebuffer =====
+// Every LED backend keeps the colors set between show() calls in a
+// FrameBuffer of the configured pixel format (PIXEL_FORMAT in config.h)
+// and converts to what its LEDs take at show() time. The smaller the
+// format, the more SRAM is left for LEDs and sensor history.
+//
+// A pixel format provides:
+//   static constexpr uint16_t bytes(uint16_t n)   Storage for n pixels
+//   bool store(data, i, r, g, b)   Set pixel i; true if it changed
+//   void load(data, i, r, g, b)    Pixel i as RGB
+//   uint8_t loadMono(data, i)      Pixel i as one level
+// and CRGB_LAYOUT, true when the bytes are laid out like FastLED's CRGB.
+// All-zero storage is black in every format.
+
+// Level of a monochrome LED showing an RGB color: the channel of the
+// configured F5 LED color, or the brightest channel
+inline uint8_t pixelMono(uint8_t r, uint8_t g, uint8_t b) {
+    #ifdef LED_COLOR_BLUE
+        (void)r; (void)g;
+        return b;
+    #elif defined(LED_COLOR_RED)
+        (void)g; (void)b;
+        return r;
+    #elif defined(LED_COLOR_GREEN)
+        (void)r; (void)b;
+        return g;
+    #else
+        uint8_t max = r;
+        if (g > max) max = g;
+        if (b > max) max = b;
+        return max;
+    #endif
+}
+
+// 1 byte per pixel: the monochrome level only (grey on an RGB strip)
+struct PixelMono8 {
+    static const bool CRGB_LAYOUT = false;
+
+    static constexpr uint16_t bytes(uint16_t n) { return n; }
+
+    bool store(uint8_t *data, uint8_t i, uint8_t r, uint8_t g, uint8_t b) {
+        uint8_t level = pixelMono(r, g, b);
+        if (data[i] == level) return false;
+        data[i] = level;
+        return true;
+    }
+
+    void load(const uint8_t *data, uint8_t i, uint8_t &r, uint8_t &g, uint8_t &b) const {
+        r = g = b = data[i];
+    }
+
+    uint8_t loadMono(const uint8_t *data, uint8_t i) const { return data[i]; }
+};
+
+// 2 bytes per pixel, 5-6-5 bits; channels widen by bit replication, so
+// 0 and 255 survive the round trip
+struct PixelRGB565 {
+    static const bool CRGB_LAYOUT = false;
+
+    static constexpr uint16_t bytes(uint16_t n) { return n * 2; }
+
+    bool store(uint8_t *data, uint8_t i, uint8_t r, uint8_t g, uint8_t b) {
+        uint16_t packed = ((uint16_t)(r & 0xF8) << 8) | ((uint16_t)(g & 0xFC) << 3) | (b >> 3);
+        uint8_t *pixel = data + i * 2;
+        if (pixel[0] == (uint8_t)packed && pixel[1] == (uint8_t)(packed >> 8)) return false;
+        pixel[0] = (uint8_t)packed;
+        pixel[1] = (uint8_t)(packed >> 8);
+        return true;
+    }
+
+    void load(const uint8_t *data, uint8_t i, uint8_t &r, uint8_t &g, uint8_t &b) const {
+        const uint8_t *pixel = data + i * 2;
+        uint16_t packed = pixel[0] | ((uint16_t)pixel[1] << 8);
+        uint8_t r5 = packed >> 11;
+        uint8_t g6 = (packed >> 5) & 0x3F;
+        uint8_t b5 = packed & 0x1F;
+        r = (r5 << 3) | (r5 >> 2);
+        g = (g6 << 2) | (g6 >> 4);
+        b = (b5 << 3) | (b5 >> 2);
+    }
+
+    uint8_t loadMono(const uint8_t *data, uint8_t i) const {
+        uint8_t r, g, b;
+        load(data, i, r, g, b);
+        return pixelMono(r, g, b);
+    }
+};
+
+// 3 bytes per pixel, R, G, B: FastLED's CRGB layout
+struct PixelRGB888 {
+    static const bool CRGB_LAYOUT = true;
+
+    static constexpr uint16_t bytes(uint16_t n) { return n * 3; }
+
+    bool store(uint8_t *data, uint8_t i, uint8_t r, uint8_t g, uint8_t b) {
+        uint8_t *pixel = data + i * 3;
+        if (pixel[0] == r && pixel[1] == g && pixel[2] == b) return false;
+        pixel[0] = r;
+        pixel[1] = g;
+        pixel[2] = b;
+        return true;
+    }
+
+    void load(const uint8_t *data, uint8_t i, uint8_t &r, uint8_t &g, uint8_t &b) const {
+        const uint8_t *pixel = data + i * 3;
+        r = pixel[0];
+        g = pixel[1];
+        b = pixel[2];
+    }
+
+    uint8_t loadMono(const uint8_t *data, uint8_t i) const {
+        const uint8_t *pixel = data + i * 3;
+        return pixelMono(pixel[0], pixel[1], pixel[2]);
+    }
+};
+
+// 16-color palettes in flash, 3 bytes (R, G, B) per entry. Entry 0
+// must be black.
+typedef uint8_t Palette16[16][3];
+
+extern const Palette16 PALETTE_GLOVE PROGMEM;   // The animation colors, with dimmer steps
+extern const Palette16 PALETTE_GREY16 PROGMEM;  // 16 even levels, for monochrome LEDs
+
+// Half a byte per pixel, two pixels per byte (even pixel in the low
+// nibble): an index into a PROGMEM palette. store() picks the nearest
+// entry (sum of channel differences) and remembers the last match, so
+// runs of one color search the palette once.
+struct PixelPalette4 {
+    static const bool CRGB_LAYOUT = false;
+
+    static constexpr uint16_t bytes(uint16_t n) { return (n + 1) / 2; }
+
+    PixelPalette4() : palette(&PIXEL_PALETTE), lastIndex(0) {
+        lastColor[0] = lastColor[1] = lastColor[2] = 0;
+    }
+
+    // Switch palettes; pixels keep their indices
+    void setPalette(const Palette16 &progmemPalette) {
+        palette = &progmemPalette;
+        lastIndex = 0;
+        lastColor[0] = lastColor[1] = lastColor[2] = 0;
+    }
+
+    uint8_t nearest(uint8_t r, uint8_t g, uint8_t b) {
+        if (r == lastColor[0] && g == lastColor[1] && b == lastColor[2]) {
+            return lastIndex;
+        }
+        uint8_t best = 0;
+        uint16_t bestDistance = 0xFFFF;
+        for (uint8_t e = 0; e < 16 && bestDistance; e++) {
+            const uint8_t *entry = (*palette)[e];
+            uint8_t er = pgm_read_byte(entry);
+            uint8_t eg = pgm_read_byte(entry + 1);
+            uint8_t eb = pgm_read_byte(entry + 2);
+            uint16_t distance = (r > er ? r - er : er - r) + (g > eg ? g - eg : eg - g) +
+                                (b > eb ? b - eb : eb - b);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = e;
+            }
+        }
+        lastColor[0] = r;
+        lastColor[1] = g;
+        lastColor[2] = b;
+        lastIndex = best;
+        return best;
+    }
+
+    bool store(uint8_t *data, uint8_t i, uint8_t r, uint8_t g, uint8_t b) {
+        uint8_t index = nearest(r, g, b);
+        uint8_t &pair = data[i >> 1];
+        uint8_t updated = (i & 1) ? (uint8_t)((pair & 0x0F) | (index << 4))
+                                  : (uint8_t)((pair & 0xF0) | index);
+        if (pair == updated) return false;
+        pair = updated;
+        return true;
+    }
+
+    uint8_t indexAt(const uint8_t *data, uint8_t i) const {
+        uint8_t pair = data[i >> 1];
+        return (i & 1) ? pair >> 4 : pair & 0x0F;
+    }
+
+    void load(const uint8_t *data, uint8_t i, uint8_t &r, uint8_t &g, uint8_t &b) const {
+        const uint8_t *entry = (*palette)[indexAt(data, i)];
+        r = pgm_read_byte(entry);
+        g = pgm_read_byte(entry + 1);
+        b = pgm_read_byte(entry + 2);
+    }
+
+    uint8_t loadMono(const uint8_t *data, uint8_t i) const {
+        uint8_t r, g, b;
+        load(data, i, r, g, b);
+        return pixelMono(r, g, b);
+    }
+
+private:
+    const Palette16 *palette;
+    uint8_t lastColor[3];
+    uint8_t lastIndex;
+};
+
+// N pixels in Format. The format's own state (the palette pointer) sits
+// in an empty base for the stateless formats, so it costs nothing there.
+template <typename Format, uint8_t N>
+class FrameBuffer : private Format {
+public:
+    static const uint16_t BYTES = Format::bytes(N);
+
+    FrameBuffer() { clear(); }
+
+    // True if pixel i changed
+    bool set(uint8_t i, uint8_t r, uint8_t g, uint8_t b) {
+        return Format::store(data, i, r, g, b);
+    }
+
+    void get(uint8_t i, uint8_t &r, uint8_t &g, uint8_t &b) const {
+        Format::load(data, i, r, g, b);
+    }
+
+    uint8_t getMono(uint8_t i) const {
+        return Format::loadMono(data, i);
+    }
+
+    void clear() { memset(data, 0, sizeof(data)); }
+
+    Format &format() { return *this; }
+
+    uint8_t *raw() { return data; }
+
+private:
+    uint8_t data[BYTES];
+};
+
+#if PIXEL_FORMAT == PIXEL_MONO8
+typedef PixelMono8 ConfiguredPixelFormat;
+#elif PIXEL_FORMAT == PIXEL_RGB565
+typedef PixelRGB565 ConfiguredPixelFormat;
+#elif PIXEL_FORMAT == PIXEL_RGB888
+typedef PixelRGB888 ConfiguredPixelFormat;
+#elif PIXEL_FORMAT == PIXEL_PALETTE4
+typedef PixelPalette4 ConfiguredPixelFormat;
+#else
+    #error "Unknown PIXEL_FORMAT"
+#endif
+
+#endif // FRAMEBUFFER_H
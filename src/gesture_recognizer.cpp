@@ -0,0 +1,283 @@
+#include "gesture_recognizer.h"
+#include "constexpr_math.h"
+#include <avr/pgmspace.h>
+
+static_assert(GESTURE_DECIMATION == 1 || GESTURE_DECIMATION == 2 || GESTURE_DECIMATION == 4,
+              "GESTURE_DECIMATION must be 1, 2 or 4");
+
+// Samples are pre-shifted by 4 so GESTURE_DECIMATION of them fit the
+// int16 accumulator; the rest of the shift to 1/256 counts happens per frame
+static const uint8_t SAMPLE_SHIFT = 4;
+static const uint8_t FRAME_SHIFT = 4 + (GESTURE_DECIMATION == 4 ? 2 : GESTURE_DECIMATION - 1);
+
+static const uint16_t COST_ABANDONED = 0xFFFF;
+
+// ===== Templates =====
+// Generated at compile time from motion models of each gesture, sampled
+// and quantized exactly like live frames (ranges: +/-2 g, +/-250 deg/s).
+// u runs 0 -> 1 across the template; positive gx rolls toward palm up,
+// positive gy raises the fingers.
+
+static constexpr double GESTURE_SECONDS = (double)GESTURE_LENGTH * GESTURE_DECIMATION / SAMPLE_RATE;
+
+static constexpr double frameProgress(int k) {
+    return (k + 0.5) / GESTURE_LENGTH;
+}
+
+// Smooth 0 -> 1 over the gesture and its rate per second
+static constexpr double easeIn(double u) {
+    return 0.5 - 0.5 * constexprCos(CONSTEXPR_PI * u);
+}
+
+static constexpr double easeRate(double u) {
+    return 0.5 * CONSTEXPR_PI * constexprSin(CONSTEXPR_PI * u) / GESTURE_SECONDS;
+}
+
+static constexpr double clampRange(double v, double limit) {
+    return v > limit ? limit : (v < -limit ? -limit : v);
+}
+
+static constexpr int8_t quantize(double counts) {
+    return counts >= 127.0 ? 127 : (counts <= -128.0 ? -128
+         : (int8_t)(counts < 0 ? -(int)constexprRound(-counts) : (int)constexprRound(counts)));
+}
+
+// Channel c (ax, ay, az in g, then gx, gy, gz in deg/s) -> frame value
+static constexpr int8_t feature(double value, int c) {
+    return c < 3 ? quantize(clampRange(value, 2.0) * 16384.0 / 256.0)
+                 : quantize(clampRange(value, 250.0) * 131.0 / 256.0);
+}
+
+// Palm down to palm up: roll 180 degrees about X
+static constexpr double palmUp(double u, int c) {
+    return c == 1 ? constexprSin(CONSTEXPR_PI * easeIn(u))
+         : c == 2 ? constexprCos(CONSTEXPR_PI * easeIn(u))
+         : c == 3 ? 180.0 * easeRate(u)
+         : 0.0;
+}
+
+// Fingers up, palm forward (-1 g on X); push out along Z and stop
+static constexpr double repulsorThrust(double u, int c) {
+    return c == 0 ? -1.0
+         : c == 2 ? 1.5 * constexprSin(2.0 * CONSTEXPR_PI * u)
+         : 0.0;
+}
+
+// From level, pitch up 40 degrees and back
+static constexpr double flickPitch(double u) {
+    return degreesToRadians(20.0 - 20.0 * constexprCos(2.0 * CONSTEXPR_PI * u));
+}
+
+static constexpr double wristFlick(double u, int c) {
+    return c == 0 ? -constexprSin(flickPitch(u))
+         : c == 2 ? constexprCos(flickPitch(u))
+         : c == 4 ? 40.0 * CONSTEXPR_PI * constexprSin(2.0 * CONSTEXPR_PI * u) / GESTURE_SECONDS
+         : 0.0;
+}
+
+static constexpr int8_t templateEntry(int gesture, int k, int c) {
+    return feature(gesture == GESTURE_PALM_UP ? palmUp(frameProgress(k), c)
+                 : gesture == GESTURE_REPULSOR_THRUST ? repulsorThrust(frameProgress(k), c)
+                 : wristFlick(frameProgress(k), c), c);
+}
+
+static_assert(templateEntry(GESTURE_PALM_UP, 0, 2) > 60 && templateEntry(GESTURE_PALM_UP, 15, 2) < -60,
+              "palm-up template must fold at compile time");
+
+#define GESTURE_FRAME(g, k) \
+    { templateEntry(g, k, 0), templateEntry(g, k, 1), templateEntry(g, k, 2), \
+      templateEntry(g, k, 3), templateEntry(g, k, 4), templateEntry(g, k, 5) }
+#define GESTURE_FRAMES_4(g, k) \
+    GESTURE_FRAME(g, k), GESTURE_FRAME(g, k + 1), GESTURE_FRAME(g, k + 2), GESTURE_FRAME(g, k + 3)
+#define GESTURE_TEMPLATE(g) \
+    { GESTURE_FRAMES_4(g, 0), GESTURE_FRAMES_4(g, 4), GESTURE_FRAMES_4(g, 8), GESTURE_FRAMES_4(g, 12) }
+
+static_assert(GESTURE_LENGTH == 16, "GESTURE_TEMPLATE expands 16 frames");
+
+static const int8_t GESTURE_TEMPLATES[NUM_GESTURES - 1][GESTURE_LENGTH][GESTURE_CHANNELS] PROGMEM = {
+    GESTURE_TEMPLATE(GESTURE_PALM_UP),
+    GESTURE_TEMPLATE(GESTURE_REPULSOR_THRUST),
+    GESTURE_TEMPLATE(GESTURE_WRIST_FLICK),
+};
+
+// Highest DTW cost that still counts as a match (sum of per-frame L1
+// distances along the warp path), tuned with the native gesture bench
+static const uint16_t GESTURE_THRESHOLDS[NUM_GESTURES - 1] PROGMEM = {
+    1500,   // Palm up: matches <= ~420, idle poses 3100+
+    650,    // Repulsor thrust: matches <= ~460, palm held forward ~1000
+    800,    // Wrist flick: matches <= ~380, level still hand ~1450
+};
+
+// ===== Recognizer =====
+
+GestureRecognizer::GestureRecognizer() {
+    reset();
+}
+
+void GestureRecognizer::reset() {
+    for (uint8_t c = 0; c < GESTURE_CHANNELS; c++) {
+        accumulator[c] = 0;
+    }
+    head = 0;
+    frames = 0;
+    pending = 0;
+    candidate.gesture = GESTURE_NONE;
+    candidate.confidence = 0;
+    candidateScore = 0;
+}
+
+uint16_t GestureRecognizer::threshold(uint8_t gesture) {
+    if (gesture == GESTURE_NONE || gesture >= NUM_GESTURES) {
+        return 0;
+    }
+    return pgm_read_word(&GESTURE_THRESHOLDS[gesture - 1]);
+}
+
+const char *GestureRecognizer::name(uint8_t gesture) {
+    switch (gesture) {
+        case GESTURE_PALM_UP: return "palm up";
+        case GESTURE_REPULSOR_THRUST: return "repulsor thrust";
+        case GESTURE_WRIST_FLICK: return "wrist flick";
+        default: return "none";
+    }
+}
+
+void GestureRecognizer::pushFrame() {
+    uint8_t slot;
+    if (frames < GESTURE_LENGTH) {
+        slot = (head + frames) & (GESTURE_LENGTH - 1);
+        frames++;
+    } else {
+        // Full: overwrite the oldest frame
+        slot = head;
+        head = (head + 1) & (GESTURE_LENGTH - 1);
+    }
+
+    for (uint8_t c = 0; c < GESTURE_CHANNELS; c++) {
+        window[slot][c] = (int8_t)(accumulator[c] >> FRAME_SHIFT);
+        accumulator[c] = 0;
+    }
+    pending = 0;
+}
+
+uint16_t GestureRecognizer::matchCost(uint8_t gesture) const {
+    if (gesture == GESTURE_NONE || gesture >= NUM_GESTURES || frames < GESTURE_LENGTH) {
+        return COST_ABANDONED;
+    }
+
+    const uint16_t limit = threshold(gesture);
+
+    // Two rows of the cost matrix, template frame i against window frame j.
+    // Only |i - j| <= GESTURE_DTW_BAND is evaluated; every in-band cell has
+    // an in-band predecessor, and the worst path (31 cells x 1530) fits 16 bits.
+    uint16_t rows[2][GESTURE_LENGTH];
+    uint16_t *prev = rows[0];
+    uint16_t *cur = rows[1];
+
+    for (uint8_t i = 0; i < GESTURE_LENGTH; i++) {
+        int8_t expected[GESTURE_CHANNELS];
+        memcpy_P(expected, GESTURE_TEMPLATES[gesture - 1][i], GESTURE_CHANNELS);
+
+        uint8_t lo = i > GESTURE_DTW_BAND ? i - GESTURE_DTW_BAND : 0;
+        uint8_t hi = i + GESTURE_DTW_BAND < GESTURE_LENGTH ? i + GESTURE_DTW_BAND : GESTURE_LENGTH - 1;
+        uint16_t rowMin = COST_ABANDONED;
+
+        for (uint8_t j = lo; j <= hi; j++) {
+            const int8_t *frame = window[(head + j) & (GESTURE_LENGTH - 1)];
+            uint16_t distance = 0;
+            for (uint8_t c = 0; c < GESTURE_CHANNELS; c++) {
+                int16_t diff = (int16_t)frame[c] - expected[c];
+                distance += diff < 0 ? -diff : diff;
+            }
+
+            uint16_t best;
+            if (i == 0) {
+                best = j == 0 ? 0 : cur[j - 1];
+            } else if (j == 0) {
+                best = prev[0];
+            } else {
+                // Diagonal is always in band; above only while j < i + band
+                best = prev[j - 1];
+                if (j < i + GESTURE_DTW_BAND && prev[j] < best) {
+                    best = prev[j];
+                }
+                if (j > lo && cur[j - 1] < best) {
+                    best = cur[j - 1];
+                }
+            }
+
+            cur[j] = best + distance;
+            if (cur[j] < rowMin) {
+                rowMin = cur[j];
+            }
+        }
+
+        // Costs only grow along a path, so no cell can come back under the limit
+        if (rowMin > limit) {
+            return COST_ABANDONED;
+        }
+
+        uint16_t *swap = prev;
+        prev = cur;
+        cur = swap;
+    }
+
+    return prev[GESTURE_LENGTH - 1];
+}
+
+uint8_t GestureRecognizer::bestMatch(uint16_t &score) const {
+    uint8_t best = GESTURE_NONE;
+    score = 0xFFFF;
+
+    for (uint8_t g = GESTURE_NONE + 1; g < NUM_GESTURES; g++) {
+        uint16_t cost = matchCost(g);
+        uint16_t limit = threshold(g);
+        if (cost > limit) {
+            continue;
+        }
+
+        // Rare (only under the threshold), so the divide is off the hot path
+        uint16_t scaled = ((uint32_t)cost << 8) / limit;
+        if (scaled < score) {
+            score = scaled;
+            best = g;
+        }
+    }
+    return best;
+}
+
+bool GestureRecognizer::addSample(const MotionSample &sample, GestureResult &result) {
+    accumulator[0] += sample.ax >> SAMPLE_SHIFT;
+    accumulator[1] += sample.ay >> SAMPLE_SHIFT;
+    accumulator[2] += sample.az >> SAMPLE_SHIFT;
+    accumulator[3] += sample.gx >> SAMPLE_SHIFT;
+    accumulator[4] += sample.gy >> SAMPLE_SHIFT;
+    accumulator[5] += sample.gz >> SAMPLE_SHIFT;
+
+    if (++pending < GESTURE_DECIMATION) {
+        return false;
+    }
+    pushFrame();
+
+    if (frames < GESTURE_LENGTH) {
+        return false;
+    }
+
+    uint16_t score;
+    uint8_t gesture = bestMatch(score);
+
+    // Fire once the best cost stops falling, i.e. at the best alignment
+    if (candidate.gesture != GESTURE_NONE && (gesture == GESTURE_NONE || score >= candidateScore)) {
+        result = candidate;
+        candidate.gesture = GESTURE_NONE;
+        frames = 0;
+        return true;
+    }
+
+    if (gesture != GESTURE_NONE) {
+        candidate.gesture = gesture;
+        candidate.confidence = score >= 255 ? 0 : 255 - score;
+        candidateScore = score;
+    }
+    return false;
+}
@@ -0,0 +1,75 @@
+#ifndef GESTURE_RECOGNIZER_H
+#define GESTURE_RECOGNIZER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "mpu6050_driver.h"
+
+// ===== Gesture Recognition =====
+// Raw accel + gyro samples are averaged GESTURE_DECIMATION at a time into
+// 6-byte frames (64 counts per g, ~0.5 counts per deg/s) and kept in a
+// ring buffer of the last GESTURE_LENGTH frames. Each new frame, the
+// window is matched against every template in flash with banded DTW
+// (integer L1 costs, early abandon once a whole band row is over the
+// template's threshold). A gesture fires at the frame where its cost
+// bottoms out below the threshold.
+//
+// SRAM: 96-byte window + 12-byte accumulator + 64 bytes of DTW rows on
+// the stack while matching. Templates and thresholds live in flash.
+
+enum Gesture : uint8_t {
+    GESTURE_NONE,
+    GESTURE_PALM_UP,            // Roll 180 degrees, palm down -> palm up
+    GESTURE_REPULSOR_THRUST,    // Palm forward, push out and stop
+    GESTURE_WRIST_FLICK,        // Quick flick up and back
+    NUM_GESTURES
+};
+
+static const uint8_t GESTURE_LENGTH = 16;      // Frames per template / window (power of two)
+static const uint8_t GESTURE_DTW_BAND = 4;     // Max warp in frames
+static const uint8_t GESTURE_CHANNELS = 6;     // ax, ay, az, gx, gy, gz
+
+static_assert((GESTURE_LENGTH & (GESTURE_LENGTH - 1)) == 0, "GESTURE_LENGTH must be a power of two");
+
+struct GestureResult {
+    uint8_t gesture;        // Gesture
+    uint8_t confidence;     // 255 = exact template match, 0 = at the threshold
+};
+
+class GestureRecognizer {
+public:
+    GestureRecognizer();
+
+    // Forget the window (e.g. after a sampling gap)
+    void reset();
+
+    // Feed one raw sample. Returns true when a gesture fired; the window
+    // is then cleared so one motion fires once.
+    bool addSample(const MotionSample &sample, GestureResult &result);
+
+    // Banded DTW cost of the current window against one template
+    // (0xFFFF when abandoned or the window is not full yet)
+    uint16_t matchCost(uint8_t gesture) const;
+
+    static uint16_t threshold(uint8_t gesture);
+    static const char *name(uint8_t gesture);
+
+private:
+    int8_t window[GESTURE_LENGTH][GESTURE_CHANNELS];
+    int16_t accumulator[GESTURE_CHANNELS];
+    uint8_t head;           // Oldest frame
+    uint8_t frames;         // Frames in the window, up to GESTURE_LENGTH
+    uint8_t pending;        // Samples in the accumulator
+
+    // Best match so far while a cost is still falling
+    GestureResult candidate;
+    uint16_t candidateScore;
+
+    void pushFrame();
+
+    // Best gesture for the current window; score is cost scaled so the
+    // threshold maps to 256
+    uint8_t bestMatch(uint16_t &score) const;
+};
+
+#endif // GESTURE_RECOGNIZER_H
@@ -0,0 +1,147 @@
+#include "imu_trace.h"
+#include <string.h>
+
+// ===== Varints =====
+
+static uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static uint8_t putVarint(uint8_t *out, uint32_t value) {
+    uint8_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+// Returns bytes read, 0 if truncated
+static uint8_t getVarint(const uint8_t *data, size_t length, uint32_t &value) {
+    value = 0;
+    for (uint8_t n = 0; n < 5 && n < length; n++) {
+        value |= (uint32_t)(data[n] & 0x7F) << (7 * n);
+        if (!(data[n] & 0x80)) {
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+// ===== Encoder =====
+
+ImuTraceEncoder::ImuTraceEncoder(uint16_t periodMicros)
+    : period(periodMicros) {
+    reset();
+}
+
+void ImuTraceEncoder::reset() {
+    absolute = true;
+    lastMicros = 0;
+    memset(&previous, 0, sizeof(previous));
+}
+
+uint8_t ImuTraceEncoder::writeHeader(uint8_t *out, uint8_t accelRange, uint8_t gyroRange) const {
+    memcpy(out, IMU_TRACE_MAGIC, 4);
+    out[4] = IMU_TRACE_VERSION;
+    out[5] = accelRange;
+    out[6] = gyroRange;
+    out[7] = 0;
+    out[8] = (uint8_t)period;
+    out[9] = (uint8_t)(period >> 8);
+    return IMU_TRACE_HEADER_SIZE;
+}
+
+uint8_t ImuTraceEncoder::encode(const MotionSample &sample, unsigned long timestampMicros,
+                                uint8_t *out) {
+    uint8_t n;
+    int32_t jitter = (int32_t)(timestampMicros - lastMicros - period);
+
+    // The jitter field has 30 bits after zigzag and the tag bit
+    if (jitter > 0x1FFFFFFFL || jitter < -0x20000000L) {
+        absolute = true;
+    }
+
+    if (absolute) {
+        n = putVarint(out, 1);
+        n += putVarint(out + n, timestampMicros);
+    } else {
+        n = putVarint(out, zigzag(jitter) << 1);
+    }
+
+    // Deltas of int16 values need 17 bits, which zigzag + varint covers
+    const int16_t *values = &sample.ax;
+    const int16_t *base = &previous.ax;
+    for (uint8_t c = 0; c < 6; c++) {
+        int32_t value = absolute ? values[c] : (int32_t)values[c] - base[c];
+        n += putVarint(out + n, zigzag(value));
+    }
+
+    previous = sample;
+    lastMicros = timestampMicros;
+    absolute = false;
+    return n;
+}
+
+// ===== Decoder =====
+
+ImuTraceDecoder::ImuTraceDecoder()
+    : lastMicros(0) {
+    memset(&traceHeader, 0, sizeof(traceHeader));
+    memset(&previous, 0, sizeof(previous));
+}
+
+uint8_t ImuTraceDecoder::readHeader(const uint8_t *data, size_t length) {
+    if (length < IMU_TRACE_HEADER_SIZE || memcmp(data, IMU_TRACE_MAGIC, 4) != 0 ||
+        data[4] != IMU_TRACE_VERSION) {
+        return 0;
+    }
+    traceHeader.version = data[4];
+    traceHeader.accelRange = data[5];
+    traceHeader.gyroRange = data[6];
+    traceHeader.periodMicros = (uint16_t)(data[8] | data[9] << 8);
+    return IMU_TRACE_HEADER_SIZE;
+}
+
+size_t ImuTraceDecoder::decode(const uint8_t *data, size_t length, ImuTraceRecord &record) {
+    uint32_t field;
+    size_t n = getVarint(data, length, field);
+    if (n == 0) {
+        return 0;
+    }
+
+    bool absolute = field & 1;
+    uint32_t timestamp;
+    if (absolute) {
+        uint8_t used = getVarint(data + n, length - n, timestamp);
+        if (used == 0) {
+            return 0;
+        }
+        n += used;
+    } else {
+        timestamp = lastMicros + traceHeader.periodMicros + (uint32_t)unzigzag(field >> 1);
+    }
+
+    int16_t values[6];
+    const int16_t *base = &previous.ax;
+    for (uint8_t c = 0; c < 6; c++) {
+        uint8_t used = getVarint(data + n, length - n, field);
+        if (used == 0) {
+            return 0;
+        }
+        n += used;
+        int32_t value = unzigzag(field);
+        values[c] = (int16_t)(absolute ? value : base[c] + value);
+    }
+
+    record.micros = timestamp;
+    memcpy(&record.sample, values, sizeof(values));
+    previous = record.sample;
+    lastMicros = record.micros;
+    return n;
+}
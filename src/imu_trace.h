@@ -0,0 +1,78 @@
+#ifndef IMU_TRACE_H
+#define IMU_TRACE_H
+
+#include <Arduino.h>
+#include "mpu6050_driver.h"
+
+// ===== IMU Trace Format =====
+// Compact stream of timestamped raw accel + gyro samples, written by the
+// firmware in TRACE_CAPTURE mode and read back by the host replay tool.
+//
+// Header (10 bytes):
+//   "IMUT", version, accel range, gyro range (MPU6050 register field
+//   values), reserved, nominal sample period in us (uint16, little endian)
+// Records, one per sample, all fields LEB128 varints:
+//   delta record:    zigzag(dt - period) << 1     dt = us since the previous record
+//                    6 x zigzag(value - previous) ax ay az gx gy gz
+//   absolute record: 1, micros(), 6 x zigzag(value)
+// The first record (and the first after reset() or a long gap) is
+// absolute. With typical sensor noise a sample costs ~10 bytes against
+// 16 for raw counts plus a timestamp.
+
+#define IMU_TRACE_MAGIC "IMUT"
+#define IMU_TRACE_VERSION 1
+#define IMU_TRACE_HEADER_SIZE 10
+#define IMU_TRACE_MAX_RECORD 24    // Absolute: tag, 5-byte time, 6 x 3-byte values
+
+struct ImuTraceHeader {
+    uint8_t version;
+    uint8_t accelRange;     // MPU6050AccelRange
+    uint8_t gyroRange;      // MPU6050GyroRange
+    uint16_t periodMicros;
+};
+
+struct ImuTraceRecord {
+    uint32_t micros;        // Device micros() at the read (wraps like micros())
+    MotionSample sample;
+};
+
+class ImuTraceEncoder {
+public:
+    explicit ImuTraceEncoder(uint16_t periodMicros);
+
+    // Next record is absolute
+    void reset();
+
+    // Write the stream header; returns IMU_TRACE_HEADER_SIZE
+    uint8_t writeHeader(uint8_t *out, uint8_t accelRange, uint8_t gyroRange) const;
+
+    // Encode one sample into `out` (IMU_TRACE_MAX_RECORD bytes); returns the size
+    uint8_t encode(const MotionSample &sample, unsigned long timestampMicros, uint8_t *out);
+
+private:
+    uint16_t period;
+    bool absolute;
+    unsigned long lastMicros;
+    MotionSample previous;
+};
+
+class ImuTraceDecoder {
+public:
+    ImuTraceDecoder();
+
+    // Parse the header; returns bytes consumed, 0 if this is not a trace
+    uint8_t readHeader(const uint8_t *data, size_t length);
+
+    const ImuTraceHeader &header() const { return traceHeader; }
+
+    // Decode the next record; returns bytes consumed, 0 if `data` holds
+    // only part of a record
+    size_t decode(const uint8_t *data, size_t length, ImuTraceRecord &record);
+
+private:
+    ImuTraceHeader traceHeader;
+    uint32_t lastMicros;
+    MotionSample previous;
+};
+
+#endif // IMU_TRACE_H
@@ -0,0 +1,75 @@
+#ifndef LED_BACKEND_H
+#define LED_BACKEND_H
+
+#include <Arduino.h>
+#include "led_facade.h"
+
+class RefreshScheduler;
+
+// Compile-time LED backend interface (CRTP).
+// A backend derives from LEDBackend<Self, N> and provides plain inline
+// begin(), setLED(), show(), setBrightness() and the frame counters.
+// Code templated on the backend type calls those directly, so per-pixel
+// loops inline and unroll for the fixed LED count instead of going
+// through a vtable.
+template <typename Derived, uint8_t N>
+class LEDBackend {
+public:
+    // Number of LEDs, usable in constant expressions
+    static constexpr uint8_t getNumLEDs() { return N; }
+    
+    // Set all LEDs to the same color
+    void setAll(uint8_t r, uint8_t g, uint8_t b) {
+        for (uint8_t i = 0; i < N; i++) {
+            derived().setLED(i, r, g, b);
+        }
+    }
+    
+    // Clear all LEDs (buffer only; output changes on show())
+    void clear() {
+        setAll(0, 0, 0);
+    }
+    
+    // Refresh slots (refresh_scheduler.h). Backends whose refresh blocks
+    // interrupts hide these; for the rest every show() goes out at once.
+    void setRefreshScheduler(RefreshScheduler *scheduler) { (void)scheduler; }
+    
+    // Send a frame show() held back, if a slot is open now
+    void showDeferred() {}
+    
+    // Refresh now, slot or not (before power-down, when stopping)
+    void showNow() { derived().show(); }
+    
+protected:
+    LEDBackend() {}
+    
+    Derived &derived() { return *static_cast<Derived *>(this); }
+};
+
+// Runtime-polymorphic wrapper for code that really needs to choose a
+// backend at runtime. Costs one vtable pointer plus an indirect call per
+// operation; the backend itself stays usable directly.
+template <typename Backend>
+class LEDFacadeAdapter : public ILEDFacade {
+private:
+    Backend &backend;
+    
+public:
+    explicit LEDFacadeAdapter(Backend &target) : backend(target) {}
+    
+    void begin() override { backend.begin(); }
+    
+    void setLED(uint8_t index, uint8_t r, uint8_t g, uint8_t b) override {
+        backend.setLED(index, r, g, b);
+    }
+    
+    void setAll(uint8_t r, uint8_t g, uint8_t b) override { backend.setAll(r, g, b); }
+    void clear() override { backend.clear(); }
+    void show() override { backend.show(); }
+    void setBrightness(uint8_t brightness) override { backend.setBrightness(brightness); }
+    uint8_t getNumLEDs() override { return Backend::getNumLEDs(); }
+    uint32_t getCommittedFrames() override { return backend.getCommittedFrames(); }
+    uint32_t getSkippedFrames() override { return backend.getSkippedFrames(); }
+};
+
+#endif // LED_BACKEND_H
@@ -2,14 +2,9 @@
 #define LED_CONTROLLER_H
 
 #include <Arduino.h>
-#include <FastLED.h>
-
-enum AnimationMode {
-    OFF,
-    POWER_UP,
-    STEADY,
-    FADE_OUT
-};
+#include "config.h"
+#include "fastled_facade.h"
+#include "compositor.h"
 
 class LEDController {
 public:
@@ -18,7 +13,8 @@ public:
     // Initialize LED strip
     void begin();
     
-    // Trigger the Iron Man activation sequence
+    // Trigger the Iron Man activation sequence; while one is playing,
+    // restart it with a crossfade from the current frame
     void activate();
     
     // Update LED animation (call in loop)
@@ -33,21 +29,15 @@ public:
     // Set brightness (0-255)
     void setBrightness(uint8_t brightness);
     
-private:
-    CRGB leds[NUM_LEDS];
+    // Hold refreshes for slots clear of the scheduler's protected tasks
+    void setRefreshScheduler(RefreshScheduler *scheduler);
     
-    AnimationMode currentMode;
-    unsigned long animationStartTime;
-    unsigned long activationTime;
-    uint8_t currentBrightness;
+    // Send a held frame if a slot is open now
+    void showDeferred();
     
-    // Animation functions
-    void animatePowerUp();
-    void animateSteady();
-    void animateFadeOut();
-    
-    // Helper to create Iron Man colors
-    CRGB getIronManColor(uint8_t index);
+private:
+    FastLEDFacade leds;
+    Compositor<FastLEDFacade, 1> compositor;
 };
 
-#endif // LED_CONTROLLER_H
\ No newline at end of file
+#endif // LED_CONTROLLER_H
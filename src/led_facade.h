@@ -4,7 +4,9 @@
 #include <Arduino.h>
 
 // Abstract interface for LED control
-// Allows swapping between FastLED (WS2812B) and regular LEDs (F5)
+// Allows swapping between FastLED (WS2812B) and regular LEDs (F5) at
+// runtime. Backends implement the compile-time LEDBackend interface
+// (led_backend.h); wrap one in LEDFacadeAdapter to use it through here.
 class ILEDFacade {
 public:
     virtual ~ILEDFacade() {}
@@ -29,6 +31,11 @@ public:
     
     // Get number of LEDs
     virtual uint8_t getNumLEDs() = 0;
+    
+    // show() calls that pushed output vs. ones skipped because
+    // nothing changed since the last commit
+    virtual uint32_t getCommittedFrames() = 0;
+    virtual uint32_t getSkippedFrames() = 0;
 };
 
 #endif // LED_FACADE_H
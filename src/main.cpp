@@ -2,14 +2,157 @@
 #include "config.h"
 #include "motion_detector.h"
 #include "led_controller.h"
+#include "task_scheduler.h"
+#include "refresh_scheduler.h"
+#if EVENT_LOOP
+#include "frame_clock.h"
+#endif
+#if TELEMETRY
+#include "telemetry.h"
+#endif
+#include "profiler.h"
 
 // Global objects
 MotionDetector motionDetector;
 LEDController ledController;
+TaskScheduler scheduler;
+RefreshScheduler refresh(scheduler);
+int8_t sensorTaskId = -1;
+#if ASYNC_TWI && !MPU_FIFO_MODE
+int8_t sampleTaskId = -1;
+#endif
+
+// Tasks setup() registers: sensor, animation, housekeeping, telemetry
+// drain, sample. A full table would only show as an id of -1 at runtime.
+static_assert(3 + (TELEMETRY ? 1 : 0) + (ASYNC_TWI && !MPU_FIFO_MODE ? 1 : 0)
+              <= TaskScheduler::MAX_TASKS, "more tasks than TaskScheduler::MAX_TASKS");
 
 // System state
 bool systemReady = false;
 
+// Act on the sample just read
+void sampleTask() {
+    // Check for hand raise motion. isHandRaised() fires once per raise,
+    // so a new raise during the sequence restarts it.
+    if (motionDetector.isHandRaised()) {
+        DEBUG_PRINTLN("*** ACTIVATING IRON MAN MODE ***");
+        ledController.activate();
+    }
+    
+    #if ADAPTIVE_SAMPLING
+    // Poll at the rate the MPU6050 now samples at
+    SamplingEvent sampling;
+    if (motionDetector.pollSamplingChange(sampling)) {
+        scheduler.setPeriod(sensorTaskId, 1000000UL / sampling.rate);
+    }
+    #endif
+    
+    // The next read is a whole period away: the best slot for a held frame
+    ledController.showDeferred();
+}
+
+void sensorTask() {
+    #if LOW_POWER_MODE
+    // Nothing showing and nothing moving: sleep until the MPU6050 sees motion
+    if (!ledController.isActive() && motionDetector.isIdle(millis())) {
+        DEBUG_PRINTLN("Idle - powering down until motion");
+        ledController.turnOff();
+        #if TELEMETRY
+        telemetry.flush();
+        #elif DEBUG || TRACE_CAPTURE
+        Serial.flush();
+        #endif
+        motionDetector.sleepUntilMotion();
+    }
+    #endif
+    
+    #if ASYNC_TWI && !MPU_FIFO_MODE
+    // Only start the read: the loop renders while the bytes move, and the
+    // TWI interrupt posts sampleTask once they are in
+    motionDetector.requestSample();
+    #else
+    sampleTask();
+    #endif
+}
+
+#if ASYNC_TWI && !MPU_FIFO_MODE
+// From the TWI interrupt, once the requested sample is in
+void postSampleTask() {
+    scheduler.post(sampleTaskId);
+}
+#endif
+
+#if EVENT_LOOP && MPU_FIFO_MODE
+// From the MPU6050 INT interrupt, once a batch is in the FIFO
+void postSensorTask() {
+    scheduler.post(sensorTaskId);
+}
+#endif
+
+void animationTask() {
+    // Update LED animations
+    ledController.update();
+}
+
+#if TELEMETRY
+void telemetryTask() {
+    {
+        PROFILE_SECTION(PROF_SERIAL);
+        telemetry.drain();
+    }
+    ledController.showDeferred();
+}
+#endif
+
+void housekeepingTask() {
+    #if DEBUG
+    {
+        PROFILE_SECTION(PROF_SERIAL);
+        scheduler.printStats();
+        const RefreshStats &stats = refresh.getStats();
+        DEBUG_PRINT("refresh: sent=");
+        DEBUG_PRINT(stats.committed);
+        DEBUG_PRINT(" deferred=");
+        DEBUG_PRINT(stats.deferred);
+        DEBUG_PRINT(" missed=");
+        DEBUG_PRINT(stats.missed);
+        DEBUG_PRINT(" hold<=");
+        DEBUG_PRINT(stats.maxDelay);
+        DEBUG_PRINTLN("us");
+        #if ADAPTIVE_SAMPLING
+        const SamplingStats &sampling = motionDetector.getSamplingStats();
+        DEBUG_PRINT("sampling: avg=");
+        DEBUG_PRINT(motionDetector.getAverageRate(millis()));
+        DEBUG_PRINT("Hz busy=");
+        DEBUG_PRINT(sampling.busyMicros);
+        DEBUG_PRINT("us switches=");
+        DEBUG_PRINTLN(sampling.switches);
+        #endif
+    }
+    #endif
+    #if TELEMETRY
+    for (uint8_t i = 0; i < scheduler.getNumTasks(); i++) {
+        const TaskStats &stats = scheduler.getStats(i);
+        telemetry.logTaskStats(i, scheduler.getIdlePercent(), stats.overruns,
+                               stats.maxLateness, stats.maxRunTime);
+    }
+    #endif
+    #if ADAPTIVE_SAMPLING
+    #if TELEMETRY
+    const SamplingStats &sampling = motionDetector.getSamplingStats();
+    telemetry.logSamplingStats(motionDetector.getAverageRate(millis()), sampling.busyMicros,
+                               sampling.switches);
+    #endif
+    motionDetector.resetSamplingStats();
+    #endif
+    scheduler.resetStats();
+    refresh.resetStats();
+    
+    #if PROFILER
+    profiler.pollCommand();
+    #endif
+}
+
 void setup() {
     // Initialize serial for debugging
     #if DEBUG
@@ -20,6 +163,27 @@ void setup() {
     DEBUG_PRINTLN("\n=== Iron Man Glove Starting ===");
     #endif
     
+    #if TRACE_CAPTURE
+    // Raw sample stream for host replay (the trace header goes out in
+    // motionDetector.begin())
+    Serial.begin(TRACE_CAPTURE_BAUD);
+    #endif
+    
+    #if TELEMETRY && !DEBUG
+    // Binary records only; with DEBUG the port is already open and the
+    // text lands between frames, where the decoder skips it
+    Serial.begin(TELEMETRY_BAUD);
+    #endif
+    
+    #if PROFILER
+    // The dump command and its output need the port (DEBUG and
+    // TELEMETRY have opened it already)
+    #if !DEBUG && !TELEMETRY
+    Serial.begin(115200);
+    #endif
+    profiler.begin();
+    #endif
+    
     // Initialize LED controller
     DEBUG_PRINTLN("Initializing LED Controller...");
     ledController.begin();
@@ -48,6 +212,35 @@ void setup() {
         }
     }
     
+    // Sensor, animation and housekeeping each run on their own deadline;
+    // strip refreshes stay clear of sensor reads and telemetry drains
+    #if EVENT_LOOP && MPU_FIFO_MODE
+    // Posted by the INT interrupt; frames by the Timer0 frame clock
+    sensorTaskId = scheduler.addTask("sensor", sensorTask, 0);
+    motionDetector.onBatchReady(postSensorTask);
+    #else
+    sensorTaskId = scheduler.addTask("sensor", sensorTask, 1000000UL / SAMPLE_RATE);
+    #endif
+    refresh.protect(sensorTaskId);
+    #if EVENT_LOOP
+    frameClock.begin(scheduler, scheduler.addTask("animation", animationTask, 0),
+                     1000000UL / ANIMATION_FPS);
+    #else
+    scheduler.addTask("animation", animationTask, 1000000UL / ANIMATION_FPS);
+    #endif
+    scheduler.addTask("housekeeping", housekeepingTask, HOUSEKEEPING_PERIOD_MS * 1000UL);
+    #if TELEMETRY
+    refresh.protect(scheduler.addTask("telemetry", telemetryTask,
+                                      TELEMETRY_DRAIN_PERIOD_MS * 1000UL));
+    #endif
+    #if ASYNC_TWI && !MPU_FIFO_MODE
+    // Posted by the TWI interrupt when a read started by sensorTask ends
+    sampleTaskId = scheduler.addTask("sample", sampleTask, 0);
+    motionDetector.onSampleReady(postSampleTask);
+    #endif
+    ledController.setRefreshScheduler(&refresh);
+    scheduler.resetStats();
+    
     systemReady = true;
     DEBUG_PRINTLN("=== System Ready ===\n");
 }
@@ -57,15 +250,5 @@ void loop() {
         return;
     }
     
-    // Check for hand raise motion
-    if (motionDetector.isHandRaised()) {
-        DEBUG_PRINTLN("*** ACTIVATING IRON MAN MODE ***");
-        ledController.activate();
-    }
-    
-    // Update LED animations
-    ledController.update();
-    
-    // Small delay to prevent overwhelming the I2C bus
-    delay(20); // ~50Hz update rate
+    scheduler.run();
 }
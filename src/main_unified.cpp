@@ -1,16 +1,33 @@
 #include <Arduino.h>
 #include "config.h"
-#include "led_facade.h"
+#include "task_scheduler.h"
+#include "refresh_scheduler.h"
+#if EVENT_LOOP
+#include "frame_clock.h"
+#endif
+#if TELEMETRY
+#include "telemetry.h"
+#endif
+#include "profiler.h"
+#include "compositor.h"
 
 // Include the appropriate LED implementation based on build configuration
 #ifdef LED_TYPE_FASTLED
     #include "fastled_facade.h"
-    FastLEDFacade ledFacade;
+    typedef FastLEDFacade LEDBackendType;
+#elif defined(F5_BAM)
+    #include "bam_facade.h"
+    typedef BAMFacade LEDBackendType;
+#elif defined(F5_DIRECT_PWM)
+    #include "timer_pwm_facade.h"
+    typedef TimerPWMFacade LEDBackendType;
 #else
     #include "f5led_facade.h"
-    F5LEDFacade ledFacade;
+    typedef F5LEDFacade LEDBackendType;
 #endif
 
+LEDBackendType ledFacade;
+
 // LED test mode vs full mode with motion sensor
 #ifdef TEST_MODE
     // Test mode - no motion sensor
@@ -22,206 +39,226 @@
     MotionDetector motionDetector;
 #endif
 
+TaskScheduler scheduler;
+RefreshScheduler refresh(scheduler);
+int8_t sensorTaskId = -1;
+#if USE_MOTION_SENSOR && ASYNC_TWI && !MPU_FIFO_MODE
+int8_t sampleTaskId = -1;
+#endif
+
+// Tasks setup() registers: sensor, animation, housekeeping, telemetry
+// drain, sample. A full table would only show as an id of -1 at runtime.
+static_assert((USE_MOTION_SENSOR ? 1 : 0) + 2 + (TELEMETRY ? 1 : 0) +
+              (USE_MOTION_SENSOR && ASYNC_TWI && !MPU_FIFO_MODE ? 1 : 0)
+              <= TaskScheduler::MAX_TASKS, "more tasks than TaskScheduler::MAX_TASKS");
+
 // System state
 bool systemReady = false;
 unsigned long lastActivation = 0;
 bool isActive = false;
 
-// Animation state
-enum AnimationState {
-    ANIM_OFF,
-    ANIM_POWER_UP,
-    ANIM_STEADY,
-    ANIM_FADE_OUT
+// Effect layers, bottom to top
+enum EffectLayer : uint8_t {
+    LAYER_IDLE_GLOW,
+    LAYER_ACTIVATION,
+    LAYER_STATUS
 };
 
-AnimationState currentAnimation = ANIM_OFF;
-unsigned long animationStartTime = 0;
-
-// Helper function to get color for LED index
-void getColorForIndex(uint8_t index, uint8_t &r, uint8_t &g, uint8_t &b) {
-    #ifdef LED_TYPE_FASTLED
-        // Alternate red and gold for Iron Man theme
-        if (index % 2 == 0) {
-            r = 255; g = 0; b = 0;      // Red
-        } else {
-            r = 255; g = 180; b = 0;    // Gold
-        }
-    #else
-        // For F5 single-color LEDs, just use blue
-        r = 0; g = 0; b = 255;
-    #endif
-}
+Compositor<LEDBackendType> compositor(ledFacade);
 
+// A new activation while one is playing restarts it, crossfading from
+// the current frame
 void startAnimation() {
-    currentAnimation = ANIM_POWER_UP;
-    animationStartTime = millis();
+    compositor.play(LAYER_ACTIVATION, ANIM_ACTIVATION, millis());
     lastActivation = millis();
     isActive = true;
     DEBUG_PRINTLN("*** ANIMATION STARTED ***");
 }
 
 void updateAnimation() {
-    unsigned long elapsed = millis() - animationStartTime;
-    unsigned long totalElapsed = millis() - lastActivation;
+    compositor.render(millis());
+    isActive = compositor.isPlaying(LAYER_ACTIVATION);
+}
+
+void runTestSequence() {
+    // Test sequence for LED validation
+    static uint8_t lastKeyframe = 0xFF;
     
-    switch (currentAnimation) {
-        case ANIM_OFF:
-            // Do nothing
-            break;
-            
-        case ANIM_POWER_UP: {
-            // Power up sequence - light LEDs one by one
-            uint8_t numLit = map(elapsed, 0, 500, 0, ledFacade.getNumLEDs());
-            
-            ledFacade.clear();
-            for (uint8_t i = 0; i < numLit && i < ledFacade.getNumLEDs(); i++) {
-                uint8_t r, g, b;
-                getColorForIndex(i, r, g, b);
-                ledFacade.setLED(i, r, g, b);
-            }
-            ledFacade.show();
-            
-            if (elapsed > 500) {
-                currentAnimation = ANIM_STEADY;
-                animationStartTime = millis();
-                DEBUG_PRINTLN("Power-up complete → Steady");
-            }
-            break;
-        }
-        
-        case ANIM_STEADY: {
-            // Breathing effect
-            float breathe = (sin(elapsed / 500.0) + 1.0) / 2.0; // 0.0 to 1.0
-            uint8_t brightness = 150 + (breathe * 105); // 150-255 range
-            
-            ledFacade.setBrightness(brightness);
-            
-            for (uint8_t i = 0; i < ledFacade.getNumLEDs(); i++) {
-                uint8_t r, g, b;
-                getColorForIndex(i, r, g, b);
-                ledFacade.setLED(i, r, g, b);
-            }
-            ledFacade.show();
-            
-            // Check if should start fading out
-            if (totalElapsed > ACTIVE_DURATION) {
-                currentAnimation = ANIM_FADE_OUT;
-                animationStartTime = millis();
-                DEBUG_PRINTLN("Steady → Fade out");
-            }
-            break;
+    if (!compositor.isPlaying(LAYER_ACTIVATION)) {
+        compositor.play(LAYER_ACTIVATION, ANIM_LED_TEST, millis(), true);
+    }
+    compositor.render(millis());
+    
+    uint8_t keyframe = compositor.timeline(LAYER_ACTIVATION).keyframeIndex();
+    if (keyframe != lastKeyframe) {
+        if (keyframe == 0 && lastKeyframe != 0xFF) {
+            Serial.println("\n--- Test sequence complete! Restarting... ---\n");
         }
-        
-        case ANIM_FADE_OUT: {
-            // Fade out over 1 second
-            uint8_t brightness = map(elapsed, 0, 1000, BRIGHTNESS, 0);
-            
-            if (elapsed > 1000 || brightness == 0) {
-                ledFacade.clear();
-                ledFacade.show();
-                currentAnimation = ANIM_OFF;
-                isActive = false;
-                ledFacade.setBrightness(BRIGHTNESS); // Reset brightness
-                DEBUG_PRINTLN("Fade out complete → Off");
-            } else {
-                ledFacade.setBrightness(brightness);
-                
-                for (uint8_t i = 0; i < ledFacade.getNumLEDs(); i++) {
-                    uint8_t r, g, b;
-                    getColorForIndex(i, r, g, b);
-                    ledFacade.setLED(i, r, g, b);
-                }
-                ledFacade.show();
-            }
-            break;
+        switch (keyframe) {
+            case 0: Serial.println("Test: All LEDs ON"); break;
+            case 1: Serial.println("Test: All LEDs OFF"); break;
+            case 2: Serial.println("Test: One by one"); break;
+            case 3: Serial.println("Test: Breathing effect"); break;
         }
+        lastKeyframe = keyframe;
     }
 }
 
-void runTestSequence() {
-    // Test sequence for LED validation
-    static unsigned long testStartTime = 0;
-    static uint8_t testPhase = 0;
-    unsigned long currentTime = millis();
+#if USE_MOTION_SENSOR && LOW_POWER_MODE
+// Nothing showing and nothing moving: sleep until the MPU6050 sees motion
+void sleepUntilMotion() {
+    DEBUG_PRINTLN("Idle - powering down until motion");
+    ledFacade.clear();
+    ledFacade.showNow();
+    
+    // The UART stops in power-down
+    #if TELEMETRY
+    telemetry.flush();
+    #elif DEBUG || TRACE_CAPTURE
+    Serial.flush();
+    #endif
     
-    if (testStartTime == 0) {
-        testStartTime = currentTime;
+    motionDetector.sleepUntilMotion();
+    DEBUG_PRINT("Awake after motion, sleep #");
+    DEBUG_PRINTLN(motionDetector.getWakeStats().wakes);
+}
+#endif
+
+// Act on the sample just read
+void sampleTask() {
+    #if USE_MOTION_SENSOR
+    // isHandRaised() fires once per raise, so a new raise during the
+    // sequence restarts it
+    if (motionDetector.isHandRaised()) {
+        DEBUG_PRINTLN("*** HAND RAISED - ACTIVATING! ***");
+        startAnimation();
     }
     
-    unsigned long elapsed = currentTime - testStartTime;
+    #if GESTURE_RECOGNITION
+    GestureResult gesture;
+    if (motionDetector.pollGesture(gesture)) {
+        DEBUG_PRINT("*** GESTURE - ACTIVATING! confidence ");
+        DEBUG_PRINTLN(gesture.confidence);
+        startAnimation();
+    }
+    #endif
     
-    switch (testPhase) {
-        case 0: // All on
-            if (elapsed == 0) {
-                Serial.println("Test: All LEDs ON");
-                for (uint8_t i = 0; i < ledFacade.getNumLEDs(); i++) {
-                    uint8_t r, g, b;
-                    getColorForIndex(i, r, g, b);
-                    ledFacade.setLED(i, r, g, b);
-                }
-                ledFacade.show();
-            }
-            if (elapsed > 2000) {
-                testPhase++;
-                testStartTime = currentTime;
-            }
-            break;
-            
-        case 1: // All off
-            if (elapsed == 0) {
-                Serial.println("Test: All LEDs OFF");
-                ledFacade.clear();
-                ledFacade.show();
-            }
-            if (elapsed > 2000) {
-                testPhase++;
-                testStartTime = currentTime;
-            }
-            break;
-            
-        case 2: // One by one
-            if (elapsed == 0) {
-                Serial.println("Test: One by one");
-            }
-            {
-                uint8_t lit = (elapsed / 500) % ledFacade.getNumLEDs();
-                ledFacade.clear();
-                uint8_t r, g, b;
-                getColorForIndex(lit, r, g, b);
-                ledFacade.setLED(lit, r, g, b);
-                ledFacade.show();
-            }
-            if (elapsed > 4000) {
-                testPhase++;
-                testStartTime = currentTime;
-            }
-            break;
-            
-        case 3: // Breathing
-            if (elapsed == 0) {
-                Serial.println("Test: Breathing effect");
-            }
-            {
-                float breathe = (sin(elapsed / 500.0) + 1.0) / 2.0;
-                uint8_t brightness = 50 + (breathe * 205);
-                ledFacade.setBrightness(brightness);
-                
-                for (uint8_t i = 0; i < ledFacade.getNumLEDs(); i++) {
-                    uint8_t r, g, b;
-                    getColorForIndex(i, r, g, b);
-                    ledFacade.setLED(i, r, g, b);
-                }
-                ledFacade.show();
-            }
-            if (elapsed > 5000) {
-                testPhase = 0; // Loop
-                testStartTime = currentTime;
-                ledFacade.setBrightness(BRIGHTNESS);
-                Serial.println("\n--- Test sequence complete! Restarting... ---\n");
-            }
-            break;
+    #if ADAPTIVE_SAMPLING
+    // Poll at the rate the MPU6050 now samples at
+    SamplingEvent sampling;
+    if (motionDetector.pollSamplingChange(sampling)) {
+        scheduler.setPeriod(sensorTaskId, 1000000UL / sampling.rate);
     }
+    #endif
+    
+    // The next read is a whole period away: the best slot for a held frame
+    ledFacade.showDeferred();
+    #endif
+}
+
+void sensorTask() {
+    #if USE_MOTION_SENSOR
+    #if LOW_POWER_MODE
+    if (!isActive && motionDetector.isIdle(millis())) {
+        sleepUntilMotion();
+    }
+    #endif
+    
+    #if ASYNC_TWI && !MPU_FIFO_MODE
+    // Only start the read: the loop renders while the bytes move, and the
+    // TWI interrupt posts sampleTask once they are in
+    motionDetector.requestSample();
+    #else
+    sampleTask();
+    #endif
+    #endif
+}
+
+#if USE_MOTION_SENSOR && ASYNC_TWI && !MPU_FIFO_MODE
+// From the TWI interrupt, once the requested sample is in
+void postSampleTask() {
+    scheduler.post(sampleTaskId);
+}
+#endif
+
+#if EVENT_LOOP && MPU_FIFO_MODE && USE_MOTION_SENSOR
+// From the MPU6050 INT interrupt, once a batch is in the FIFO
+void postSensorTask() {
+    scheduler.post(sensorTaskId);
+}
+#endif
+
+void animationTask() {
+    #ifdef TEST_MODE
+        // Run continuous test sequence
+        runTestSequence();
+    #else
+        // Render while any layer or crossfade is on the LEDs
+        if (compositor.isShowing()) {
+            updateAnimation();
+        }
+    #endif
+}
+
+#if TELEMETRY
+void telemetryTask() {
+    {
+        PROFILE_SECTION(PROF_SERIAL);
+        telemetry.drain();
+    }
+    ledFacade.showDeferred();
+}
+#endif
+
+void housekeepingTask() {
+    #if DEBUG
+    {
+        PROFILE_SECTION(PROF_SERIAL);
+        scheduler.printStats();
+        #ifdef LED_TYPE_FASTLED
+        const RefreshStats &stats = refresh.getStats();
+        DEBUG_PRINT("refresh: sent=");
+        DEBUG_PRINT(stats.committed);
+        DEBUG_PRINT(" deferred=");
+        DEBUG_PRINT(stats.deferred);
+        DEBUG_PRINT(" missed=");
+        DEBUG_PRINT(stats.missed);
+        DEBUG_PRINT(" hold<=");
+        DEBUG_PRINT(stats.maxDelay);
+        DEBUG_PRINTLN("us");
+        #endif
+        #if USE_MOTION_SENSOR && ADAPTIVE_SAMPLING
+        const SamplingStats &sampling = motionDetector.getSamplingStats();
+        DEBUG_PRINT("sampling: avg=");
+        DEBUG_PRINT(motionDetector.getAverageRate(millis()));
+        DEBUG_PRINT("Hz busy=");
+        DEBUG_PRINT(sampling.busyMicros);
+        DEBUG_PRINT("us switches=");
+        DEBUG_PRINTLN(sampling.switches);
+        #endif
+    }
+    #endif
+    #if TELEMETRY
+    for (uint8_t i = 0; i < scheduler.getNumTasks(); i++) {
+        const TaskStats &stats = scheduler.getStats(i);
+        telemetry.logTaskStats(i, scheduler.getIdlePercent(), stats.overruns,
+                               stats.maxLateness, stats.maxRunTime);
+    }
+    #endif
+    #if USE_MOTION_SENSOR && ADAPTIVE_SAMPLING
+    #if TELEMETRY
+    const SamplingStats &sampling = motionDetector.getSamplingStats();
+    telemetry.logSamplingStats(motionDetector.getAverageRate(millis()), sampling.busyMicros,
+                               sampling.switches);
+    #endif
+    motionDetector.resetSamplingStats();
+    #endif
+    scheduler.resetStats();
+    refresh.resetStats();
+    
+    #if PROFILER
+    profiler.pollCommand();
+    #endif
 }
 
 void setup() {
@@ -251,6 +288,27 @@ void setup() {
     DEBUG_PRINTLN("Initializing LED controller...");
     ledFacade.begin();
     
+    #if USE_MOTION_SENSOR && TRACE_CAPTURE
+    // Raw sample stream for host replay (the trace header goes out in
+    // motionDetector.begin())
+    Serial.begin(TRACE_CAPTURE_BAUD);
+    #endif
+    
+    #if TELEMETRY && !DEBUG
+    // Binary records only; with DEBUG the port is already open and the
+    // text lands between frames, where the decoder skips it
+    Serial.begin(TELEMETRY_BAUD);
+    #endif
+    
+    #if PROFILER
+    // The dump command and its output need the port (DEBUG and
+    // TELEMETRY have opened it already)
+    #if !DEBUG && !TELEMETRY
+    Serial.begin(115200);
+    #endif
+    profiler.begin();
+    #endif
+    
     #if USE_MOTION_SENSOR
     // Initialize motion detector
     DEBUG_PRINTLN("Initializing motion detector...");
@@ -263,17 +321,49 @@ void setup() {
         DEBUG_PRINTLN("  GND -> GND");
         
         // Flash LEDs to indicate error
+        compositor.play(LAYER_STATUS, ANIM_STATUS_FAULT, millis(), true);
         while (true) {
-            ledFacade.setAll(255, 0, 0);
-            ledFacade.show();
-            delay(200);
-            ledFacade.clear();
-            ledFacade.show();
-            delay(200);
+            compositor.render(millis());
+            delay(1000 / ANIMATION_FPS);
         }
     }
     #endif
     
+    // Sensor polling at SAMPLE_RATE, rendering at ANIMATION_FPS. Strip
+    // refreshes stay clear of sensor reads and telemetry drains. In the
+    // event loop, frames and FIFO batches are posted by interrupts.
+    #if USE_MOTION_SENSOR
+    #if EVENT_LOOP && MPU_FIFO_MODE
+    sensorTaskId = scheduler.addTask("sensor", sensorTask, 0);
+    motionDetector.onBatchReady(postSensorTask);
+    #else
+    sensorTaskId = scheduler.addTask("sensor", sensorTask, 1000000UL / SAMPLE_RATE);
+    #endif
+    refresh.protect(sensorTaskId);
+    #endif
+    #if EVENT_LOOP
+    frameClock.begin(scheduler, scheduler.addTask("animation", animationTask, 0),
+                     1000000UL / ANIMATION_FPS);
+    #else
+    scheduler.addTask("animation", animationTask, 1000000UL / ANIMATION_FPS);
+    #endif
+    scheduler.addTask("housekeeping", housekeepingTask, HOUSEKEEPING_PERIOD_MS * 1000UL);
+    #if TELEMETRY
+    refresh.protect(scheduler.addTask("telemetry", telemetryTask,
+                                      TELEMETRY_DRAIN_PERIOD_MS * 1000UL));
+    #endif
+    #if USE_MOTION_SENSOR && ASYNC_TWI && !MPU_FIFO_MODE
+    // Posted by the TWI interrupt when a read started by sensorTask ends
+    sampleTaskId = scheduler.addTask("sample", sampleTask, 0);
+    motionDetector.onSampleReady(postSampleTask);
+    #endif
+    ledFacade.setRefreshScheduler(&refresh);
+    scheduler.resetStats();
+    
+    #if IDLE_GLOW && !defined(TEST_MODE)
+    compositor.play(LAYER_IDLE_GLOW, ANIM_IDLE_GLOW, millis(), true);
+    #endif
+    
     systemReady = true;
     DEBUG_PRINTLN("=== System Ready ===\n");
 }
@@ -283,23 +373,5 @@ void loop() {
         return;
     }
     
-    #ifdef TEST_MODE
-        // Run continuous test sequence
-        runTestSequence();
-    #else
-        // Full mode with motion sensor
-        #if USE_MOTION_SENSOR
-        if (!isActive && motionDetector.isHandRaised()) {
-            DEBUG_PRINTLN("*** HAND RAISED - ACTIVATING! ***");
-            startAnimation();
-        }
-        #endif
-        
-        // Update animation if active
-        if (isActive) {
-            updateAnimation();
-        }
-    #endif
-    
-    delay(20); // ~50Hz update rate
+    scheduler.run();
 }
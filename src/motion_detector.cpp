@@ -1,14 +1,136 @@
 #include "motion_detector.h"
 #include "config.h"
+#include "constexpr_math.h"
+#include "profiler.h"
+#include "event_queue.h"
 #include <math.h>
+#if LOW_POWER_MODE
+#include "power.h"
+#endif
+
+// Feature combinations the sample path cannot serve
+#if MPU_FIFO_MODE && (GESTURE_RECOGNITION || ORIENTATION_FUSION || TRACE_CAPTURE)
+    #error "Gestures, fusion and the trace need gyro samples; FIFO mode only queues accel"
+#endif
+#if TRACE_CAPTURE && DEBUG
+    #error "TRACE_CAPTURE writes binary to Serial; build with DEBUG=0"
+#endif
+#if ADAPTIVE_SAMPLING && MPU_FIFO_MODE
+    #error "ADAPTIVE_SAMPLING reads one sample per task run; FIFO mode batches them"
+#endif
+#if ADAPTIVE_SAMPLING && GESTURE_RECOGNITION
+    #error "Gesture templates assume a fixed SAMPLE_RATE; no ADAPTIVE_SAMPLING with them"
+#endif
+#if TRACE_CAPTURE && TELEMETRY
+    #error "TRACE_CAPTURE and TELEMETRY both stream binary over Serial; pick one"
+#endif
+
+// ===== Fixed-point tilt threshold =====
+// pitch = atan2(-x, sqrt(y^2 + z^2)) > A  <=>  -x > 0 && x^2 > tan^2(A) * (y^2 + z^2)
+// tan^2(A) is folded into a Q8 constant so the hot path is integer only.
+static_assert(ACTIVATION_ANGLE > 0 && ACTIVATION_ANGLE < 90,
+              "ACTIVATION_ANGLE must be between 0 and 90 degrees");
+
+static constexpr uint32_t TILT_TAN2_Q8 =
+    constexprRound(constexprTan(degreesToRadians(ACTIVATION_ANGLE)) *
+                   constexprTan(degreesToRadians(ACTIVATION_ANGLE)) * 256.0);
+
+// Counts are reduced to 1024 per g before squaring so x^2 * 256 fits in 32 bits
+static const uint8_t TILT_COUNT_SHIFT = 4;
+
+// Beyond this y^2 + z^2 the right-hand side overflows and can never be beaten
+static constexpr uint32_t TILT_MAX_YZ2 = 0xFFFFFFFFUL / TILT_TAN2_Q8;
+
+#if ORIENTATION_FUSION
+static constexpr int16_t ACTIVATION_PITCH = orientationFromDegrees(ACTIVATION_ANGLE);
+#endif
+
+#if LOW_POWER_MODE
+// The MPU6050's wake-up comparison, in +/-2g counts
+static constexpr int16_t STILL_COUNTS = (int16_t)(LOW_POWER_WAKE_MG * 16384L / 1000);
+
+static bool movedFrom(int16_t value, int16_t rest) {
+    int16_t delta = value - rest;
+    return delta > STILL_COUNTS || delta < -STILL_COUNTS;
+}
+#endif
+
+#if !MPU_FIFO_MODE
+// One burst per sample from ACCEL_XOUT_H: accel, or accel + temperature
+// + gyro for the gesture window, the filter and the trace
+#if GESTURE_RECOGNITION || ORIENTATION_FUSION || TRACE_CAPTURE
+static const uint8_t SAMPLE_BYTES = 14;
+#else
+static const uint8_t SAMPLE_BYTES = 6;
+#endif
+#endif
+
+#if ASYNC_TWI && !MPU_FIFO_MODE
+// Filled by the TWI interrupt. The status stays TWI_BUSY if the read
+// was aborted on a timeout, which never calls back.
+static uint8_t sampleBytes[SAMPLE_BYTES];
+static volatile uint8_t sampleStatus = TWI_OK;
+static void (*sampleReadyHandler)() = nullptr;
+
+static void onSampleRead(uint8_t status) {
+    sampleStatus = status;
+    if (sampleReadyHandler) {
+        sampleReadyHandler();
+    }
+}
+#endif
+
+#if MPU_FIFO_MODE
+// The INT pin pulses once per sample, right as the sample enters the
+// FIFO, so each sensor-ready event's timestamp belongs to exactly one
+// FIFO entry, in order. Stamped with millis(), the clock isIdle(),
+// sleepUntilMotion() and telemetry use: micros() / 1000 would wrap
+// after 71.6 minutes and leave lastMotionTime far behind millis().
+static EventQueue<unsigned long, 16> sampleReady;
+static void (*batchReadyHandler)() = nullptr;
+
+static void onDataReady() {
+    // A full queue also calls the handler, in case its batch call was lost
+    if (!sampleReady.push(millis()) || sampleReady.count() == FIFO_BATCH_SIZE) {
+        if (batchReadyHandler) {
+            batchReadyHandler();
+        }
+    }
+}
+#endif
 
 MotionDetector::MotionDetector() 
-    : lastTriggerTime(0), wasRaised(false) {
+    : lastTriggerTime(0), wasRaised(false)
+    #if TRACE_CAPTURE
+      , trace(1000000UL / SAMPLE_RATE)
+    #endif
+{
+    #if GESTURE_RECOGNITION
+    lastGesture.gesture = GESTURE_NONE;
+    lastGesture.confidence = 0;
+    #endif
+    #if LOW_POWER_MODE
+    restX = restY = restZ = 0;
+    lastMotionTime = 0;
+    wakeMicros = 0;
+    awaitingFirstSample = false;
+    wakeStats.wakes = 0;
+    wakeStats.lastLatency = 0;
+    wakeStats.maxLatency = 0;
+    #endif
+    #if ADAPTIVE_SAMPLING
+    samplingChanged = false;
+    resetSamplingStats();
+    #endif
+    #if ASYNC_TWI && !MPU_FIFO_MODE
+    sampleRequested = false;
+    requestMicros = 0;
+    #endif
 }
 
 bool MotionDetector::begin() {
     // Initialize I2C
-    Wire.begin();
+    MPU6050Driver::beginBus(I2C_CLOCK_HZ);
     
     // Try to initialize MPU6050
     if (!mpu.begin()) {
@@ -19,28 +141,89 @@ bool MotionDetector::begin() {
     DEBUG_PRINTLN("MPU6050 Found!");
     
     // Configure sensor ranges
-    mpu.setAccelerometerRange(MPU6050_RANGE_2_G);
-    mpu.setGyroRange(MPU6050_RANGE_250_DEG);
-    mpu.setFilterBandwidth(MPU6050_BAND_21_HZ);
+    mpu.setAccelRange(MPU6050_ACCEL_2G);
+    mpu.setGyroRange(MPU6050_GYRO_250DPS);
+    #if ADAPTIVE_SAMPLING
+    // Start at the motion rate; a still hand drops it after ADAPTIVE_HOLD_MS
+    sampler.reset(SAMPLING_MOTION, millis());
+    applySampling(SAMPLING_MOTION, millis());
+    #else
+    #if ORIENTATION_FUSION
+    // The filter rejects accel transients, so only anti-alias filtering is needed
+    mpu.setBandwidth(MPU6050_DLPF_44HZ);
+    #else
+    mpu.setBandwidth(MPU6050_DLPF_21HZ);
+    #endif
+    
+    // Apply SAMPLE_RATE (the divider only gives 1000/n Hz)
+    mpu.setSampleRate(SAMPLE_RATE);
+    #endif
+    
+    #if MPU_FIFO_MODE || LOW_POWER_MODE
+    pinMode(MPU_INT_PIN, INPUT);
+    #endif
+    
+    #if MPU_FIFO_MODE
+    startFifo();
+    DEBUG_PRINTLN("MPU6050 FIFO mode enabled");
+    #endif
     
     // Small delay for sensor stabilization
     delay(100);
     
+    #if TRACE_CAPTURE
+    uint8_t header[IMU_TRACE_HEADER_SIZE];
+    Serial.write(header, trace.writeHeader(header, MPU6050_ACCEL_2G, MPU6050_GYRO_250DPS));
+    #endif
+    
     return true;
 }
 
+#if MPU_FIFO_MODE
+void MotionDetector::startFifo() {
+    mpu.beginFifo();
+    // INT is detached here, so nothing is pushing
+    sampleReady.clear();
+    sampleReady.takeOverflows();
+    attachInterrupt(digitalPinToInterrupt(MPU_INT_PIN), onDataReady, RISING);
+}
+#endif
+
+void MotionDetector::resetHistory() {
+    #if GESTURE_RECOGNITION
+    gestures.reset();
+    #endif
+    #if ORIENTATION_FUSION
+    orientation.reset();
+    #endif
+    #if TRACE_CAPTURE
+    trace.reset();
+    #endif
+}
+
 bool MotionDetector::isConnected() {
-    sensors_event_t a, g, temp;
-    return mpu.getEvent(&a, &g, &temp);
+    return mpu.isConnected();
+}
+
+void MotionDetector::getRawAcceleration(int16_t &x, int16_t &y, int16_t &z) {
+    PROFILE_SECTION(PROF_SENSOR_READ);
+    if (!mpu.readAccel(x, y, z)) {
+        // Treat a failed read as a level hand so it can never trigger
+        x = 0;
+        y = 0;
+        z = mpu.accelCountsPerG();
+    }
 }
 
 void MotionDetector::getAcceleration(float &x, float &y, float &z) {
-    sensors_event_t a, g, temp;
-    mpu.getEvent(&a, &g, &temp);
+    int16_t rx, ry, rz;
+    getRawAcceleration(rx, ry, rz);
     
-    x = a.acceleration.x;
-    y = a.acceleration.y;
-    z = a.acceleration.z;
+    // Convert counts to m/s^2
+    const float scale = 9.80665f / mpu.accelCountsPerG();
+    x = rx * scale;
+    y = ry * scale;
+    z = rz * scale;
 }
 
 float MotionDetector::calculatePitch(float x, float y, float z) {
@@ -50,35 +233,45 @@ float MotionDetector::calculatePitch(float x, float y, float z) {
     return pitch;
 }
 
-bool MotionDetector::debounce() {
-    unsigned long currentTime = millis();
+bool MotionDetector::isPitchAboveThreshold(int16_t x, int16_t y, int16_t z) {
+    // Pitch is only positive when X points down
+    if (x >= 0) {
+        return false;
+    }
+    
+    int16_t xs = x >> TILT_COUNT_SHIFT;
+    int16_t ys = y >> TILT_COUNT_SHIFT;
+    int16_t zs = z >> TILT_COUNT_SHIFT;
     
-    if (currentTime - lastTriggerTime < DEBOUNCE_TIME) {
+    uint32_t x2 = (int32_t)xs * xs;
+    uint32_t yz2 = (uint32_t)((int32_t)ys * ys) + (uint32_t)((int32_t)zs * zs);
+    
+    if (yz2 > TILT_MAX_YZ2) {
+        return false;
+    }
+    
+    return (x2 << 8) > yz2 * TILT_TAN2_Q8;
+}
+
+bool MotionDetector::debounce(unsigned long timestamp) {
+    if (timestamp - lastTriggerTime < DEBOUNCE_TIME) {
         return false; // Still in debounce period
     }
     
     return true;
 }
 
-bool MotionDetector::isHandRaised() {
-    float x, y, z;
-    getAcceleration(x, y, z);
-    
-    // Calculate the pitch angle
-    float pitch = calculatePitch(x, y, z);
-    
-    DEBUG_PRINT("Pitch: ");
-    DEBUG_PRINTLN(pitch);
-    
+bool MotionDetector::processSample(int16_t x, int16_t y, int16_t z, unsigned long timestamp) {
     // Check if hand is raised above threshold angle
-    bool isRaised = (pitch > ACTIVATION_ANGLE);
+    bool isRaised = isRaisedAt(x, y, z);
     
     // Detect rising edge (transition from not raised to raised)
-    if (isRaised && !wasRaised && debounce()) {
+    bool triggered = false;
+    if (isRaised && !wasRaised && debounce(timestamp)) {
         wasRaised = true;
-        lastTriggerTime = millis();
+        lastTriggerTime = timestamp;
+        triggered = true;
         DEBUG_PRINTLN("HAND RAISED - ACTIVATING!");
-        return true;
     }
     
     // Update state for next check
@@ -86,5 +279,370 @@ bool MotionDetector::isHandRaised() {
         wasRaised = false;
     }
     
-    return false;
+    adaptToSample(x, y, z, timestamp);
+    trackMotion(x, y, z, timestamp);
+    logSample(x, y, z, timestamp, isRaised, triggered);
+    return triggered;
+}
+
+// ===== Per-Sample Hooks =====
+
+#if ORIENTATION_FUSION
+bool MotionDetector::isRaisedAt(int16_t, int16_t, int16_t) {
+    return orientation.pitch() > ACTIVATION_PITCH;
+}
+#else
+bool MotionDetector::isRaisedAt(int16_t x, int16_t y, int16_t z) {
+    PROFILE_SECTION(PROF_PITCH);
+    return isPitchAboveThreshold(x, y, z);
+}
+#endif
+
+#if TRACE_CAPTURE
+void MotionDetector::traceSample(const MotionSample &sample, unsigned long sampleMicros) {
+    uint8_t record[IMU_TRACE_MAX_RECORD];
+    Serial.write(record, trace.encode(sample, sampleMicros, record));
+}
+#else
+void MotionDetector::traceSample(const MotionSample &, unsigned long) {}
+#endif
+
+#if ORIENTATION_FUSION
+void MotionDetector::fuseSample(const MotionSample &sample, unsigned long sampleMicros) {
+    PROFILE_SECTION(PROF_PITCH);
+    orientation.update(sample, sampleMicros);
+}
+#else
+void MotionDetector::fuseSample(const MotionSample &, unsigned long) {}
+#endif
+
+#if GESTURE_RECOGNITION
+void MotionDetector::recognizeSample(const MotionSample &sample) {
+    GestureResult result;
+    if (gestures.addSample(sample, result)) {
+        lastGesture = result;
+        DEBUG_PRINT("GESTURE: ");
+        DEBUG_PRINTLN(GestureRecognizer::name(result.gesture));
+        #if TELEMETRY
+        telemetry.logGesture(result.gesture, result.confidence);
+        #endif
+    }
+}
+#else
+void MotionDetector::recognizeSample(const MotionSample &) {}
+#endif
+
+#if ADAPTIVE_SAMPLING
+void MotionDetector::adaptToSample(int16_t x, int16_t y, int16_t z, unsigned long timestamp) {
+    samplingStats.samples++;
+    if (sampler.update(x, y, z, timestamp)) {
+        samplingStats.switches++;
+        applySampling(sampler.profile(), timestamp);
+    }
+}
+#else
+void MotionDetector::adaptToSample(int16_t, int16_t, int16_t, unsigned long) {}
+#endif
+
+#if LOW_POWER_MODE
+void MotionDetector::trackMotion(int16_t x, int16_t y, int16_t z, unsigned long timestamp) {
+    if (movedFrom(x, restX) || movedFrom(y, restY) || movedFrom(z, restZ)) {
+        restX = x;
+        restY = y;
+        restZ = z;
+        lastMotionTime = timestamp;
+    }
+    
+    if (awaitingFirstSample) {
+        awaitingFirstSample = false;
+        wakeStats.lastLatency = micros() - wakeMicros;
+        if (wakeStats.lastLatency > wakeStats.maxLatency) {
+            wakeStats.maxLatency = wakeStats.lastLatency;
+        }
+        #if TELEMETRY
+        telemetry.logWake(wakeStats.lastLatency, wakeStats.wakes);
+        #endif
+    }
+}
+#else
+void MotionDetector::trackMotion(int16_t, int16_t, int16_t, unsigned long) {}
+#endif
+
+#if TELEMETRY
+void MotionDetector::logSample(int16_t x, int16_t y, int16_t z, unsigned long timestamp,
+                               bool raised, bool triggered) {
+    // Raw counts rather than a pitch: the host does the trigonometry
+    #if ORIENTATION_FUSION
+    int16_t pitch = orientation.pitch();
+    #else
+    int16_t pitch = TELEM_NO_PITCH;
+    #endif
+    telemetry.logSample(timestamp, x, y, z, pitch,
+                        (raised ? TELEM_FLAG_RAISED : 0) | (triggered ? TELEM_FLAG_TRIGGERED : 0));
+}
+#else
+void MotionDetector::logSample(int16_t, int16_t, int16_t, unsigned long, bool, bool) {}
+#endif
+
+#if MPU_FIFO_MODE
+bool MotionDetector::drainFifo() {
+    uint16_t queued = mpu.fifoCount();
+    
+    // A full FIFO has started overwriting its oldest entries
+    if (sampleReady.hasOverflowed() || queued > MPU6050_FIFO_SIZE - 6) {
+        // Edges or samples were lost, so the pairing is gone: start over.
+        // An edge between the two resets leaves an unstamped orphan, which
+        // the next drain drops.
+        DEBUG_PRINTLN("MPU6050 FIFO overflow - resetting");
+        #if TELEMETRY
+        telemetry.logEvent(TELEM_FIFO_OVERFLOW);
+        #endif
+        mpu.resetFifo();
+        sampleReady.clear();
+        sampleReady.takeOverflows();
+        return false;
+    }
+    
+    AccelSample samples[FIFO_BATCH_SIZE];
+    uint8_t count = queued / 6;
+    uint8_t stamped = sampleReady.count();
+    
+    // An edge always follows its FIFO write, so extra timestamps are just
+    // samples in flight. Extra samples can only be orphans from before a
+    // reset - they are the oldest entries, so drop them.
+    while (count > stamped) {
+        uint8_t orphans = count - stamped;
+        uint8_t dropped = mpu.readFifo(samples, orphans < FIFO_BATCH_SIZE ? orphans : FIFO_BATCH_SIZE);
+        if (dropped == 0) {
+            return false;
+        }
+        count -= dropped;
+    }
+    
+    bool triggered = false;
+    while (count > 0) {
+        uint8_t burst;
+        {
+            PROFILE_SECTION(PROF_SENSOR_READ);
+            burst = mpu.readFifo(samples, count < FIFO_BATCH_SIZE ? count : FIFO_BATCH_SIZE);
+        }
+        if (burst == 0) {
+            break;
+        }
+        
+        for (uint8_t i = 0; i < burst; i++) {
+            unsigned long sampleMillis = 0;
+            sampleReady.pop(sampleMillis);
+            
+            if (processSample(samples[i].x, samples[i].y, samples[i].z, sampleMillis)) {
+                triggered = true;
+            }
+        }
+        count -= burst;
+    }
+    return triggered;
+}
+#endif
+
+bool MotionDetector::isHandRaised() {
+    #if ADAPTIVE_SAMPLING
+    unsigned long start = micros();
+    bool triggered = readAndProcess();
+    samplingStats.busyMicros += micros() - start;
+    return triggered;
+    #else
+    return readAndProcess();
+    #endif
+}
+
+bool MotionDetector::readAndProcess() {
+    #if MPU_FIFO_MODE
+    if (sampleReady.count() < FIFO_BATCH_SIZE && !sampleReady.hasOverflowed()) {
+        return false;
+    }
+    return drainFifo();
+    #else
+    #if LOW_POWER_MODE
+    // After a wake-up, wait for a full-rate sample to replace the last
+    // wake-up one
+    if (awaitingFirstSample) {
+        #if ASYNC_TWI
+        // A requested read may predate DATA_RDY; drop it
+        if (sampleRequested) {
+            asyncTwi.wait();
+            sampleRequested = false;
+        }
+        #endif
+        if (!(mpu.readIntStatus() & MPU6050_INT_DATA_RDY)) {
+            return false;
+        }
+    }
+    #endif
+    
+    uint8_t bytes[SAMPLE_BYTES];
+    unsigned long sampleMicros;
+    bool read = fetchSample(bytes, sampleMicros);
+    
+    #if GESTURE_RECOGNITION || ORIENTATION_FUSION || TRACE_CAPTURE
+    // One 14-byte burst feeds the tilt test, the gesture window, the filter
+    // and the trace
+    if (!read) {
+        // A gap breaks the sample sequence; treat the hand as level
+        resetHistory();
+        return processSample(0, 0, mpu.accelCountsPerG(), millis());
+    }
+    MotionSample sample;
+    MPU6050Driver::decodeMotion(bytes, sample);
+    traceSample(sample, sampleMicros);
+    fuseSample(sample, sampleMicros);
+    recognizeSample(sample);
+    return processSample(sample.ax, sample.ay, sample.az, millis());
+    #else
+    int16_t x, y, z;
+    if (read) {
+        MPU6050Driver::decodeAccel(bytes, x, y, z);
+    } else {
+        // Treat a failed read as a level hand so it can never trigger
+        x = 0;
+        y = 0;
+        z = mpu.accelCountsPerG();
+    }
+    return processSample(x, y, z, millis());
+    #endif
+    #endif
+}
+
+#if !MPU_FIFO_MODE
+bool MotionDetector::fetchSample(uint8_t *bytes, unsigned long &sampleMicros) {
+    PROFILE_SECTION(PROF_SENSOR_READ);
+    #if ASYNC_TWI
+    if (sampleRequested) {
+        // Usually in by now; otherwise wait for the rest (or the timeout)
+        sampleRequested = false;
+        sampleMicros = requestMicros;
+        asyncTwi.wait();
+        if (sampleStatus != TWI_OK) {
+            return false;
+        }
+        memcpy(bytes, sampleBytes, SAMPLE_BYTES);
+        return true;
+    }
+    #endif
+    sampleMicros = micros();
+    return mpu.readRegisters(MPU6050_REG_ACCEL_XOUT_H, bytes, SAMPLE_BYTES);
+}
+#endif
+
+#if ASYNC_TWI && !MPU_FIFO_MODE
+bool MotionDetector::requestSample() {
+    // Still on the bus, and not for too long
+    if (sampleRequested && sampleStatus == TWI_BUSY && asyncTwi.isBusy() &&
+        !asyncTwi.checkTimeout()) {
+        return false;
+    }
+    if (sampleRequested && sampleStatus == TWI_BUSY) {
+        DEBUG_PRINTLN("MPU6050 read timed out");
+    }
+    
+    sampleStatus = TWI_BUSY;
+    requestMicros = micros();
+    sampleRequested = mpu.startRead(MPU6050_REG_ACCEL_XOUT_H, sampleBytes, SAMPLE_BYTES,
+                                    onSampleRead);
+    return sampleRequested;
+}
+
+void MotionDetector::onSampleReady(void (*handler)()) {
+    sampleReadyHandler = handler;
+}
+#endif
+
+#if MPU_FIFO_MODE
+void MotionDetector::onBatchReady(void (*handler)()) {
+    batchReadyHandler = handler;
+}
+#endif
+
+#if GESTURE_RECOGNITION
+bool MotionDetector::pollGesture(GestureResult &result) {
+    if (lastGesture.gesture == GESTURE_NONE) {
+        return false;
+    }
+    result = lastGesture;
+    lastGesture.gesture = GESTURE_NONE;
+    return true;
+}
+#endif
+
+#if LOW_POWER_MODE
+bool MotionDetector::isIdle(unsigned long now) const {
+    return !wasRaised && now - lastMotionTime >= LOW_POWER_IDLE_MS;
+}
+
+void MotionDetector::sleepUntilMotion() {
+    #if MPU_FIFO_MODE
+    // INT is about to change meaning
+    detachInterrupt(digitalPinToInterrupt(MPU_INT_PIN));
+    #endif
+    
+    // The resting pose is held by the MPU6050; any axis moving more than
+    // LOW_POWER_WAKE_MG from it pulls INT low
+    mpu.beginMotionWake(LOW_POWER_WAKE_MG, (MPU6050WakeRate)LOW_POWER_WAKE_RATE);
+    powerDownUntilLow(MPU_INT_PIN);
+    wakeMicros = micros();
+    wakeStats.wakes++;
+    
+    mpu.endMotionWake();
+    #if MPU_FIFO_MODE
+    startFifo();
+    #endif
+    
+    resetHistory();
+    lastMotionTime = millis();
+    awaitingFirstSample = true;
+    
+    #if ADAPTIVE_SAMPLING
+    // Whatever woke us is motion
+    if (sampler.profile() != SAMPLING_MOTION) {
+        samplingStats.switches++;
+    }
+    sampler.reset(SAMPLING_MOTION, lastMotionTime);
+    applySampling(SAMPLING_MOTION, lastMotionTime);
+    #endif
+}
+#endif
+
+#if ADAPTIVE_SAMPLING
+void MotionDetector::applySampling(SamplingProfile profile, unsigned long timestamp) {
+    mpu.setBandwidth(AdaptiveSampler::bandwidthFor(profile));
+    samplingEvent.profile = profile;
+    samplingEvent.rate = mpu.setSampleRate(AdaptiveSampler::rateFor(profile));
+    samplingEvent.timestamp = timestamp;
+    samplingChanged = true;
+    DEBUG_PRINT("Sample rate -> ");
+    DEBUG_PRINTLN(samplingEvent.rate);
+    #if TELEMETRY
+    telemetry.logSamplingSwitch(profile, samplingEvent.rate, sampler.variance());
+    #endif
+}
+
+bool MotionDetector::pollSamplingChange(SamplingEvent &event) {
+    if (!samplingChanged) {
+        return false;
+    }
+    event = samplingEvent;
+    samplingChanged = false;
+    return true;
+}
+
+uint16_t MotionDetector::getAverageRate(unsigned long now) const {
+    unsigned long elapsed = now - samplingStats.since;
+    return elapsed ? samplingStats.samples * 1000UL / elapsed : 0;
+}
+
+void MotionDetector::resetSamplingStats() {
+    samplingStats.samples = 0;
+    samplingStats.busyMicros = 0;
+    samplingStats.switches = 0;
+    samplingStats.since = millis();
 }
+#endif
@@ -2,9 +2,43 @@
 #define MOTION_DETECTOR_H
 
 #include <Arduino.h>
-#include <Adafruit_MPU6050.h>
-#include <Adafruit_Sensor.h>
-#include <Wire.h>
+#include "config.h"
+#include "mpu6050_driver.h"
+#if GESTURE_RECOGNITION
+#include "gesture_recognizer.h"
+#endif
+#if ORIENTATION_FUSION
+#include "orientation_filter.h"
+#endif
+#if TRACE_CAPTURE
+#include "imu_trace.h"
+#endif
+#if TELEMETRY
+#include "telemetry.h"
+#endif
+#if ADAPTIVE_SAMPLING
+#include "adaptive_sampler.h"
+#endif
+
+#if LOW_POWER_MODE
+// Wake-up latency: from the CPU waking to the first sample processed at
+// full rate (microseconds of awake time)
+struct WakeStats {
+    unsigned long wakes;
+    unsigned long lastLatency;
+    unsigned long maxLatency;
+};
+#endif
+
+#if ADAPTIVE_SAMPLING
+// Sampling since the last resetSamplingStats()
+struct SamplingStats {
+    unsigned long samples;
+    unsigned long busyMicros;   // Inside isHandRaised(), bus transfers included
+    unsigned long switches;     // Profile changes
+    unsigned long since;        // ms
+};
+#endif
 
 class MotionDetector {
 public:
@@ -13,26 +47,168 @@ public:
     // Initialize the MPU6050 sensor
     bool begin();
     
-    // Check if hand is raised (returns true when hand motion detected)
+    // Check if hand is raised (returns true when hand motion detected).
+    // In FIFO mode this only touches the bus once a batch is queued.
     bool isHandRaised();
     
+    #if MPU_FIFO_MODE
+    // Called from the INT interrupt each time a batch of FIFO_BATCH_SIZE
+    // samples is queued (or the queue has overflowed), so the sensor task
+    // can be released by events instead of polling. Must be ISR-safe.
+    void onBatchReady(void (*handler)());
+    #endif
+    
+    #if ASYNC_TWI && !MPU_FIFO_MODE
+    // Start reading the next sample in the background and return at
+    // once; the next isHandRaised() processes it, waiting for the rest
+    // if need be. A read stuck past TWI_TIMEOUT_US is given up on, and
+    // a finished one nobody processed is replaced. False while a read
+    // is still in flight.
+    bool requestSample();
+    
+    // Called from the TWI interrupt when a requested read ends, so a
+    // task can be posted to process it. Must be ISR-safe.
+    void onSampleReady(void (*handler)());
+    #endif
+    
+    #if GESTURE_RECOGNITION
+    // Gesture fired by the samples read so far, if any (cleared on read)
+    bool pollGesture(GestureResult &result);
+    #endif
+    
+    #if ADAPTIVE_SAMPLING
+    // Profile switch since the last call, if any; the sensor task should
+    // then run at event.rate (cleared on read)
+    bool pollSamplingChange(SamplingEvent &event);
+    
+    uint16_t getSampleRate() const { return AdaptiveSampler::rateFor(sampler.profile()); }
+    
+    const SamplingStats &getSamplingStats() const { return samplingStats; }
+    
+    // Samples per second since resetSamplingStats()
+    uint16_t getAverageRate(unsigned long now) const;
+    
+    void resetSamplingStats();
+    #endif
+    
+    #if ORIENTATION_FUSION
+    // Fused pitch/roll, updated every sample
+    const OrientationFilter &getOrientation() const { return orientation; }
+    #endif
+    
+    #if LOW_POWER_MODE
+    // No movement beyond LOW_POWER_WAKE_MG for LOW_POWER_IDLE_MS, hand down
+    bool isIdle(unsigned long now) const;
+    
+    // Put the MPU6050 into wake-on-motion, power down until it fires,
+    // then restore full-rate sampling
+    void sleepUntilMotion();
+    
+    const WakeStats &getWakeStats() const { return wakeStats; }
+    #endif
+    
     // Get current acceleration values
     void getAcceleration(float &x, float &y, float &z);
     
     // Check sensor status
     bool isConnected();
     
+    // Reference pitch in degrees (soft-float atan2/sqrt - host tools only)
+    static float calculatePitch(float x, float y, float z);
+    
+    // Integer tilt test on raw accelerometer counts:
+    // true when calculatePitch() would exceed ACTIVATION_ANGLE
+    static bool isPitchAboveThreshold(int16_t x, int16_t y, int16_t z);
+    
 private:
-    Adafruit_MPU6050 mpu;
+    MPU6050Driver mpu;
     
     unsigned long lastTriggerTime;
     bool wasRaised;
     
-    // Calculate pitch angle from accelerometer data
-    float calculatePitch(float x, float y, float z);
+    #if GESTURE_RECOGNITION
+    GestureRecognizer gestures;
+    GestureResult lastGesture;
+    #endif
+    
+    #if ORIENTATION_FUSION
+    OrientationFilter orientation;
+    #endif
+    
+    #if ADAPTIVE_SAMPLING
+    AdaptiveSampler sampler;
+    SamplingEvent samplingEvent;
+    bool samplingChanged;
+    SamplingStats samplingStats;
+    
+    // Program the MPU6050 rate and DLPF for `profile` and queue the event
+    void applySampling(SamplingProfile profile, unsigned long timestamp);
+    #endif
+    
+    #if TRACE_CAPTURE
+    ImuTraceEncoder trace;
+    #endif
+    
+    #if LOW_POWER_MODE
+    int16_t restX, restY, restZ;    // Pose the stillness test compares with
+    unsigned long lastMotionTime;
+    unsigned long wakeMicros;
+    bool awaitingFirstSample;
+    WakeStats wakeStats;
+    #endif
+    
+    // Forget sample history after a gap (failed read, sleep)
+    void resetHistory();
+    
+    #if MPU_FIFO_MODE
+    void startFifo();
+    #endif
+    
+    #if ASYNC_TWI && !MPU_FIFO_MODE
+    bool sampleRequested;
+    unsigned long requestMicros;
+    #endif
+    
+    // Read raw accelerometer counts (16384 per g at +/-2g)
+    void getRawAcceleration(int16_t &x, int16_t &y, int16_t &z);
+    
+    // Read the next sample(s) and run detection (isHandRaised() body)
+    bool readAndProcess();
+    
+    #if !MPU_FIFO_MODE
+    // Raw bytes of the next sample, from the requested read if there is
+    // one, and the micros() it was taken at. False on a bus error.
+    bool fetchSample(uint8_t *bytes, unsigned long &sampleMicros);
+    #endif
+    
+    // Run detection on one sample taken at `timestamp` (ms), then hand it
+    // to the per-feature consumers. Returns true on a debounced rising edge.
+    bool processSample(int16_t x, int16_t y, int16_t z, unsigned long timestamp);
+    
+    // Per-sample hooks, one per feature; each is empty with its feature
+    // off. The tilt test, or the fused pitch with ORIENTATION_FUSION:
+    bool isRaisedAt(int16_t x, int16_t y, int16_t z);
+    
+    // Full 14-byte samples, before detection: TRACE_CAPTURE,
+    // ORIENTATION_FUSION, GESTURE_RECOGNITION
+    void traceSample(const MotionSample &sample, unsigned long sampleMicros);
+    void fuseSample(const MotionSample &sample, unsigned long sampleMicros);
+    void recognizeSample(const MotionSample &sample);
+    
+    // Accel counts after detection: ADAPTIVE_SAMPLING, LOW_POWER_MODE,
+    // TELEMETRY
+    void adaptToSample(int16_t x, int16_t y, int16_t z, unsigned long timestamp);
+    void trackMotion(int16_t x, int16_t y, int16_t z, unsigned long timestamp);
+    void logSample(int16_t x, int16_t y, int16_t z, unsigned long timestamp, bool raised,
+                   bool triggered);
+    
+    #if MPU_FIFO_MODE
+    // Drain the FIFO and process every queued sample
+    bool drainFifo();
+    #endif
     
     // Apply debouncing logic
-    bool debounce();
+    bool debounce(unsigned long timestamp);
 };
 
 #endif // MOTION_DETECTOR_H
\ No newline at end of file
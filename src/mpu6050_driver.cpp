@@ -0,0 +1,211 @@
+#include "mpu6050_driver.h"
+
+MPU6050Driver::MPU6050Driver(uint8_t address)
+    : address(address), accelRange(MPU6050_ACCEL_2G), sampleRate(1000) {
+}
+
+void MPU6050Driver::beginBus(uint32_t clockHz) {
+    #if ASYNC_TWI
+    asyncTwi.begin(clockHz);
+    #else
+    Wire.begin();
+    Wire.setClock(clockHz);
+    #endif
+}
+
+bool MPU6050Driver::writeRegister(uint8_t reg, uint8_t value) {
+    #if ASYNC_TWI
+    return asyncTwi.write(address, reg, &value, 1) == TWI_OK;
+    #else
+    Wire.beginTransmission(address);
+    Wire.write(reg);
+    Wire.write(value);
+    return Wire.endTransmission() == 0;
+    #endif
+}
+
+bool MPU6050Driver::readRegisters(uint8_t reg, uint8_t *buffer, uint8_t length) {
+    #if ASYNC_TWI
+    return asyncTwi.read(address, reg, buffer, length) == TWI_OK;
+    #else
+    Wire.beginTransmission(address);
+    Wire.write(reg);
+    if (Wire.endTransmission(false) != 0) {
+        return false;
+    }
+    
+    if (Wire.requestFrom(address, length) != length) {
+        return false;
+    }
+    
+    for (uint8_t i = 0; i < length; i++) {
+        buffer[i] = Wire.read();
+    }
+    return true;
+    #endif
+}
+
+bool MPU6050Driver::isConnected() {
+    uint8_t id = 0;
+    return readRegisters(MPU6050_REG_WHO_AM_I, &id, 1) && id == MPU6050_WHO_AM_I_VALUE;
+}
+
+bool MPU6050Driver::begin() {
+    if (!isConnected()) {
+        return false;
+    }
+    
+    // Device reset, then wake with the X gyro PLL as clock source
+    writeRegister(MPU6050_REG_PWR_MGMT_1, 0x80);
+    delay(100);
+    writeRegister(MPU6050_REG_PWR_MGMT_1, 0x01);
+    
+    setAccelRange(MPU6050_ACCEL_2G);
+    return true;
+}
+
+void MPU6050Driver::setAccelRange(MPU6050AccelRange range) {
+    accelRange = range;
+    writeRegister(MPU6050_REG_ACCEL_CONFIG, range << 3);
+}
+
+void MPU6050Driver::setGyroRange(MPU6050GyroRange range) {
+    writeRegister(MPU6050_REG_GYRO_CONFIG, range << 3);
+}
+
+void MPU6050Driver::setBandwidth(MPU6050Bandwidth bandwidth) {
+    writeRegister(MPU6050_REG_CONFIG, bandwidth);
+}
+
+bool MPU6050Driver::readAccel(int16_t &x, int16_t &y, int16_t &z) {
+    uint8_t buffer[6];
+    if (!readRegisters(MPU6050_REG_ACCEL_XOUT_H, buffer, sizeof(buffer))) {
+        return false;
+    }
+    
+    decodeAccel(buffer, x, y, z);
+    return true;
+}
+
+bool MPU6050Driver::readMotion(MotionSample &sample) {
+    uint8_t buffer[14];
+    if (!readRegisters(MPU6050_REG_ACCEL_XOUT_H, buffer, sizeof(buffer))) {
+        return false;
+    }
+    
+    decodeMotion(buffer, sample);
+    return true;
+}
+
+void MPU6050Driver::decodeAccel(const uint8_t *bytes, int16_t &x, int16_t &y, int16_t &z) {
+    x = toInt16(&bytes[0]);
+    y = toInt16(&bytes[2]);
+    z = toInt16(&bytes[4]);
+}
+
+void MPU6050Driver::decodeMotion(const uint8_t *bytes, MotionSample &sample) {
+    sample.ax = toInt16(&bytes[0]);
+    sample.ay = toInt16(&bytes[2]);
+    sample.az = toInt16(&bytes[4]);
+    // bytes[6..7] is TEMP_OUT, skipped
+    sample.gx = toInt16(&bytes[8]);
+    sample.gy = toInt16(&bytes[10]);
+    sample.gz = toInt16(&bytes[12]);
+}
+
+uint16_t MPU6050Driver::setSampleRate(uint16_t hz) {
+    if (hz == 0) hz = 1;
+    uint16_t divider = 1000 / hz;
+    if (divider > 256) divider = 256;
+    if (divider < 1) divider = 1;
+    writeRegister(MPU6050_REG_SMPLRT_DIV, divider - 1);
+    sampleRate = 1000 / divider;
+    return sampleRate;
+}
+
+void MPU6050Driver::beginFifo() {
+    // Only accel goes into the FIFO: 6 bytes per sample
+    writeRegister(MPU6050_REG_FIFO_EN, MPU6050_FIFO_EN_ACCEL);
+    // INT: active high push-pull 50us pulse, status cleared by any read
+    writeRegister(MPU6050_REG_INT_PIN_CFG, MPU6050_INT_PIN_RD_CLEAR);
+    writeRegister(MPU6050_REG_INT_ENABLE, MPU6050_INT_DATA_RDY);
+    resetFifo();
+}
+
+void MPU6050Driver::resetFifo() {
+    writeRegister(MPU6050_REG_USER_CTRL, MPU6050_USER_CTRL_FIFO_RESET);
+    writeRegister(MPU6050_REG_USER_CTRL, MPU6050_USER_CTRL_FIFO_EN);
+}
+
+uint16_t MPU6050Driver::fifoCount() {
+    uint8_t buffer[2];
+    if (!readRegisters(MPU6050_REG_FIFO_COUNTH, buffer, sizeof(buffer))) {
+        return 0;
+    }
+    return (uint16_t)buffer[0] << 8 | buffer[1];
+}
+
+uint8_t MPU6050Driver::readFifo(AccelSample *samples, uint8_t count) {
+    // AVR Wire buffers 32 bytes: 5 samples per burst
+    const uint8_t SAMPLES_PER_BURST = 5;
+    uint8_t buffer[SAMPLES_PER_BURST * 6];
+    uint8_t read = 0;
+    
+    while (read < count) {
+        uint8_t burst = count - read;
+        if (burst > SAMPLES_PER_BURST) burst = SAMPLES_PER_BURST;
+        
+        if (!readRegisters(MPU6050_REG_FIFO_R_W, buffer, burst * 6)) {
+            break;
+        }
+        
+        for (uint8_t i = 0; i < burst; i++) {
+            samples[read + i].x = toInt16(&buffer[i * 6]);
+            samples[read + i].y = toInt16(&buffer[i * 6 + 2]);
+            samples[read + i].z = toInt16(&buffer[i * 6 + 4]);
+        }
+        read += burst;
+    }
+    return read;
+}
+
+void MPU6050Driver::beginMotionWake(uint16_t thresholdMg, MPU6050WakeRate rate) {
+    uint16_t threshold = thresholdMg / MPU6050_MOT_THR_MG;
+    if (threshold > 255) threshold = 255;
+    if (threshold < 1) threshold = 1;
+    
+    writeRegister(MPU6050_REG_PWR_MGMT_2, MPU6050_PWR2_STBY_GYRO);
+    writeRegister(MPU6050_REG_MOT_THR, (uint8_t)threshold);
+    writeRegister(MPU6050_REG_MOT_DUR, 1);
+    // INT: active low, held until INT_STATUS is read - AVR INT0/INT1 only
+    // wake from power-down on a low level
+    writeRegister(MPU6050_REG_INT_PIN_CFG, MPU6050_INT_PIN_ACTIVE_LOW | MPU6050_INT_PIN_LATCH);
+    writeRegister(MPU6050_REG_INT_ENABLE, MPU6050_INT_MOTION);
+    
+    // HPF reset, then hold: motion is measured against the pose at the
+    // next sample
+    writeRegister(MPU6050_REG_ACCEL_CONFIG, accelRange << 3);
+    delay(1000 / sampleRate + 1);
+    writeRegister(MPU6050_REG_ACCEL_CONFIG, accelRange << 3 | MPU6050_ACCEL_HPF_HOLD);
+    readIntStatus();
+    
+    // Internal oscillator (the PLL needs the gyros), temperature off, cycle
+    writeRegister(MPU6050_REG_PWR_MGMT_2, rate << 6 | MPU6050_PWR2_STBY_GYRO);
+    writeRegister(MPU6050_REG_PWR_MGMT_1, MPU6050_PWR1_CYCLE | MPU6050_PWR1_TEMP_DIS);
+}
+
+void MPU6050Driver::endMotionWake() {
+    writeRegister(MPU6050_REG_PWR_MGMT_1, MPU6050_PWR1_CLK_PLL_X);
+    writeRegister(MPU6050_REG_PWR_MGMT_2, 0);
+    writeRegister(MPU6050_REG_INT_PIN_CFG, 0);
+    // DATA_RDY in INT_STATUS marks the first full-rate sample
+    writeRegister(MPU6050_REG_INT_ENABLE, MPU6050_INT_DATA_RDY);
+    writeRegister(MPU6050_REG_ACCEL_CONFIG, accelRange << 3);
+    readIntStatus();
+}
+
+uint8_t MPU6050Driver::readIntStatus() {
+    uint8_t status = 0;
+    readRegisters(MPU6050_REG_INT_STATUS, &status, 1);
+    return status;
+}
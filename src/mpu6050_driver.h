@@ -0,0 +1,194 @@
+#ifndef MPU6050_DRIVER_H
+#define MPU6050_DRIVER_H
+
+#include <Arduino.h>
+#include "config.h"
+#if ASYNC_TWI
+#include "async_twi.h"
+#else
+#include <Wire.h>
+#endif
+
+// ===== MPU6050 Register Map (subset used by the glove) =====
+enum MPU6050Register : uint8_t {
+    MPU6050_REG_SMPLRT_DIV   = 0x19,
+    MPU6050_REG_CONFIG       = 0x1A,
+    MPU6050_REG_GYRO_CONFIG  = 0x1B,
+    MPU6050_REG_ACCEL_CONFIG = 0x1C,
+    MPU6050_REG_MOT_THR      = 0x1F,
+    MPU6050_REG_MOT_DUR      = 0x20,
+    MPU6050_REG_FIFO_EN      = 0x23,
+    MPU6050_REG_INT_PIN_CFG  = 0x37,
+    MPU6050_REG_INT_ENABLE   = 0x38,
+    MPU6050_REG_INT_STATUS   = 0x3A,
+    MPU6050_REG_ACCEL_XOUT_H = 0x3B,
+    MPU6050_REG_GYRO_XOUT_H  = 0x43,
+    MPU6050_REG_USER_CTRL    = 0x6A,
+    MPU6050_REG_PWR_MGMT_1   = 0x6B,
+    MPU6050_REG_PWR_MGMT_2   = 0x6C,
+    MPU6050_REG_FIFO_COUNTH  = 0x72,
+    MPU6050_REG_FIFO_R_W     = 0x74,
+    MPU6050_REG_WHO_AM_I     = 0x75
+};
+
+// Register bits
+#define MPU6050_FIFO_EN_ACCEL     0x08
+#define MPU6050_USER_CTRL_FIFO_EN 0x40
+#define MPU6050_USER_CTRL_FIFO_RESET 0x04
+#define MPU6050_INT_DATA_RDY      0x01
+#define MPU6050_INT_MOTION        0x40
+#define MPU6050_INT_PIN_RD_CLEAR  0x10
+#define MPU6050_INT_PIN_LATCH     0x20
+#define MPU6050_INT_PIN_ACTIVE_LOW 0x80
+#define MPU6050_PWR1_CLK_PLL_X    0x01
+#define MPU6050_PWR1_TEMP_DIS     0x08
+#define MPU6050_PWR1_CYCLE        0x20
+#define MPU6050_PWR2_STBY_GYRO    0x07
+#define MPU6050_ACCEL_HPF_HOLD    0x07
+#define MPU6050_MOT_THR_MG        2     // MOT_THR step
+
+#define MPU6050_FIFO_SIZE 1024
+
+#define MPU6050_DEFAULT_ADDRESS 0x68
+#define MPU6050_WHO_AM_I_VALUE  0x68
+
+// Full-scale ranges (register field values)
+enum MPU6050AccelRange : uint8_t {
+    MPU6050_ACCEL_2G = 0,
+    MPU6050_ACCEL_4G,
+    MPU6050_ACCEL_8G,
+    MPU6050_ACCEL_16G
+};
+
+enum MPU6050GyroRange : uint8_t {
+    MPU6050_GYRO_250DPS = 0,
+    MPU6050_GYRO_500DPS,
+    MPU6050_GYRO_1000DPS,
+    MPU6050_GYRO_2000DPS
+};
+
+// Digital low-pass filter bandwidth (CONFIG.DLPF_CFG)
+enum MPU6050Bandwidth : uint8_t {
+    MPU6050_DLPF_260HZ = 0,
+    MPU6050_DLPF_184HZ,
+    MPU6050_DLPF_94HZ,
+    MPU6050_DLPF_44HZ,
+    MPU6050_DLPF_21HZ,
+    MPU6050_DLPF_10HZ,
+    MPU6050_DLPF_5HZ
+};
+
+// Accel-only cycle rate while waiting for motion (PWR_MGMT_2.LP_WAKE_CTRL)
+enum MPU6050WakeRate : uint8_t {
+    MPU6050_WAKE_1_25HZ = 0,
+    MPU6050_WAKE_5HZ,
+    MPU6050_WAKE_20HZ,
+    MPU6050_WAKE_40HZ
+};
+
+// Raw accel counts from one FIFO entry
+struct AccelSample {
+    int16_t x, y, z;
+};
+
+// Raw accel + gyro counts from one burst read
+struct MotionSample {
+    int16_t ax, ay, az;
+    int16_t gx, gy, gz;
+};
+
+// Minimal register-level MPU6050 driver.
+// Reads raw int16 counts only - no float conversion, no unified sensor
+// events - and only the bytes the caller needs. Register access goes
+// through Wire, or through AsyncTwi with ASYNC_TWI.
+class MPU6050Driver {
+public:
+    MPU6050Driver(uint8_t address = MPU6050_DEFAULT_ADDRESS);
+    
+    // Start the I2C master at `clockHz`
+    static void beginBus(uint32_t clockHz);
+    
+    // Verify WHO_AM_I, reset and wake the sensor
+    bool begin();
+    
+    // Single-byte WHO_AM_I read
+    bool isConnected();
+    
+    // Burst-read the 6 accelerometer bytes
+    bool readAccel(int16_t &x, int16_t &y, int16_t &z);
+    
+    // Burst-read accel + gyro. Temperature sits between them in the
+    // register map; one 14-byte burst is cheaper than two transactions.
+    bool readMotion(MotionSample &sample);
+    
+    // Raw bytes of the bursts above, from ACCEL_XOUT_H: 6 for accel,
+    // 14 for accel + gyro
+    static void decodeAccel(const uint8_t *bytes, int16_t &x, int16_t &y, int16_t &z);
+    static void decodeMotion(const uint8_t *bytes, MotionSample &sample);
+    
+    #if ASYNC_TWI
+    // Start reading `length` registers from `reg` in the background;
+    // see AsyncTwi::startRead()
+    bool startRead(uint8_t reg, uint8_t *buffer, uint8_t length, AsyncTwi::Callback done) {
+        return asyncTwi.startRead(address, reg, buffer, length, done);
+    }
+    #endif
+    
+    void setAccelRange(MPU6050AccelRange range);
+    void setGyroRange(MPU6050GyroRange range);
+    void setBandwidth(MPU6050Bandwidth bandwidth);
+    
+    // Output data rate via SMPLRT_DIV (assumes the DLPF is enabled,
+    // i.e. a 1 kHz internal rate). Returns the rate actually set.
+    uint16_t setSampleRate(uint16_t hz);
+    
+    // ===== FIFO / data-ready mode =====
+    // Accel samples are queued in the on-chip FIFO at the sample rate and
+    // INT pulses high once per sample.
+    void beginFifo();
+    void resetFifo();
+    
+    // Bytes currently queued (multiples of 6 while only accel is enabled)
+    uint16_t fifoCount();
+    
+    // Pop `count` accel samples, oldest first. The caller must know they
+    // are queued (see fifoCount()). Returns the number read, fewer on bus
+    // error. Reads in Wire-buffer-sized bursts.
+    uint8_t readFifo(AccelSample *samples, uint8_t count);
+    
+    // ===== Wake-on-motion =====
+    // Gyros to standby, accel-only cycling at `rate`. Each wake-up sample
+    // is compared with the pose held on entry, and INT is pulled low
+    // (latched until readIntStatus()) once any axis moves more than
+    // `thresholdMg`. Takes one sample period to capture the pose.
+    // Datasheet supply: ~20 uA at 5 Hz, ~70 uA at 20 Hz, against 3.9 mA
+    // with the gyros running.
+    void beginMotionWake(uint16_t thresholdMg, MPU6050WakeRate rate);
+    
+    // Back to continuous accel + gyro at the configured rate. Until the
+    // first new sample the data registers still hold the last wake-up
+    // sample; INT_STATUS.DATA_RDY (see readIntStatus()) marks the switch.
+    // FIFO mode has to call beginFifo() again.
+    void endMotionWake();
+    
+    // Read (and clear) INT_STATUS
+    uint8_t readIntStatus();
+    
+    // Accelerometer counts per g for the configured range
+    uint16_t accelCountsPerG() const { return 16384 >> accelRange; }
+    
+    // Raw register access
+    bool writeRegister(uint8_t reg, uint8_t value);
+    bool readRegisters(uint8_t reg, uint8_t *buffer, uint8_t length);
+    
+private:
+    uint8_t address;
+    MPU6050AccelRange accelRange;
+    uint16_t sampleRate;
+    
+    static int16_t toInt16(const uint8_t *bytes) {
+        return (int16_t)((uint16_t)bytes[0] << 8 | bytes[1]);
+    }
+};
+
+#endif // MPU6050_DRIVER_H
@@ -0,0 +1,143 @@
+#include "orientation_filter.h"
+#include "constexpr_math.h"
+#include "waveforms.h"
+
+// Gyro counts -> angle: 131 counts per deg/s at +/-250 deg/s, 2^32 per
+// turn. Per-count increment per microsecond, Q16.
+static constexpr uint32_t GYRO_STEP_Q16 =
+    constexprRound(4294967296.0 / (360.0 * 131.0 * 1000000.0) * 65536.0);
+
+// Longer gaps than this re-seed from the accelerometer (also keeps
+// dt * GYRO_STEP_Q16 inside 32 bits)
+static const unsigned long MAX_STEP_MICROS = 65535;
+
+// Counts are reduced to 1024 per g (as in the tilt test) before squaring
+static const uint8_t ACCEL_SHIFT = 4;
+static const uint32_t ONE_G_SQUARED = 1024UL * 1024UL;
+
+// Trust the accelerometer only while |a| is within 0.75 - 1.25 g
+static const uint32_t TRUSTED_MIN = ONE_G_SQUARED * 9 / 16;
+static const uint32_t TRUSTED_MAX = ONE_G_SQUARED * 25 / 16;
+
+// Below 0.5 g on Y/Z (pitch beyond ~60 degrees) accel roll is mostly noise
+static const uint32_t ROLL_MIN_YZ2 = ONE_G_SQUARED / 4;
+
+// atan(r) on [0, 1] as a binary angle:
+// r * pi/4 + r(1 - r)(0.2447 + 0.0663 r), within 0.0015 rad
+static const int32_t ATAN_C1 = 2552;    // 0.2447 * 65536 / 2pi
+static const int32_t ATAN_C2 = 692;     // 0.0663 * 65536 / 2pi
+
+// Signed arithmetic on wrapping angles without signed overflow
+static int32_t wrapAdd(int32_t a, int32_t b) {
+    return (int32_t)((uint32_t)a + (uint32_t)b);
+}
+
+static int32_t wrapDiff(int32_t a, int32_t b) {
+    return (int32_t)((uint32_t)a - (uint32_t)b);
+}
+
+// Bitwise integer square root
+static uint16_t isqrt32(uint32_t value) {
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)root;
+}
+
+OrientationFilter::OrientationFilter() {
+    reset();
+}
+
+void OrientationFilter::reset() {
+    pitchAngle = 0;
+    rollAngle = 0;
+    lastMicros = 0;
+    seeded = false;
+}
+
+int16_t OrientationFilter::atan2Fixed(int32_t y, int32_t x) {
+    // Inputs are reduced counts, well under 2^16, so r fits Q15 below
+    uint32_t ay = y < 0 ? -y : y;
+    uint32_t ax = x < 0 ? -x : x;
+    if (ax == 0 && ay == 0) {
+        return 0;
+    }
+
+    // First octant: r = small / large in Q15
+    bool steep = ay > ax;
+    int32_t r = steep ? (int32_t)((ax << 15) / ay) : (int32_t)((ay << 15) / ax);
+    int32_t t = (r * (32768 - r)) >> 15;
+    int32_t angle = (r >> 2) + ((t * (ATAN_C1 + ((ATAN_C2 * r) >> 15))) >> 15);
+
+    if (steep) {
+        angle = 16384 - angle;
+    }
+    if (x < 0) {
+        angle = 32768 - angle;
+    }
+    return (int16_t)(y < 0 ? -angle : angle);
+}
+
+int16_t OrientationFilter::accelPitch(int16_t x, int16_t y, int16_t z) {
+    int32_t xs = x >> ACCEL_SHIFT;
+    int32_t ys = y >> ACCEL_SHIFT;
+    int32_t zs = z >> ACCEL_SHIFT;
+    return atan2Fixed(-xs, isqrt32((uint32_t)(ys * ys) + (uint32_t)(zs * zs)));
+}
+
+int16_t OrientationFilter::accelRoll(int16_t y, int16_t z) {
+    return atan2Fixed(y >> ACCEL_SHIFT, z >> ACCEL_SHIFT);
+}
+
+void OrientationFilter::update(const MotionSample &sample, unsigned long timestampMicros) {
+    int32_t xs = sample.ax >> ACCEL_SHIFT;
+    int32_t ys = sample.ay >> ACCEL_SHIFT;
+    int32_t zs = sample.az >> ACCEL_SHIFT;
+    uint32_t yz2 = (uint32_t)(ys * ys) + (uint32_t)(zs * zs);
+    uint32_t magnitude2 = yz2 + (uint32_t)(xs * xs);
+
+    int32_t tiltPitch = (int32_t)atan2Fixed(-xs, isqrt32(yz2)) << 16;
+    int32_t tiltRoll = (int32_t)atan2Fixed(ys, zs) << 16;
+
+    unsigned long dt = timestampMicros - lastMicros;
+    lastMicros = timestampMicros;
+
+    if (!seeded || dt > MAX_STEP_MICROS) {
+        pitchAngle = tiltPitch;
+        rollAngle = tiltRoll;
+        seeded = true;
+        return;
+    }
+
+    // Gyro: angle step per count for this dt (~1821 at 50 Hz)
+    int32_t step = (int32_t)((dt * GYRO_STEP_Q16) >> 16);
+
+    // Pitch rate in the rolled frame: gy cos(roll) - gz sin(roll), Q7 from the sine table
+    uint8_t phase = (uint8_t)((uint32_t)rollAngle >> 24);
+    int32_t sinRoll = (int32_t)waveSine8(phase) - 128;
+    int32_t cosRoll = (int32_t)waveSine8(phase + 64) - 128;
+    int32_t pitchRate = ((int32_t)sample.gy * cosRoll - (int32_t)sample.gz * sinRoll) >> 7;
+
+    pitchAngle = wrapAdd(pitchAngle, pitchRate * step);
+    rollAngle = wrapAdd(rollAngle, (int32_t)sample.gx * step);
+
+    // Accelerometer: pull toward the tilt only while it measures gravity
+    if (magnitude2 < TRUSTED_MIN || magnitude2 > TRUSTED_MAX) {
+        return;
+    }
+    pitchAngle = wrapAdd(pitchAngle, wrapDiff(tiltPitch, pitchAngle) >> FUSION_ACCEL_SHIFT);
+    if (yz2 >= ROLL_MIN_YZ2) {
+        rollAngle = wrapAdd(rollAngle, wrapDiff(tiltRoll, rollAngle) >> FUSION_ACCEL_SHIFT);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef ORIENTATION_FILTER_H
+#define ORIENTATION_FILTER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "mpu6050_driver.h"
+
+// ===== Fixed-Point Orientation =====
+// Complementary filter: pitch and roll follow the integrated gyro rate
+// every sample and are pulled toward the accelerometer tilt by
+// 1 / 2^FUSION_ACCEL_SHIFT of the difference. The accelerometer pull is
+// skipped while |a| is far from 1 g, so a fast push does not drag the
+// estimate. Integer only; no trig, one divide per atan2.
+//
+// Angles are binary: 65536 per turn (ORIENTATION_UNITS_PER_DEG per degree),
+// so wrap-around is free. Assumes the +/-250 deg/s gyro range.
+
+#define ORIENTATION_UNITS_PER_DEG (65536.0 / 360.0)
+
+// Degrees -> binary angle, for thresholds in constant expressions
+constexpr int16_t orientationFromDegrees(double degrees) {
+    return (int16_t)(degrees * ORIENTATION_UNITS_PER_DEG + (degrees < 0 ? -0.5 : 0.5));
+}
+
+class OrientationFilter {
+public:
+    OrientationFilter();
+
+    // Forget the estimate; the next update seeds it from the accelerometer
+    void reset();
+
+    // Fold in one raw sample taken at `timestampMicros`
+    void update(const MotionSample &sample, unsigned long timestampMicros);
+
+    // Binary angles, 65536 per turn. Pitch > 0 with the fingers raised
+    // (same sign as MotionDetector::calculatePitch()).
+    int16_t pitch() const { return (int16_t)(pitchAngle >> 16); }
+    int16_t roll() const { return (int16_t)(rollAngle >> 16); }
+
+    // Accelerometer-only tilt, binary angles
+    static int16_t accelPitch(int16_t x, int16_t y, int16_t z);
+    static int16_t accelRoll(int16_t y, int16_t z);
+
+    // atan2(y, x) as a binary angle, within ~0.1 degree
+    static int16_t atan2Fixed(int32_t y, int32_t x);
+
+private:
+    // Full-resolution angles, 2^32 per turn
+    int32_t pitchAngle;
+    int32_t rollAngle;
+    unsigned long lastMicros;
+    bool seeded;
+};
+
+#endif // ORIENTATION_FILTER_H
@@ -0,0 +1,37 @@
+#include "power.h"
+#include <avr/sleep.h>
+
+static volatile uint8_t wakeInterrupt;
+
+static void onWake() {
+    // A level interrupt keeps firing while the pin is low. Clearing SE
+    // also covers a wake-up that lands before sleep_cpu(): the sleep
+    // instruction then does nothing.
+    sleep_disable();
+    detachInterrupt(wakeInterrupt);
+}
+
+void powerDownUntilLow(uint8_t pin) {
+    wakeInterrupt = digitalPinToInterrupt(pin);
+    
+    #ifdef __AVR__
+    uint8_t adc = ADCSRA;
+    ADCSRA = 0;
+    #endif
+    
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    noInterrupts();
+    attachInterrupt(wakeInterrupt, onWake, LOW);
+    sleep_enable();
+    #ifdef __AVR__
+    sleep_bod_disable();
+    #endif
+    // The instruction after SEI always runs before a pending interrupt
+    interrupts();
+    sleep_cpu();
+    sleep_disable();
+    
+    #ifdef __AVR__
+    ADCSRA = adc;
+    #endif
+}
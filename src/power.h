@@ -0,0 +1,13 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+
+// Power-down sleep until an external interrupt pin (2 or 3) is held low.
+// Only INT0/INT1 low levels (and pin changes) wake an ATmega328 from
+// power-down: every clock stops, so millis()/micros() stand still until
+// the wake-up. The ADC and the brown-out detector are off while asleep.
+// Returns with the pin's interrupt detached.
+void powerDownUntilLow(uint8_t pin);
+
+#endif // POWER_H
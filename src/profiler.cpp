@@ -0,0 +1,153 @@
+#include "profiler.h"
+
+#if PROFILER && TRACE_CAPTURE
+    #error "PROFILER dumps text over Serial, which would corrupt the binary trace"
+#endif
+
+// Nothing here is built without PROFILER: the macros compile to nothing
+// and the stats would only take SRAM
+#if PROFILER
+#ifdef __AVR__
+#include <avr/interrupt.h>
+#else
+#include <chrono>
+#endif
+
+static const char *const SECTION_NAMES[PROF_SECTIONS] = {
+    "sensor read", "pitch", "animation", "show", "serial"
+};
+
+#ifdef __AVR__
+static const char TICK_UNIT[] = " cycles";
+
+#if defined(LED_TYPE_F5) && !defined(F5_BAM)
+    #error "PROFILER takes over Timer1, which drives F5 LED pin 9; profile a FastLED or F5_BAM build"
+#endif
+
+static volatile uint16_t timer1Overflows = 0;
+
+ISR(TIMER1_OVF_vect) {
+    timer1Overflows++;
+}
+
+uint32_t Profiler::now() {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t low = TCNT1;
+    uint16_t high = timer1Overflows;
+    // Wrapped since the last overflow interrupt, which is still pending
+    if ((TIFR1 & _BV(TOV1)) && low < 0x8000) {
+        high++;
+    }
+    SREG = sreg;
+    return (uint32_t)high << 16 | low;
+}
+#else
+static const char TICK_UNIT[] = " ns";
+
+uint32_t Profiler::now() {
+    // 1000 * 2^32 is a multiple of 2^32, so the 32-bit micros() wrap
+    // leaves the sum continuous
+    uint64_t hostNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return (uint32_t)(hostNs + (uint64_t)micros() * 1000);
+}
+#endif
+
+Profiler profiler;
+
+Profiler::Profiler() : overhead(0) {
+    reset();
+}
+
+void Profiler::begin() {
+    #ifdef __AVR__
+    // Normal mode, no prescaler, compare outputs off
+    noInterrupts();
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);
+    TCNT1 = 0;
+    TIFR1 = _BV(TOV1);
+    TIMSK1 = _BV(TOIE1);
+    interrupts();
+    #endif
+
+    // Cheapest of a few back-to-back reads
+    overhead = 0xFFFFFFFFUL;
+    for (uint8_t i = 0; i < 8; i++) {
+        uint32_t start = now();
+        uint32_t elapsed = now() - start;
+        if (elapsed < overhead) {
+            overhead = elapsed;
+        }
+    }
+    reset();
+}
+
+void Profiler::record(uint8_t section, uint32_t start) {
+    uint32_t elapsed = now() - start;
+    elapsed = elapsed > overhead ? elapsed - overhead : 0;
+
+    ProfileStats &s = stats[section];
+    s.calls++;
+    s.totalTicks += elapsed;
+    if (elapsed < s.minTicks) {
+        s.minTicks = elapsed;
+    }
+    if (elapsed > s.maxTicks) {
+        s.maxTicks = elapsed;
+    }
+}
+
+uint32_t Profiler::getMeanTicks(uint8_t section) const {
+    const ProfileStats &s = stats[section];
+    return s.calls ? (uint32_t)(s.totalTicks / s.calls) : 0;
+}
+
+const char *Profiler::sectionName(uint8_t section) {
+    return section < PROF_SECTIONS ? SECTION_NAMES[section] : "?";
+}
+
+void Profiler::reset() {
+    for (uint8_t i = 0; i < PROF_SECTIONS; i++) {
+        stats[i].calls = 0;
+        stats[i].minTicks = 0xFFFFFFFFUL;
+        stats[i].maxTicks = 0;
+        stats[i].totalTicks = 0;
+    }
+}
+
+void Profiler::dump() const {
+    Serial.print("profile: overhead=");
+    Serial.print((unsigned long)overhead);
+    Serial.println(TICK_UNIT);
+    for (uint8_t i = 0; i < PROF_SECTIONS; i++) {
+        const ProfileStats &s = stats[i];
+        Serial.print(SECTION_NAMES[i]);
+        Serial.print(": calls=");
+        Serial.print((unsigned long)s.calls);
+        if (s.calls > 0) {
+            Serial.print(" min=");
+            Serial.print((unsigned long)s.minTicks);
+            Serial.print(" mean=");
+            Serial.print((unsigned long)getMeanTicks(i));
+            Serial.print(" max=");
+            Serial.print((unsigned long)s.maxTicks);
+            Serial.print(TICK_UNIT);
+            Serial.print(" (max ");
+            Serial.print((unsigned long)(s.maxTicks / TICKS_PER_US));
+            Serial.print(" us)");
+        }
+        Serial.println();
+    }
+}
+
+void Profiler::pollCommand() {
+    while (Serial.available() > 0) {
+        if (Serial.read() == PROFILER_DUMP_COMMAND) {
+            dump();
+            reset();
+        }
+    }
+}
+#endif // PROFILER
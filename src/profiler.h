@@ -0,0 +1,94 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ===== Section Profiler =====
+// Min / mean / max cost of named sections of the main loop, read from a
+// free-running counter:
+//   AVR   Timer1 at F_CPU (one tick per CPU cycle), widened to 32 bits by
+//         its overflow interrupt. Timer1 is then no longer available for
+//         PWM on pins 9 and 10.
+//   host  nanoseconds: the host CPU time of the section plus any virtual
+//         time it waited (delay(), a full UART), so blocking code shows up
+//         in native builds too.
+// The cost of reading the counter is measured in begin() and subtracted.
+// Sections nest and are inclusive: PROF_ANIMATION contains PROF_SHOW.
+//
+// With PROFILER off the macros compile to nothing and profiler.cpp is
+// empty, so only PROFILER builds may use the class.
+
+enum ProfileSection : uint8_t {
+    PROF_SENSOR_READ,     // I2C burst from the MPU6050
+    PROF_PITCH,           // Tilt test, or the orientation filter update
+    PROF_ANIMATION,       // One rendered frame, show() included
+    PROF_SHOW,            // Pushing the frame to the LEDs
+    PROF_SERIAL,          // DEBUG stats text, telemetry drain
+    PROF_SECTIONS
+};
+
+struct ProfileStats {
+    uint32_t calls;
+    uint32_t minTicks;
+    uint32_t maxTicks;
+    uint64_t totalTicks;
+};
+
+class Profiler {
+public:
+    #ifdef __AVR__
+    static const uint16_t TICKS_PER_US = F_CPU / 1000000UL;
+    #else
+    static const uint16_t TICKS_PER_US = 1000;
+    #endif
+
+    Profiler();
+
+    // Start the counter and measure its read overhead
+    void begin();
+
+    // Current counter value; differences wrap correctly
+    static uint32_t now();
+
+    // Account one run of `section` that started at `start`
+    void record(uint8_t section, uint32_t start);
+
+    const ProfileStats &getStats(uint8_t section) const { return stats[section]; }
+    uint32_t getMeanTicks(uint8_t section) const;
+    uint32_t getOverheadTicks() const { return overhead; }
+    static const char *sectionName(uint8_t section);
+
+    void reset();
+
+    // Print one line per section over Serial
+    void dump() const;
+
+    // Handle PROFILER_DUMP_COMMAND (dump, then reset) from Serial
+    void pollCommand();
+
+private:
+    ProfileStats stats[PROF_SECTIONS];
+    uint32_t overhead;
+};
+
+#if PROFILER
+extern Profiler profiler;
+
+// Records the rest of the enclosing scope
+class ProfileScope {
+public:
+    explicit ProfileScope(uint8_t section) : section(section), start(Profiler::now()) {}
+    ~ProfileScope() { profiler.record(section, start); }
+
+private:
+    uint8_t section;
+    uint32_t start;
+};
+
+    #define PROFILE_SECTION(section) ProfileScope profileScope_(section)
+#else
+    #define PROFILE_SECTION(section)
+#endif
+
+#endif // PROFILER_H
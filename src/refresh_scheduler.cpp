@@ -0,0 +1,46 @@
+#include "refresh_scheduler.h"
+#include "config.h"
+
+RefreshScheduler::RefreshScheduler(const TaskScheduler &tasks)
+    : tasks(tasks), numProtected(0), pending(false), pendingSince(0) {
+    resetStats();
+}
+
+void RefreshScheduler::protect(int8_t id) {
+    if (id >= 0 && numProtected < MAX_PROTECTED) {
+        protectedIds[numProtected++] = id;
+    }
+}
+
+bool RefreshScheduler::admit(unsigned long costUs) {
+    unsigned long needed = costUs + REFRESH_GUARD_US;
+    for (uint8_t i = 0; i < numProtected; i++) {
+        if (tasks.timeUntil(protectedIds[i]) < needed) {
+            if (!pending) {
+                pending = true;
+                pendingSince = micros();
+                stats.deferred++;
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+void RefreshScheduler::committed() {
+    stats.committed++;
+    if (pending) {
+        pending = false;
+        unsigned long delay = micros() - pendingSince;
+        if (delay > stats.maxDelay) {
+            stats.maxDelay = delay;
+        }
+    }
+}
+
+void RefreshScheduler::resetStats() {
+    stats.committed = 0;
+    stats.deferred = 0;
+    stats.missed = 0;
+    stats.maxDelay = 0;
+}
@@ -0,0 +1,56 @@
+#ifndef REFRESH_SCHEDULER_H
+#define REFRESH_SCHEDULER_H
+
+#include <Arduino.h>
+#include "task_scheduler.h"
+
+// Refresh counters since the last resetStats()
+struct RefreshStats {
+    unsigned long committed;    // Refreshes sent
+    unsigned long deferred;     // Frames held back for a later slot
+    unsigned long missed;       // Held frames replaced before they went out
+    unsigned long maxDelay;     // Worst hold, first deferral to refresh (us)
+};
+
+// Places LED strip refreshes around time-critical tasks.
+// A WS2812 refresh keeps interrupts off for its whole length (about
+// 30 us per LED), so a sensor read or UART drain due inside it starts
+// late. A backend asks admit() before each refresh. If the refresh
+// would still be running when a protected task is released, the frame
+// is held and the backend's showDeferred() retries it, from the end of
+// each protected task, which is the longest gap before its next release.
+class RefreshScheduler {
+public:
+    static const uint8_t MAX_PROTECTED = TaskScheduler::MAX_TASKS;
+
+    explicit RefreshScheduler(const TaskScheduler &tasks);
+
+    // Keep refreshes clear of task `id` (ignores -1 from a full table)
+    void protect(int8_t id);
+
+    // True if a refresh of `costUs` can start now. Otherwise the frame
+    // is held and counted as deferred.
+    bool admit(unsigned long costUs);
+
+    // The admitted refresh has gone out
+    void committed();
+
+    // A new frame replaced the held one
+    void missed() { stats.missed++; }
+
+    bool isPending() const { return pending; }
+
+    const RefreshStats &getStats() const { return stats; }
+    void resetStats();
+
+private:
+    const TaskScheduler &tasks;
+    uint8_t protectedIds[MAX_PROTECTED];
+    uint8_t numProtected;
+
+    bool pending;
+    unsigned long pendingSince;
+    RefreshStats stats;
+};
+
+#endif // REFRESH_SCHEDULER_H
@@ -0,0 +1,190 @@
+#include "task_scheduler.h"
+#include "config.h"
+#include <avr/sleep.h>
+
+TaskScheduler::TaskScheduler()
+    : numTasks(0), idleMicros(0), statsStart(0), droppedPosts(0) {
+}
+
+int8_t TaskScheduler::addTask(const char *name, TaskCallback callback, unsigned long periodUs) {
+    if (numTasks >= MAX_TASKS) {
+        return -1;
+    }
+    
+    Task &task = tasks[numTasks];
+    task.name = name;
+    task.callback = callback;
+    task.period = periodUs;
+    task.nextRelease = micros();
+    task.stats = TaskStats();
+    
+    return numTasks++;
+}
+
+void TaskScheduler::setPeriod(uint8_t id, unsigned long periodUs) {
+    if (id >= numTasks) {
+        return;
+    }
+    Task &task = tasks[id];
+    if ((task.period == 0) != (periodUs == 0)) {
+        // Joining or leaving the grid
+        task.nextRelease = micros();
+    }
+    task.period = periodUs;
+}
+
+unsigned long TaskScheduler::timeUntil(uint8_t id) const {
+    if (tasks[id].period == 0) {
+        return 0xFFFFFFFFUL;
+    }
+    long remaining = (long)(tasks[id].nextRelease - micros());
+    return remaining > 0 ? remaining : 0;
+}
+
+unsigned long TaskScheduler::runTask(Task &task, unsigned long due) {
+    unsigned long start = micros();
+    unsigned long lateness = start - due;
+    task.callback();
+    unsigned long end = micros();
+    
+    TaskStats &stats = task.stats;
+    stats.runs++;
+    if (lateness > stats.maxLateness) stats.maxLateness = lateness;
+    if (end - start > stats.maxRunTime) stats.maxRunTime = end - start;
+    return end;
+}
+
+void TaskScheduler::run() {
+    // Posted releases first, but only those already queued: an interrupt
+    // posting faster than its task runs can't starve the grid. A task
+    // posted several times runs once; the extra posts count as overruns.
+    TaskPost release;
+    uint8_t ran = 0;
+    for (uint8_t n = posted.count(); n > 0 && posted.pop(release); n--) {
+        if (release.task >= numTasks) {
+            continue;
+        }
+        if (ran & (1 << release.task)) {
+            tasks[release.task].stats.overruns++;
+            continue;
+        }
+        ran |= 1 << release.task;
+        runTask(tasks[release.task], release.at);
+    }
+    droppedPosts += posted.takeOverflows();
+    
+    for (uint8_t i = 0; i < numTasks; i++) {
+        Task &task = tasks[i];
+        
+        // Signed difference keeps this correct across micros() wrap
+        if (task.period == 0 || (long)(micros() - task.nextRelease) < 0) {
+            continue;
+        }
+        
+        // Advance first, so timeUntil() inside the callback already
+        // refers to the next release
+        unsigned long due = task.nextRelease;
+        task.nextRelease += task.period;
+        unsigned long end = runTask(task, due);
+        
+        // Stay on the release grid; releases that already passed are
+        // dropped and counted rather than run back-to-back
+        if (task.period != 0 && (long)(end - task.nextRelease) >= 0) {
+            unsigned long missed = (end - task.nextRelease) / task.period + 1;
+            task.stats.overruns += missed;
+            task.nextRelease += missed * task.period;
+        }
+    }
+    
+    if (numTasks == 0) {
+        return;
+    }
+    
+    // Sleep until the earliest release (or, with only posted tasks, until
+    // the next post)
+    unsigned long now = micros();
+    unsigned long wakeTime = now + 0x7FFFFFFFUL;
+    for (uint8_t i = 0; i < numTasks; i++) {
+        if (tasks[i].period != 0 && (long)(tasks[i].nextRelease - wakeTime) < 0) {
+            wakeTime = tasks[i].nextRelease;
+        }
+    }
+    
+    if ((long)(wakeTime - now) > 0 && posted.isEmpty()) {
+        idleUntil(wakeTime);
+        idleMicros += micros() - now;
+    }
+}
+
+void TaskScheduler::idleUntil(unsigned long wakeTime) {
+    // Idle sleep keeps timers, TWI, UART and pin interrupts running, and
+    // the Timer0 overflow wakes the CPU every 1024 us. A post() from an
+    // interrupt ends the idle at once: interrupts stay off from the check
+    // to the sleep instruction, which runs before any pending interrupt
+    // does (SEI takes effect one instruction late).
+    //
+    // Within one overflow of the release, the next overflow may come
+    // after it; that stretch is waited out awake in short steps, so the
+    // release starts on time and a post() still ends it within a step.
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    for (;;) {
+        noInterrupts();
+        long remaining = (long)(wakeTime - micros());
+        if (remaining <= 0 || !posted.isEmpty()) {
+            interrupts();
+            return;
+        }
+        if (remaining < (long)IDLE_WAKE_PERIOD_US) {
+            interrupts();
+            delayMicroseconds(remaining < IDLE_SPIN_STEP_US ? remaining : IDLE_SPIN_STEP_US);
+            continue;
+        }
+        sleep_enable();
+        interrupts();
+        sleep_cpu();
+        sleep_disable();
+    }
+}
+
+uint8_t TaskScheduler::getIdlePercent() const {
+    unsigned long hundredth = (micros() - statsStart) / 100;
+    if (hundredth == 0) {
+        return 0;
+    }
+    return (uint8_t)(idleMicros / hundredth);
+}
+
+void TaskScheduler::resetStats() {
+    for (uint8_t i = 0; i < numTasks; i++) {
+        tasks[i].stats = TaskStats();
+    }
+    idleMicros = 0;
+    droppedPosts = 0;
+    statsStart = micros();
+}
+
+void TaskScheduler::printStats() const {
+    #if DEBUG
+    for (uint8_t i = 0; i < numTasks; i++) {
+        const TaskStats &stats = tasks[i].stats;
+        DEBUG_PRINT(tasks[i].name);
+        DEBUG_PRINT(": runs=");
+        DEBUG_PRINT(stats.runs);
+        DEBUG_PRINT(" overruns=");
+        DEBUG_PRINT(stats.overruns);
+        DEBUG_PRINT(" late<=");
+        DEBUG_PRINT(stats.maxLateness);
+        DEBUG_PRINT("us run<=");
+        DEBUG_PRINT(stats.maxRunTime);
+        DEBUG_PRINTLN("us");
+    }
+    DEBUG_PRINT("idle: ");
+    DEBUG_PRINT(getIdlePercent());
+    DEBUG_PRINT("%");
+    if (droppedPosts) {
+        DEBUG_PRINT(" dropped posts=");
+        DEBUG_PRINT(droppedPosts);
+    }
+    DEBUG_PRINTLN("");
+    #endif
+}
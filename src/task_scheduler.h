@@ -0,0 +1,107 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <Arduino.h>
+#include "event_queue.h"
+
+typedef void (*TaskCallback)();
+
+// Per-task timing statistics (microseconds)
+struct TaskStats {
+    unsigned long runs;
+    unsigned long overruns;      // Releases missed because the task ran late
+    unsigned long maxLateness;   // Worst start delay past the deadline
+    unsigned long maxRunTime;    // Worst execution time
+};
+
+// Deadline-based cooperative scheduler.
+// Each task is released every `period` microseconds on a fixed grid; the
+// deadline for one release is the start of the next. Between releases
+// the CPU idle-sleeps instead of busy-waiting in delay(), up to the last
+// Timer0 overflow before the next release.
+//
+// A task can also be released by an interrupt: post() queues the release
+// on a lock-free EventQueue and ends the idle at once. Tasks added with
+// period 0 run only when posted. Lateness for a posted release counts
+// from the post().
+class TaskScheduler {
+public:
+    static const uint8_t MAX_TASKS = 5;
+    static const uint8_t MAX_POSTED = 8;    // Power of two
+    
+    // Idle sleep wakes at least this often (the Timer0 overflow); closer
+    // to a release than that, run() waits awake in steps of IDLE_SPIN_STEP_US
+    static const uint16_t IDLE_WAKE_PERIOD_US = 1024;
+    static const uint8_t IDLE_SPIN_STEP_US = 16;
+    
+    TaskScheduler();
+    
+    // Register a task; returns its id, or -1 if the table is full.
+    // Period 0: released only by post().
+    int8_t addTask(const char *name, TaskCallback callback, unsigned long periodUs);
+    
+    // Change a task's period; takes effect from its next release (from
+    // the one after, when called by the task itself)
+    void setPeriod(uint8_t id, unsigned long periodUs);
+    
+    // Release task `id` as soon as run() gets to it. For ISRs only (they
+    // are the queue's one producer). False if MAX_POSTED releases are
+    // already waiting; the release is dropped and counted.
+    bool post(uint8_t id) {
+        TaskPost release = { id, micros() };
+        return posted.push(release);
+    }
+    
+    // Run everything that is due, then idle until the next deadline.
+    // Call this as the whole body of loop().
+    void run();
+    
+    // Microseconds until task `id` is next released (0 if overdue; the
+    // longest possible wait for a task with period 0)
+    unsigned long timeUntil(uint8_t id) const;
+    
+    const TaskStats &getStats(uint8_t id) const { return tasks[id].stats; }
+    uint8_t getNumTasks() const { return numTasks; }
+    
+    // Share of time spent idle since the last resetStats() (0-100)
+    uint8_t getIdlePercent() const;
+    unsigned long getIdleMicros() const { return idleMicros; }
+    
+    // Posts dropped on a full queue since the last resetStats()
+    unsigned long getDroppedPosts() const { return droppedPosts; }
+    
+    void resetStats();
+    
+    // Dump per-task stats and idle share over DEBUG_PRINT
+    void printStats() const;
+    
+private:
+    struct Task {
+        const char *name;
+        TaskCallback callback;
+        unsigned long period;
+        unsigned long nextRelease;
+        TaskStats stats;
+    };
+    
+    struct TaskPost {
+        uint8_t task;
+        unsigned long at;   // micros() of the post
+    };
+    
+    Task tasks[MAX_TASKS];
+    uint8_t numTasks;
+    EventQueue<TaskPost, MAX_POSTED> posted;
+    
+    unsigned long idleMicros;
+    unsigned long statsStart;
+    unsigned long droppedPosts;
+    
+    // Run one release that became due at `due`; returns the end time
+    unsigned long runTask(Task &task, unsigned long due);
+    
+    // Sleep until `wakeTime` or a post(), whichever comes first
+    void idleUntil(unsigned long wakeTime);
+};
+
+#endif // TASK_SCHEDULER_H
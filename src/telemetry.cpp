@@ -0,0 +1,289 @@
+#include "telemetry.h"
+#include <string.h>
+
+static_assert((TELEMETRY_BUFFER_SIZE & (TELEMETRY_BUFFER_SIZE - 1)) == 0 &&
+              TELEMETRY_BUFFER_SIZE <= 256 && TELEMETRY_BUFFER_SIZE > 2 * TELEMETRY_MAX_FRAME,
+              "TELEMETRY_BUFFER_SIZE must be a power of two, at most 256, "
+              "holding two frames");
+
+static const uint8_t PAYLOAD_SIZES[] = {
+    0xFF,   // 0: unused, so a zeroed frame never decodes
+    9,      // TELEM_SAMPLE
+    2,      // TELEM_GESTURE
+    0,      // TELEM_FIFO_OVERFLOW
+    2,      // TELEM_DROPPED
+    8,      // TELEM_TASK_STATS
+    4,      // TELEM_WAKE
+    5,      // TELEM_SAMPLING
+    6,      // TELEM_SAMPLING_STATS
+};
+
+uint8_t telemetryPayloadSize(uint8_t type) {
+    return type < sizeof(PAYLOAD_SIZES) ? PAYLOAD_SIZES[type] : 0xFF;
+}
+
+static void putInt16(uint8_t *out, int16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)((uint16_t)value >> 8);
+}
+
+static uint16_t saturate16(unsigned long value) {
+    return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+}
+
+// COBS: every zero becomes the distance to the next one, so the encoded
+// frame has no zeros at all. Records are far below 254 bytes, so there
+// is exactly one extra (leading) byte. Returns the encoded size.
+static uint8_t cobsEncode(const uint8_t *in, uint8_t length, uint8_t *out) {
+    uint8_t code = 0;       // Index of the pending distance byte
+    uint8_t n = 1;
+    for (uint8_t i = 0; i < length; i++) {
+        if (in[i] == 0) {
+            out[code] = n - code;
+            code = n++;
+        } else {
+            out[n++] = in[i];
+        }
+    }
+    out[code] = n - code;
+    return n;
+}
+
+// Returns the decoded size, 0 if the encoding is invalid
+static uint8_t cobsDecode(const uint8_t *in, uint8_t length, uint8_t *out) {
+    uint8_t n = 0;
+    uint8_t i = 0;
+    while (i < length) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > length) {
+            return 0;
+        }
+        for (uint8_t k = 1; k < code; k++) {
+            out[n++] = in[i++];
+        }
+        if (i < length) {
+            out[n++] = 0;
+        }
+    }
+    return n;
+}
+
+// ===== Firmware side =====
+
+#if TELEMETRY
+Telemetry telemetry;
+#endif
+
+Telemetry::Telemetry() {
+    reset();
+}
+
+void Telemetry::reset() {
+    head = 0;
+    tail = 0;
+    seq = 0;
+    unreported = 0;
+    dropped = 0;
+}
+
+bool Telemetry::push(uint8_t type, const uint8_t *payload, uint8_t length,
+                     unsigned long timestamp, uint8_t recordSeq, uint8_t reserve) {
+    uint8_t record[TELEMETRY_MAX_RECORD];
+    record[0] = type;
+    record[1] = recordSeq;
+    record[2] = (uint8_t)timestamp;
+    record[3] = (uint8_t)(timestamp >> 8);
+    record[4] = (uint8_t)(timestamp >> 16);
+    record[5] = (uint8_t)(timestamp >> 24);
+    if (length > 0) {
+        memcpy(record + 6, payload, length);
+    }
+
+    uint8_t sum = 0;
+    for (uint8_t i = 0; i < length + 6; i++) {
+        sum += record[i];
+    }
+    record[length + 6] = sum;
+
+    // Encoded between the two delimiters
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    frame[0] = 0;
+    uint8_t size = cobsEncode(record, length + 7, frame + 1) + 1;
+    frame[size++] = 0;
+
+    // One slot stays empty so head == tail means empty
+    if (size + reserve > TELEMETRY_BUFFER_SIZE - 1 - pending()) {
+        return false;
+    }
+    for (uint8_t i = 0; i < size; i++) {
+        buffer[head] = frame[i];
+        head = (head + 1) & (TELEMETRY_BUFFER_SIZE - 1);
+    }
+    return true;
+}
+
+bool Telemetry::log(uint8_t type, const uint8_t *payload, uint8_t length,
+                    unsigned long timestamp) {
+    // Report earlier losses first so the host sees them in order. The
+    // report only takes a seq number once it is queued, so seq gaps
+    // count dropped records alone. It also waits for room for a record
+    // behind it, or a saturated link would carry nothing but reports.
+    if (unreported > 0) {
+        uint8_t count[2];
+        putInt16(count, (int16_t)unreported);
+        if (push(TELEM_DROPPED, count, sizeof(count), timestamp, seq, TELEMETRY_MAX_FRAME)) {
+            seq++;
+            unreported = 0;
+        }
+    }
+
+    uint8_t recordSeq = seq++;
+    if (unreported > 0 || !push(type, payload, length, timestamp, recordSeq, 0)) {
+        if (unreported < 0xFFFF) {
+            unreported++;
+        }
+        dropped++;
+        return false;
+    }
+    return true;
+}
+
+void Telemetry::logSample(unsigned long timestamp, int16_t ax, int16_t ay, int16_t az,
+                          int16_t pitch, uint8_t flags) {
+    uint8_t payload[9];
+    putInt16(payload, ax);
+    putInt16(payload + 2, ay);
+    putInt16(payload + 4, az);
+    putInt16(payload + 6, pitch);
+    payload[8] = flags;
+    log(TELEM_SAMPLE, payload, sizeof(payload), timestamp);
+}
+
+void Telemetry::logGesture(uint8_t gesture, uint8_t confidence) {
+    uint8_t payload[2] = { gesture, confidence };
+    log(TELEM_GESTURE, payload, sizeof(payload), millis());
+}
+
+void Telemetry::logEvent(uint8_t type) {
+    log(type, nullptr, 0, millis());
+}
+
+void Telemetry::logTaskStats(uint8_t task, uint8_t idlePercent, unsigned long overruns,
+                             unsigned long maxLateness, unsigned long maxRunTime) {
+    uint8_t payload[8];
+    payload[0] = task;
+    payload[1] = idlePercent;
+    putInt16(payload + 2, (int16_t)saturate16(overruns));
+    putInt16(payload + 4, (int16_t)saturate16(maxLateness));
+    putInt16(payload + 6, (int16_t)saturate16(maxRunTime));
+    log(TELEM_TASK_STATS, payload, sizeof(payload), millis());
+}
+
+void Telemetry::logWake(unsigned long latency, unsigned long wakes) {
+    uint8_t payload[4];
+    putInt16(payload, (int16_t)saturate16(latency));
+    putInt16(payload + 2, (int16_t)saturate16(wakes));
+    log(TELEM_WAKE, payload, sizeof(payload), millis());
+}
+
+void Telemetry::logSamplingSwitch(uint8_t profile, uint16_t rate, uint32_t variance) {
+    uint8_t payload[5];
+    payload[0] = profile;
+    putInt16(payload + 1, (int16_t)rate);
+    putInt16(payload + 3, (int16_t)saturate16(variance));
+    log(TELEM_SAMPLING, payload, sizeof(payload), millis());
+}
+
+void Telemetry::logSamplingStats(uint16_t averageRate, unsigned long busyMicros,
+                                 unsigned long switches) {
+    uint8_t payload[6];
+    putInt16(payload, (int16_t)averageRate);
+    putInt16(payload + 2, (int16_t)saturate16(busyMicros));
+    putInt16(payload + 4, (int16_t)saturate16(switches));
+    log(TELEM_SAMPLING_STATS, payload, sizeof(payload), millis());
+}
+
+void Telemetry::flush() {
+    while (tail != head) {
+        uint8_t run = head > tail ? head - tail : TELEMETRY_BUFFER_SIZE - tail;
+        Serial.write(buffer + tail, run);
+        tail = (tail + run) & (TELEMETRY_BUFFER_SIZE - 1);
+    }
+    Serial.flush();
+}
+
+void Telemetry::drain() {
+    int room = Serial.availableForWrite();
+    while (room > 0 && tail != head) {
+        // Contiguous run up to the write position or the end of the ring
+        uint8_t run = head > tail ? head - tail : TELEMETRY_BUFFER_SIZE - tail;
+        if (run > room) {
+            run = (uint8_t)room;
+        }
+        Serial.write(buffer + tail, run);
+        tail = (tail + run) & (TELEMETRY_BUFFER_SIZE - 1);
+        room -= run;
+    }
+}
+
+// ===== Host decoder =====
+
+TelemetryDecoder::TelemetryDecoder()
+    : length(0), overlong(false), synced(false), nextSeq(0), records(0), badFrames(0), lost(0) {
+}
+
+bool TelemetryDecoder::push(uint8_t byte, TelemetryRecord &record) {
+    if (byte != 0) {
+        if (length < sizeof(frame)) {
+            frame[length++] = byte;
+        } else {
+            overlong = true;
+        }
+        return false;
+    }
+
+    // Delimiter: empty frames are just back-to-back delimiters
+    bool complete = false;
+    if (overlong) {
+        badFrames++;
+    } else if (length > 0) {
+        complete = decodeFrame(record);
+        if (!complete) {
+            badFrames++;
+        }
+    }
+    length = 0;
+    overlong = false;
+    return complete;
+}
+
+bool TelemetryDecoder::decodeFrame(TelemetryRecord &record) {
+    uint8_t raw[TELEMETRY_MAX_RECORD + 1];
+    uint8_t size = cobsDecode(frame, length, raw);
+    if (size < 7 || telemetryPayloadSize(raw[0]) != size - 7) {
+        return false;
+    }
+
+    uint8_t sum = 0;
+    for (uint8_t i = 0; i < size - 1; i++) {
+        sum += raw[i];
+    }
+    if (sum != raw[size - 1]) {
+        return false;
+    }
+
+    record.type = raw[0];
+    record.seq = raw[1];
+    record.millis = (uint32_t)raw[2] | (uint32_t)raw[3] << 8 | (uint32_t)raw[4] << 16 |
+                    (uint32_t)raw[5] << 24;
+    record.length = size - 7;
+    memcpy(record.payload, raw + 6, record.length);
+
+    if (synced) {
+        lost += (uint8_t)(record.seq - nextSeq);
+    }
+    synced = true;
+    nextSeq = record.seq + 1;
+    records++;
+    return true;
+}
@@ -0,0 +1,139 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ===== Telemetry =====
+// Typed binary records for watching the hot path in production builds.
+// The log*() calls encode a record into a RAM ring buffer and return
+// straight away. drain(), which runs as its own scheduler task, copies only
+// as many bytes as the Serial TX buffer has room for, so neither side
+// ever waits on the UART. When the ring is full the record is dropped
+// and counted. Once there is room again, the count goes out in a
+// TELEM_DROPPED record.
+//
+// Frame (before COBS encoding):
+//   type, seq, millis (uint32 LE), payload, sum8 of all preceding bytes
+// seq goes up by one for every record offered, dropped or not, so gaps
+// on the host give the exact loss. Frames are COBS-encoded and have a
+// 0x00 on both sides. Other bytes on the port, such as DEBUG text, are
+// then thrown away as one bad frame and do not corrupt the next record.
+//
+// Single producer (main loop), single consumer (drain()); not ISR-safe.
+
+enum TelemetryType : uint8_t {
+    TELEM_SAMPLE = 1,         // int16 ax, ay, az, pitch; uint8 flags
+    TELEM_GESTURE = 2,        // uint8 gesture, confidence
+    TELEM_FIFO_OVERFLOW = 3,  // (no payload)
+    TELEM_DROPPED = 4,        // uint16 records dropped since the last report
+    TELEM_TASK_STATS = 5,     // uint8 task, idle %; uint16 overruns, max lateness, max run (us)
+    TELEM_WAKE = 6,           // uint16 wake-to-first-sample latency (us), wakes so far
+    TELEM_SAMPLING = 7,       // uint8 profile; uint16 rate (Hz), accel variance
+    TELEM_SAMPLING_STATS = 8, // uint16 average rate (Hz), sensor busy (us), profile switches
+};
+
+// TELEM_SAMPLE flags
+#define TELEM_FLAG_RAISED    0x01   // Tilt above ACTIVATION_ANGLE
+#define TELEM_FLAG_TRIGGERED 0x02   // Debounced rising edge (activation)
+
+// TELEM_SAMPLE pitch without ORIENTATION_FUSION
+#define TELEM_NO_PITCH ((int16_t)0x8000)
+
+#define TELEMETRY_MAX_PAYLOAD 9
+// type + seq + millis + payload + checksum
+#define TELEMETRY_MAX_RECORD (TELEMETRY_MAX_PAYLOAD + 7)
+// COBS adds one byte per 254, plus a delimiter on each side
+#define TELEMETRY_MAX_FRAME (TELEMETRY_MAX_RECORD + 3)
+
+// Payload size of each type, 0xFF for unknown types
+uint8_t telemetryPayloadSize(uint8_t type);
+
+class Telemetry {
+public:
+    Telemetry();
+
+    // Discard everything queued and restart seq and the drop counters
+    void reset();
+
+    // Queue one record; returns false (and counts it) if the ring is full
+    bool log(uint8_t type, const uint8_t *payload, uint8_t length, unsigned long timestamp);
+
+    void logSample(unsigned long timestamp, int16_t ax, int16_t ay, int16_t az, int16_t pitch,
+                   uint8_t flags);
+    void logGesture(uint8_t gesture, uint8_t confidence);
+    void logEvent(uint8_t type);
+    void logTaskStats(uint8_t task, uint8_t idlePercent, unsigned long overruns,
+                      unsigned long maxLateness, unsigned long maxRunTime);
+    void logWake(unsigned long latency, unsigned long wakes);
+    void logSamplingSwitch(uint8_t profile, uint16_t rate, uint32_t variance);
+    void logSamplingStats(uint16_t averageRate, unsigned long busyMicros, unsigned long switches);
+
+    // Move queued bytes into the Serial TX buffer without blocking
+    void drain();
+
+    // Send everything queued and wait until it is out, blocking. Only
+    // for use before the UART stops (power-down).
+    void flush();
+
+    uint8_t pending() const { return (head - tail) & (TELEMETRY_BUFFER_SIZE - 1); }
+    uint32_t getDropped() const { return dropped; }
+
+private:
+    uint8_t buffer[TELEMETRY_BUFFER_SIZE];
+    uint8_t head;               // Written by log()
+    uint8_t tail;               // Written by drain()
+    uint8_t seq;
+    uint16_t unreported;        // Drops not yet sent as TELEM_DROPPED
+    uint32_t dropped;           // Drops since reset()
+
+    // Queue one frame if it fits with `reserve` bytes to spare
+    bool push(uint8_t type, const uint8_t *payload, uint8_t length, unsigned long timestamp,
+              uint8_t recordSeq, uint8_t reserve);
+};
+
+#if TELEMETRY
+extern Telemetry telemetry;
+#endif
+
+// ===== Host decoder =====
+
+struct TelemetryRecord {
+    uint8_t type;
+    uint8_t seq;
+    uint32_t millis;
+    uint8_t length;
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+
+    int16_t int16At(uint8_t offset) const {
+        return (int16_t)(payload[offset] | payload[offset + 1] << 8);
+    }
+};
+
+class TelemetryDecoder {
+public:
+    TelemetryDecoder();
+
+    // Feed one byte from the stream; returns true when `record` holds a
+    // newly completed, checksummed record
+    bool push(uint8_t byte, TelemetryRecord &record);
+
+    uint32_t getRecords() const { return records; }
+    uint32_t getBadFrames() const { return badFrames; }
+    // Records missing from the seq sequence (dropped or corrupted)
+    uint32_t getLost() const { return lost; }
+
+private:
+    uint8_t frame[TELEMETRY_MAX_RECORD + 1];
+    uint8_t length;
+    bool overlong;
+    bool synced;
+    uint8_t nextSeq;
+    uint32_t records;
+    uint32_t badFrames;
+    uint32_t lost;
+
+    bool decodeFrame(TelemetryRecord &record);
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,153 @@
+#ifndef TIMER_PWM_FACADE_H
+#define TIMER_PWM_FACADE_H
+
+#include <avr/io.h>
+#include "led_backend.h"
+#include "color_math.h"
+#include "framebuffer.h"
+#include "config.h"
+
+// Direct timer-register PWM for F5 LEDs (ATmega328 / Nano).
+// begin() resolves each LED pin to its Timer0/1/2 output-compare register
+// once; show() then commits a frame with plain OCRxx stores instead of
+// one analogWrite() per pin. The timers keep the modes the Arduino core
+// set up (Timer0 fast PWM, Timers 1/2 phase-correct, all 8-bit).
+//
+// OCRxx is double-buffered by the hardware in PWM modes, so a new duty
+// cycle lands on the next PWM period boundary, never mid-period. Only
+// on/off transitions (connecting the pin to its timer) are immediate:
+// duty 0 disconnects the pin and leaves it at its PORT level (LOW),
+// because fast PWM with OCR = 0 still emits a one-tick pulse.
+class TimerPWMFacade : public LEDBackend<TimerPWMFacade, NUM_LEDS> {
+private:
+    // Output-compare channel for one pin
+    struct PwmChannel {
+        volatile uint8_t *ocr;      // Compare register (low byte for Timer1)
+        volatile uint8_t *tccr;     // Control register holding the COM bits
+        uint8_t comMask;            // COMxx1: non-inverting PWM on the pin
+    };
+    
+    PwmChannel channels[NUM_LEDS];
+    
+    FrameBuffer<ConfiguredPixelFormat, NUM_LEDS> frame;
+    uint8_t pinOutput[NUM_LEDS];
+    uint8_t globalBrightness;
+    bool dirty;
+    
+    uint32_t committedFrames;
+    uint32_t skippedFrames;
+    
+    // Arduino Nano pin -> compare channel
+    static bool resolveChannel(uint8_t pin, PwmChannel &channel) {
+        switch (pin) {
+            case 3:  channel = { &OCR2B,  &TCCR2A, _BV(COM2B1) }; return true;
+            case 5:  channel = { &OCR0B,  &TCCR0A, _BV(COM0B1) }; return true;
+            case 6:  channel = { &OCR0A,  &TCCR0A, _BV(COM0A1) }; return true;
+            case 9:  channel = { &OCR1AL, &TCCR1A, _BV(COM1A1) }; return true;
+            case 10: channel = { &OCR1BL, &TCCR1A, _BV(COM1B1) }; return true;
+            case 11: channel = { &OCR2A,  &TCCR2A, _BV(COM2A1) }; return true;
+            default: return false;
+        }
+    }
+    
+    uint8_t scaleByGlobalBrightness(uint8_t value) {
+        return colorScale8(value, globalBrightness);
+    }
+    
+public:
+    TimerPWMFacade()
+        : globalBrightness(BRIGHTNESS), dirty(false), committedFrames(0), skippedFrames(0) {
+        for (uint8_t i = 0; i < NUM_LEDS; i++) {
+            channels[i] = { nullptr, nullptr, 0 };
+            pinOutput[i] = 0;
+        }
+    }
+    
+    void begin() {
+        const uint8_t pins[NUM_LEDS] = {
+            LED_PIN_1, LED_PIN_2, LED_PIN_3, LED_PIN_4,
+            #if NUM_LEDS >= 5
+            LED_PIN_5,
+            #endif
+            #if NUM_LEDS >= 6
+            LED_PIN_6,
+            #endif
+        };
+        
+        for (uint8_t i = 0; i < NUM_LEDS; i++) {
+            // PORT bit LOW, so a disconnected channel is off
+            pinMode(pins[i], OUTPUT);
+            digitalWrite(pins[i], LOW);
+            pinOutput[i] = 0;
+            
+            if (!resolveChannel(pins[i], channels[i])) {
+                DEBUG_PRINT("TimerPWM: pin has no timer channel: ");
+                DEBUG_PRINTLN(pins[i]);
+            }
+        }
+        
+        DEBUG_PRINTLN("F5 LED initialized (direct timer PWM)");
+    }
+    
+    void setLED(uint8_t index, uint8_t r, uint8_t g, uint8_t b) {
+        if (index >= NUM_LEDS) return;
+        
+        if (frame.set(index, r, g, b)) {
+            dirty = true;
+        }
+    }
+    
+    void show() {
+        if (!dirty) {
+            skippedFrames++;
+            return;
+        }
+        dirty = false;
+        
+        bool written = false;
+        for (uint8_t i = 0; i < NUM_LEDS; i++) {
+            uint8_t duty = scaleByGlobalBrightness(frame.getMono(i));
+            const PwmChannel &channel = channels[i];
+            if (duty == pinOutput[i] || !channel.ocr) {
+                continue;
+            }
+            
+            // TCCRxA is shared by two channels; keep the read-modify-write
+            // atomic against ISRs that might touch the same timer
+            noInterrupts();
+            if (duty == 0) {
+                *channel.tccr &= ~channel.comMask;
+            } else {
+                *channel.ocr = duty;
+                *channel.tccr |= channel.comMask;
+            }
+            interrupts();
+            
+            pinOutput[i] = duty;
+            written = true;
+        }
+        
+        if (written) {
+            committedFrames++;
+        } else {
+            skippedFrames++;
+        }
+    }
+    
+    void setBrightness(uint8_t brightness) {
+        if (brightness != globalBrightness) {
+            globalBrightness = brightness;
+            dirty = true;
+        }
+    }
+    
+    uint32_t getCommittedFrames() {
+        return committedFrames;
+    }
+    
+    uint32_t getSkippedFrames() {
+        return skippedFrames;
+    }
+};
+
+#endif // TIMER_PWM_FACADE_H
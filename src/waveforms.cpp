@@ -0,0 +1,33 @@
+#include "waveforms.h"
+#include "constexpr_math.h"
+
+// Table entries, evaluated by the compiler (see constexpr_math.h)
+static constexpr uint8_t sineEntry(int i) {
+    return (uint8_t)constexprRound(127.5 + 127.5 * constexprSin(2.0 * CONSTEXPR_PI * i / 256.0));
+}
+
+static constexpr uint8_t easeEntry(int i) {
+    return (uint8_t)constexprRound(127.5 - 127.5 * constexprCos(CONSTEXPR_PI * i / 255.0));
+}
+
+static constexpr uint8_t gammaEntry(int i) {
+    return (uint8_t)constexprRound(255.0 * constexprPow(i / 255.0, 2.2));
+}
+
+// Entries must fold at compile time for the tables to land in flash
+static_assert(sineEntry(64) == 255 && sineEntry(192) == 0, "sine table endpoints");
+static_assert(easeEntry(0) == 0 && easeEntry(255) == 255, "ease table endpoints");
+static_assert(gammaEntry(0) == 0 && gammaEntry(255) == 255, "gamma table endpoints");
+
+// Expand f(0)..f(255) as an initializer list (C++11 has no index_sequence)
+#define WAVE_ENTRIES_4(f, i) f(i), f(i + 1), f(i + 2), f(i + 3)
+#define WAVE_ENTRIES_16(f, i) \
+    WAVE_ENTRIES_4(f, i), WAVE_ENTRIES_4(f, i + 4), WAVE_ENTRIES_4(f, i + 8), WAVE_ENTRIES_4(f, i + 12)
+#define WAVE_ENTRIES_64(f, i) \
+    WAVE_ENTRIES_16(f, i), WAVE_ENTRIES_16(f, i + 16), WAVE_ENTRIES_16(f, i + 32), WAVE_ENTRIES_16(f, i + 48)
+#define WAVE_ENTRIES_256(f) \
+    WAVE_ENTRIES_64(f, 0), WAVE_ENTRIES_64(f, 64), WAVE_ENTRIES_64(f, 128), WAVE_ENTRIES_64(f, 192)
+
+const uint8_t WAVE_SINE_TABLE[256] PROGMEM = { WAVE_ENTRIES_256(sineEntry) };
+const uint8_t WAVE_EASE_TABLE[256] PROGMEM = { WAVE_ENTRIES_256(easeEntry) };
+const uint8_t WAVE_GAMMA_TABLE[256] PROGMEM = { WAVE_ENTRIES_256(gammaEntry) };
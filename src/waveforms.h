@@ -0,0 +1,67 @@
+#ifndef WAVEFORMS_H
+#define WAVEFORMS_H
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include "color_math.h"
+
+// ===== Animation Waveform Tables =====
+// 256-entry 8-bit curves generated at compile time (waveforms.cpp) and
+// kept in flash. An animation curve is one table read plus one multiply:
+// no soft-float trig, no 32-bit division.
+
+extern const uint8_t WAVE_SINE_TABLE[256] PROGMEM;     // 128 + 127.5 sin(2 pi i / 256)
+extern const uint8_t WAVE_EASE_TABLE[256] PROGMEM;     // Cosine ease-in/out, 0 -> 255
+extern const uint8_t WAVE_GAMMA_TABLE[256] PROGMEM;    // Perceptual gamma 2.2
+
+// Sine over one cycle: phase 0-255, result 0-255 (128 at phase 0)
+inline uint8_t waveSine8(uint8_t phase) {
+    return pgm_read_byte(&WAVE_SINE_TABLE[phase]);
+}
+
+// Ease-in/out: t 0-255 -> 0-255 with zero slope at both ends
+inline uint8_t waveEaseInOut8(uint8_t t) {
+    return pgm_read_byte(&WAVE_EASE_TABLE[t]);
+}
+
+// Linear brightness -> PWM duty for a perceptually even ramp
+inline uint8_t waveGamma8(uint8_t value) {
+    return pgm_read_byte(&WAVE_GAMMA_TABLE[value]);
+}
+
+// ===== Fixed-Point Phase =====
+
+// Per-millisecond step of a 24-bit phase accumulator for a cycle of
+// `periodMs`; the top 8 bits of the phase index the tables
+constexpr uint32_t waveCycleStep(double periodMs) {
+    return (uint32_t)(16777216.0 / periodMs + 0.5);
+}
+
+// Table phase `ms` into a cycle. The product may wrap 32 bits; only
+// bits 16-23 are used, so the result stays exact.
+inline uint8_t wavePhase8(unsigned long ms, uint32_t cycleStep) {
+    return (uint8_t)((ms * cycleStep) >> 16);
+}
+
+// Linear 0-255 position through a ramp of DURATION_MS, clamped at 255
+template <unsigned long DURATION_MS>
+inline uint8_t waveRamp8(unsigned long ms) {
+    if (ms >= DURATION_MS) {
+        return 255;
+    }
+    return (uint8_t)((ms * (16777216UL / DURATION_MS)) >> 16);
+}
+
+// Map a 0-255 wave value onto lo..hi (inclusive at both ends)
+inline uint8_t waveScale8(uint8_t value, uint8_t lo, uint8_t hi) {
+    return lo + colorScale8(value, hi - lo);
+}
+
+// Ramp position t for colorLerp8() through the gamma table, anchored at
+// the dimmer end, so a fade takes even steps to the eye where a straight
+// duty ramp rushes through the low levels
+inline uint8_t waveGammaRamp8(uint8_t t, bool rising) {
+    return rising ? waveGamma8(t) : 255 - waveGamma8(255 - t);
+}
+
+#endif // WAVEFORMS_H